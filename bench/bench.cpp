@@ -0,0 +1,181 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "random.h"
+#include "thread_pool.h"
+
+namespace {
+
+constexpr uint64_t kSeed = 20240101;
+
+const char*
+EngineName(const Engine engine) {
+    // clang-format off
+    switch (engine) {
+    case Engine::VIRTUAL:     return "virtual";
+    case Engine::SPECIALIZED: return "specialized";
+    case Engine::BATCH:       return "batch";
+    default: abort();
+    }
+    // clang-format on
+}
+
+// 单线程下一个对局的吞吐量，每次迭代接着上一次的试验序号进行 kTrials 场
+void
+BM_Matchup(benchmark::State& state, const Character c0, const Character c1, const Engine engine) {
+    constexpr uint64_t kTrials = 4096;
+
+    const RangeKernel kernel = GetRangeKernel(c0, c1, engine);
+
+    MatchupResult result;
+    uint64_t begin = 0;
+    for (auto _ : state) {
+        kernel(result, kSeed, begin, begin + kTrials);
+        begin += kTrials;
+    }
+    benchmark::DoNotOptimize(result);
+
+    state.counters["battles_per_second"] = benchmark::Counter(static_cast<double>(begin), benchmark::Counter::kIsRate);
+    state.SetLabel(std::string(GetPlayer(c0)->name) + " vs " + GetPlayer(c1)->name);
+}
+
+// 单个角色一次出招（经虚函数 Attack）的开销，防守方固定为琪亚娜，任一方倒下后双方原地重置
+template <class T>
+void
+BM_Attack(benchmark::State& state) {
+    T attacker;
+    Kiana defender;
+    Player& player = attacker;
+
+    SeedTrial(kSeed, 0, 0);
+
+    int round = 1;
+    for (auto _ : state) {
+        const auto result = player.Attack(round, defender);
+        benchmark::DoNotOptimize(result);
+        if (result != Player::AttackResult::ALL_ALIVE) {
+            attacker = T();
+            defender = Kiana();
+            round    = 0;
+        }
+        ++round;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(attacker.name);
+}
+
+void
+BM_RandomNextBits(benchmark::State& state) {
+    RandomStream stream(kSeed, 0, 0);
+    for (auto _ : state) benchmark::DoNotOptimize(stream.NextBits());
+    state.SetItemsProcessed(state.iterations());
+}
+
+void
+BM_RandomNextFloat(benchmark::State& state) {
+    RandomStream stream(kSeed, 0, 0);
+    for (auto _ : state) benchmark::DoNotOptimize(stream.NextFloat());
+    state.SetItemsProcessed(state.iterations());
+}
+
+void
+BM_RandomNextInt(benchmark::State& state) {
+    RandomStream stream(kSeed, 0, 0);
+    for (auto _ : state) benchmark::DoNotOptimize(stream.NextInt(1, 100));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 角色代码实际使用的路径：线程局部的随机数流加上精确求解脚本的判断
+void
+BM_RandomAtMost(benchmark::State& state) {
+    SeedTrial(kSeed, 0, 0);
+    for (auto _ : state) benchmark::DoNotOptimize(RandomAtMost(0.3f));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 每场试验开始时派生随机数流的开销
+void
+BM_SeedTrial(benchmark::State& state) {
+    uint64_t trial = 0;
+    for (auto _ : state) {
+        SeedTrial(kSeed, 0, trial++);
+        benchmark::DoNotOptimize(g_random_stream);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 以 state.range(0) 个线程完成全部 66 个对局，用真实时间计算吞吐量以反映多核扩展
+void
+BM_Sweep(benchmark::State& state) {
+    constexpr uint64_t kTrials = 1 << 16;
+
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int max_threads = pool.NumThreads();
+    pool.SetNumThreads(static_cast<int>(state.range(0)));
+
+    const std::vector<MatchupTask> tasks = MakeMatchupTasks(kTrials, false);
+
+    uint64_t battles = 0;
+    for (auto _ : state) {
+        for (const auto& result : RunMatchups(tasks, kSeed)) battles += result.Battles();
+    }
+
+    pool.SetNumThreads(max_threads);
+    state.counters["battles_per_second"] = benchmark::Counter(static_cast<double>(battles), benchmark::Counter::kIsRate);
+}
+
+void
+RegisterBenchmarks() {
+    for (const Engine engine : {Engine::VIRTUAL, Engine::SPECIALIZED, Engine::BATCH}) {
+        for (int j = 0; j < kNumOfCharacter; ++j) {
+            for (int i = j + 1; i < kNumOfCharacter; ++i) {
+                const std::string name = std::string("BM_Matchup/") + EngineName(engine) + "/" + std::to_string(j) + "/" + std::to_string(i);
+                benchmark::RegisterBenchmark(name.c_str(), BM_Matchup, static_cast<Character>(j), static_cast<Character>(i), engine);
+            }
+        }
+    }
+
+    benchmark::RegisterBenchmark("BM_Attack/Kiana", BM_Attack<Kiana>);
+    benchmark::RegisterBenchmark("BM_Attack/Mei", BM_Attack<Mei>);
+    benchmark::RegisterBenchmark("BM_Attack/Bronya", BM_Attack<Bronya>);
+    benchmark::RegisterBenchmark("BM_Attack/Himeko", BM_Attack<Himeko>);
+    benchmark::RegisterBenchmark("BM_Attack/Rita", BM_Attack<Rita>);
+    benchmark::RegisterBenchmark("BM_Attack/Sakura", BM_Attack<Sakura>);
+    benchmark::RegisterBenchmark("BM_Attack/Corvus", BM_Attack<Corvus>);
+    benchmark::RegisterBenchmark("BM_Attack/Theresa", BM_Attack<Theresa>);
+    benchmark::RegisterBenchmark("BM_Attack/Olenyeva", BM_Attack<Olenyeva>);
+    benchmark::RegisterBenchmark("BM_Attack/Seele", BM_Attack<Seele>);
+    benchmark::RegisterBenchmark("BM_Attack/Durandal", BM_Attack<Durandal>);
+    benchmark::RegisterBenchmark("BM_Attack/FuHua", BM_Attack<FuHua>);
+
+    benchmark::RegisterBenchmark("BM_RandomNextBits", BM_RandomNextBits);
+    benchmark::RegisterBenchmark("BM_RandomNextFloat", BM_RandomNextFloat);
+    benchmark::RegisterBenchmark("BM_RandomNextInt", BM_RandomNextInt);
+    benchmark::RegisterBenchmark("BM_RandomAtMost", BM_RandomAtMost);
+    benchmark::RegisterBenchmark("BM_SeedTrial", BM_SeedTrial);
+
+    // 1, 2, 4 ... 直到硬件线程数
+    auto* sweep           = benchmark::RegisterBenchmark("BM_Sweep", BM_Sweep);
+    const int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) sweep->Arg(num_threads);
+    sweep->Arg(max_threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    RegisterBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
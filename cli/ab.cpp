@@ -0,0 +1,84 @@
+#include "modes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "player.h"
+
+// 改动了哪些角色的哪些数值
+static void
+PrintTableChanges(const CharacterTable& base, const CharacterTable& patched) {
+    bool any = false;
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        const auto character       = static_cast<Character>(c);
+        const CharacterParams& old = base[character];
+        const CharacterParams& now = patched[character];
+
+        std::string changes;
+        const auto field = [&changes](const char* name, const double from, const double to) {
+            if (from == to) return;
+            char text[96];
+            snprintf(text, sizeof(text), "  %s %g -> %g", name, from, to);
+            changes += text;
+        };
+        field("hit", old.hit, now.hit);
+        field("def", old.def, now.def);
+        field("atk", old.atk, now.atk);
+        field("spd", old.spd, now.spd);
+        field("period", old.period, now.period);
+        field("skill_rate", static_cast<double>(old.skill_rate), static_cast<double>(now.skill_rate));
+        field("damage_taken", static_cast<double>(old.damage_taken), static_cast<double>(now.damage_taken));
+        field("revive_hit", old.revive_hit, now.revive_hit);
+        if (changes.empty()) continue;
+
+        printf("  %s:%s\n", GetPlayer(character)->name, changes.c_str());
+        any = true;
+    }
+    if (!any) printf("  （两张数值表相同）\n");
+}
+
+void
+ABSimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const CharacterTable& patched, const StoppingRule& rule) {
+    const double width = rule.Enabled() ? rule.width : kPairedDefaultWidth;
+    printf("A/B 比较: 共同随机数，%.0f%% 置信区间宽度至多 %.3f%%，每个对局至多 %llu 场\n", rule.confidence * 100., width * 100., static_cast<unsigned long long>(tasks.empty() ? 0 : tasks.front().times));
+    PrintTableChanges(GetCharacterTable(), patched);
+
+    const auto begin                            = std::chrono::steady_clock::now();
+    const std::vector<PairedEstimate> estimates = RunPairedComparison(tasks, seed, patched, rule);
+    const double seconds                        = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t battles = 0;
+    uint64_t pairs   = 0;
+    uint64_t plain   = 0;
+    int unaffected   = 0;
+    int significant  = 0;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const PairedEstimate& estimate = estimates[t];
+        if (!estimate.affected) {
+            ++unaffected;
+            continue;
+        }
+
+        // 两边胜负从未不同时区间只来自方差的下限，倍数没有意义
+        const uint64_t discordant = estimate.counts.discordant[0] + estimate.counts.discordant[1];
+        printf("%s vs %s  %.3f%% -> %.3f%%  差 %+.4f%% [%+.4f%%, %+.4f%%]%s  胜负不同 %.3f%%  %llu 场", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name, estimate.win_rates[0] * 100., estimate.win_rates[1] * 100., estimate.delta * 100., estimate.lower * 100., estimate.upper * 100.,
+               estimate.Significant() ? " *" : "", static_cast<double>(discordant) / static_cast<double>(std::max<uint64_t>(estimate.counts.pairs, 1)) * 100., static_cast<unsigned long long>(estimate.counts.pairs));
+        if (discordant > 0) {
+            printf("  独立抽样约需 %.1f 倍\n", estimate.ReductionFactor());
+            pairs += estimate.counts.pairs;
+            plain += static_cast<uint64_t>(static_cast<double>(estimate.counts.pairs) * estimate.ReductionFactor());
+        } else {
+            printf("  两边逐场相同\n");
+        }
+        battles += estimate.counts.pairs;
+        significant += estimate.Significant() ? 1 : 0;
+    }
+
+    printf("受影响的对局 %zu 个，其中 %d 个的变化显著；其余 %d 个对局双方定义不变，结果逐场相同\n", tasks.size() - static_cast<std::size_t>(unaffected), significant, unaffected);
+    if (pairs > 0) printf("胜负有不同的对局共 %llu 对战斗，两边独立抽样达到同样精度约需 %llu 对\n", static_cast<unsigned long long>(pairs), static_cast<unsigned long long>(plain));
+    printf("用时 %.3f 秒  共 %llu 场  %.0f 场/秒\n", seconds, static_cast<unsigned long long>(2 * battles), static_cast<double>(2 * battles) / seconds);
+}
@@ -0,0 +1,38 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "player.h"
+
+void
+BalanceSimulation(const BalanceOptions& options, const uint64_t seed, const Engine engine, const char* save_path) {
+    const auto begin = std::chrono::steady_clock::now();
+    const auto print_progress = [&](const int generation, const BalanceScore& score, const uint64_t evaluated) {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        printf("第 %3d 代  损失 %.6f  区间内 %2d/%zu  最大偏离 %6.3f%%  已评估 %llu 张数值表（%.0f 张/小时）\n", generation, score.loss, score.in_band, score.win_rates.size(), score.worst * 100., static_cast<unsigned long long>(evaluated), static_cast<double>(evaluated) / seconds * 3600.);
+        fflush(stdout);
+    };
+
+    BalanceScore score;
+    const CharacterTable table = AutoBalance(GetCharacterTable(), options, seed, engine, score, print_progress);
+
+    const std::vector<MatchupTask> tasks = MakeMatchupTasks(options.times, false);
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const double win_rate = score.win_rates[t];
+        printf("%s vs %s: %8.4f%%%s\n", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name, win_rate * 100., win_rate < options.low || win_rate > options.high ? "  *" : "");
+    }
+    WriteCharacterTable(stdout, table);
+
+    if (save_path != nullptr) {
+        FILE* out = fopen(save_path, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "无法写入数值表: %s\n", save_path);
+            return;
+        }
+        WriteCharacterTable(out, table);
+        fclose(out);
+    }
+}
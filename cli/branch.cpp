@@ -0,0 +1,39 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "battle_state.h"
+#include "player.h"
+
+static void
+PrintFighterState(const Character character, const FighterState& state) {
+    printf("    %s: 血量 %d  防御 %d  攻击 %d  命中率 %.0f%%  被控回合 %d  魅惑回合 %d  其它状态 %d\n", GetPlayer(character)->name, state.hit, state.def, state.atk, static_cast<double>(state.hit_rate) * 100., state.buff_opponent, state.buff_charm, state.extra);
+}
+
+void
+BranchSimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const uint64_t trial, const int round) {
+    const auto begin = std::chrono::steady_clock::now();
+    uint64_t battles = 0;
+
+    for (const auto& task : tasks) {
+        BattleState state;
+        if (!SnapshotBattle(task.c0, task.c1, seed, trial, round, state)) {
+            printf("%s vs %s: 第 %llu 号试验在第 %d 回合之前已分出胜负\n", GetPlayer(task.c0)->name, GetPlayer(task.c1)->name, static_cast<unsigned long long>(trial), round);
+            continue;
+        }
+
+        printf("%s vs %s: 第 %llu 号试验第 %d 回合结束时\n", GetPlayer(task.c0)->name, GetPlayer(task.c1)->name, static_cast<unsigned long long>(trial), round);
+        PrintFighterState(task.c0, state.fighters[0]);
+        PrintFighterState(task.c1, state.fighters[1]);
+
+        const MatchupResult result = BranchBattle(state, seed, task.times);
+        PrintMatchupResult(task.c0, task.c1, result);
+        battles += result.Battles();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("用时 %.3f 秒  共续战 %llu 场  %.0f 场/秒\n", seconds, static_cast<unsigned long long>(battles), static_cast<double>(battles) / seconds);
+}
@@ -0,0 +1,23 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "dataset.h"
+
+int
+DatasetSimulation(const char* path, const std::vector<MatchupTask>& tasks, const uint64_t seed, const bool full_matrix, const OutputFormat format, const bool print_stats) {
+    std::vector<MatchupResult> results;
+    const auto begin     = std::chrono::steady_clock::now();
+    const bool ok        = ExportDataset(path, tasks, seed, results);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (!ok) return 1;
+
+    uint64_t battles = 0;
+    for (const auto& result : results) battles += result.Battles();
+    if (format == OutputFormat::TABLE) printf("数据集: %llu 行写入 %s\n", static_cast<unsigned long long>(battles), path);
+    ReportResults(tasks, results, seed, Engine::SPECIALIZED, full_matrix, {}, format, seconds, battles, print_stats);
+    return 0;
+}
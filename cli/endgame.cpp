@@ -0,0 +1,78 @@
+#include "modes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "endgame.h"
+#include "player.h"
+
+int
+EndgameSimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const char* path, const int hit_threshold) {
+    EndgameTables tables(hit_threshold);
+    EndgameBuildStats build;
+
+    const auto build_begin     = std::chrono::steady_clock::now();
+    const bool ok              = tables.Prepare(path, tasks, build);
+    const double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - build_begin).count();
+    if (!ok) return 1;
+    printf("残局表: 双方血量不超过 %d  载入 %d 张  新建 %d 张（枚举 %llu 个局面）  共 %llu 项  用时 %.3f 秒\n", hit_threshold, build.loaded, build.built, static_cast<unsigned long long>(build.states), static_cast<unsigned long long>(build.entries), build_seconds);
+
+    const auto hybrid_begin                 = std::chrono::steady_clock::now();
+    const std::vector<EndgameResult> hybrid = RunMatchupsEndgame(tasks, seed, tables);
+    const double hybrid_seconds             = std::chrono::duration<double>(std::chrono::steady_clock::now() - hybrid_begin).count();
+    const auto full_begin                   = std::chrono::steady_clock::now();
+    const std::vector<MatchupResult> full   = RunMatchups(tasks, seed, Engine::SPECIALIZED);
+    const double full_seconds               = std::chrono::duration<double>(std::chrono::steady_clock::now() - full_begin).count();
+    const std::vector<EndgameResult> paired = RunMatchupsEndgame(tasks, seed, tables, true);
+
+    uint64_t battles          = 0;
+    uint64_t stopped          = 0;
+    uint64_t simulated_rounds = 0;
+    uint64_t full_rounds      = 0;
+    double max_sigma          = 0.;
+    double plain_variance     = 0.;
+    double hybrid_variance    = 0.;
+    printf("%-36s %12s %12s %9s %8s %10s %8s\n", "对局", "混合胜率", "完整胜率", "偏差", "查表", "模拟回合", "VRF");
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const double n         = static_cast<double>(full[t].Battles());
+        const double estimate  = hybrid[t].p0_win / n;
+        const double observed  = static_cast<double>(full[t].p0_win) / n;
+        const double delta     = estimate - observed;
+
+        // 与 EstimatePaired 相同，以逐场之差的样本方差估计标准误，没有差别时取一场不同的方差
+        const double variance  = std::max(1. / n, n > 1. ? (paired[t].p0_diff_sq / n - delta * delta) * n / (n - 1.) : 0.);
+        const double std_error = std::sqrt(variance / n);
+        const double sigma     = delta / std_error;
+        max_sigma              = std::max(max_sigma, std::abs(sigma));
+
+        // 查表的一场计入的是条件胜率而不是 0 或 1，每场的方差更小；VRF 为完整模拟与混合模拟的单场方差之比
+        const double plain     = observed * (1. - observed);
+        const double hybrid_sq = std::max(0., hybrid[t].p0_win_sq / n - estimate * estimate);
+        plain_variance += plain;
+        hybrid_variance += hybrid_sq;
+
+        char matchup[128];
+        snprintf(matchup, sizeof(matchup), "%s vs %s", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name);
+        printf("%-36s %11.4f%% %11.4f%% %+8.2fσ %7.2f%% %9.2f%%", matchup, estimate * 100., observed * 100., sigma, static_cast<double>(hybrid[t].stopped) / n * 100., static_cast<double>(hybrid[t].simulated_rounds) / static_cast<double>(full[t].rounds) * 100.);
+        if (plain > 0. && hybrid_sq > 0.) {
+            printf(" %8.2f\n", plain / hybrid_sq);
+        } else {
+            printf(" %8s\n", "-");
+        }
+
+        battles += full[t].Battles();
+        stopped += hybrid[t].stopped;
+        simulated_rounds += hybrid[t].simulated_rounds;
+        full_rounds += full[t].rounds;
+    }
+
+    // 各对局场次相同，方差之和的比值即所有对局合计达到同样标准误所需场次之比
+    const double reduction = plain_variance > 0. && hybrid_variance > 0. ? plain_variance / hybrid_variance : 1.;
+    printf("共 %llu 场，查表提前结束 %.2f%%，模拟的回合为完整模拟的 %.2f%%  最大偏差 %.2fσ  合计 VRF %.2f\n", static_cast<unsigned long long>(battles), static_cast<double>(stopped) / static_cast<double>(battles) * 100., static_cast<double>(simulated_rounds) / static_cast<double>(full_rounds) * 100., max_sigma, reduction);
+    printf("混合模拟 %.3f 秒  完整模拟 %.3f 秒  同样场次加速 %.2fx  同样精度加速 %.2fx\n", hybrid_seconds, full_seconds, full_seconds / hybrid_seconds, full_seconds / hybrid_seconds * reduction);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "modes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "exact.h"
+#include "player.h"
+
+static void
+PrintExactResult(const Character c0, const Character c1, const ExactResult& result) {
+    printf("%s vs %s:\n    胜率: %10.6f%% / %10.6f%%\n", GetPlayer(c0)->name, GetPlayer(c1)->name, result.p0_win * 100., result.p1_win * 100.);
+    printf("    平均回合: %.3f  平局: %.6f%%  反伤致死: %.6f%%  舍弃概率: %.3g\n", result.rounds, result.draw * 100., result.attacker_dead * 100., result.pruned);
+    printf("    局面数: %llu  转移数: %llu  活跃局面峰值: %llu  内存: %.2f MiB  终止回合: %d\n", static_cast<unsigned long long>(result.states), static_cast<unsigned long long>(result.transitions), static_cast<unsigned long long>(result.peak_active), static_cast<double>(result.bytes) / (1 << 20), result.last_round);
+}
+
+int
+ExactSimulation(const std::vector<MatchupTask>& tasks, const bool full_matrix, const bool check, const uint64_t seed, const Engine engine) {
+    constexpr double kCheckSigma = 5.;
+
+    const auto begin                       = std::chrono::steady_clock::now();
+    const std::vector<ExactResult> results = SolveExactMatchups(tasks);
+    const double seconds                   = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    if (full_matrix) {
+        std::vector<double> win_rates;
+        for (const auto& result : results) win_rates.push_back(result.p0_win);
+        PrintWinRateMatrix(win_rates);
+    } else {
+        for (std::size_t t = 0; t < tasks.size(); ++t) PrintExactResult(tasks[t].c0, tasks[t].c1, results[t]);
+    }
+
+    uint64_t states    = 0;
+    uint64_t max_bytes = 0;
+    double max_pruned  = 0.;
+    for (const auto& result : results) {
+        states += result.states;
+        max_bytes  = std::max(max_bytes, result.bytes);
+        max_pruned = std::max(max_pruned, result.pruned);
+    }
+    printf("精确求解: %zu 个对局  局面数 %llu  单对局内存峰值 %.2f MiB  最大舍弃概率 %.3g  用时 %.3f 秒\n", tasks.size(), static_cast<unsigned long long>(states), static_cast<double>(max_bytes) / (1 << 20), max_pruned, seconds);
+
+    if (!check) return 0;
+
+    // 胜场数服从二项分布，以精确胜率算出标准误；胜率为 0 或 1 时标准误为 0，按离散计数至少允许一场的误差
+    const std::vector<MatchupResult> simulated = RunMatchups(tasks, seed, engine);
+
+    double max_sigma = 0.;
+    printf("%-36s %12s %12s %8s\n", "对局", "精确胜率", "模拟胜率", "偏差");
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const double battles   = static_cast<double>(simulated[t].Battles());
+        const double expected  = results[t].p0_win;
+        const double observed  = static_cast<double>(simulated[t].p0_win) / battles;
+        const double std_error = std::max(std::sqrt(std::max(0., expected * (1. - expected)) / battles), 1. / battles);
+        const double sigma     = (observed - expected) / std_error;
+        max_sigma              = std::max(max_sigma, std::abs(sigma));
+
+        char matchup[128];
+        snprintf(matchup, sizeof(matchup), "%s vs %s", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name);
+        printf("%-36s %11.4f%% %11.4f%% %+7.2fσ\n", matchup, expected * 100., observed * 100., sigma);
+    }
+    printf("最大偏差: %.2fσ\n", max_sigma);
+
+    return max_sigma > kCheckSigma ? 1 : 0;
+}
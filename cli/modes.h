@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "adaptive.h"
+#include "balance.h"
+#include "character_table.h"
+#include "engine.h"
+#include "report.h"
+#include "result_cache.h"
+#include "shard.h"
+#include "tournament.h"
+#include "variance.h"
+
+// 各运行模式的驱动：准备输入、调用库中的实现并输出结果，每种模式一个源文件，由 main 按命令行选择其一
+
+// 选中的对局交给同一个调度器，启用自适应时各任务的 times 为该对局的场次上限；
+// 给出 cache 时只模拟缓存中不足的部分，吞吐量按新模拟的场次计算
+void
+Simulation(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine = Engine::BATCH, bool full_matrix = false, const StoppingRule& rule = {}, OutputFormat format = OutputFormat::TABLE, ResultCache* cache = nullptr, bool print_stats = false);
+
+// 逐场写出数据集，同时照常输出各对局的结果；数据集总由特化引擎产生，与 --engine 无关
+int
+DatasetSimulation(const char* path, const std::vector<MatchupTask>& tasks, uint64_t seed, bool full_matrix, OutputFormat format, bool print_stats);
+
+// 在本机以 processes 个进程分片完成全部对局，分片文件写到 dir 下，可在失败后重新运行以只补跑缺少的分片
+int
+ShardedSimulation(const ShardRun& run, Engine engine, const std::string& dir, int processes, OutputFormat format);
+
+// 只跑 run 中的第 index 个分片并写入 path，不输出结果
+int
+ShardSimulation(const ShardRun& run, Engine engine, int index, const char* path);
+
+// 汇总 --shard 写出的分片文件并照常输出，对局列表与种子都取自分片文件
+int
+MergeSimulation(const std::vector<std::string>& paths, Engine engine, OutputFormat format);
+
+// 以精确解代替蒙特卡洛输出；check 时再用蒙特卡洛引擎跑同样的对局，以精确解为基准检查偏差是否在统计误差之内，
+// 超出 kCheckSigma 倍标准误时返回非 0
+int
+ExactSimulation(const std::vector<MatchupTask>& tasks, bool full_matrix, bool check, uint64_t seed, Engine engine = Engine::BATCH);
+
+// 分别以 1, 2, 4 ... N 个线程跑完全部对局，输出吞吐量以检查多核扩展是否接近线性；times 至少为 1
+void
+ScalingReport(uint64_t times, uint64_t seed, Engine engine = Engine::BATCH);
+
+// 从当前数值表出发自动平衡，输出每代的进度、最终数值表下各对局的胜率和数值表本身
+void
+BalanceSimulation(const BalanceOptions& options, uint64_t seed, Engine engine, const char* save_path);
+
+// 赛事的每场比赛和最终排名；Bradley–Terry 评分由所有战斗得出，Elo 评分按比赛顺序逐场更新
+void
+TournamentSimulation(const TournamentOptions& options, uint64_t seed, Engine engine);
+
+// 竞速找出前 k 名，并与每个对局都跑满 max_battles 场所需的场次比较
+void
+RaceSimulation(const RaceOptions& options, uint64_t seed, Engine engine);
+
+// 各对局的方差缩减估计，与相同场次的普通蒙特卡洛比较标准误；ESS 为达到同样精度所需的普通蒙特卡洛场次
+void
+VarianceSimulation(const std::vector<MatchupTask>& tasks, uint64_t seed, const VarianceOptions& options);
+
+// 成对比较改动前后的胜率：只模拟涉及改动角色的对局，区间不含 0 的变化标记为 *
+void
+ABSimulation(const std::vector<MatchupTask>& tasks, uint64_t seed, const CharacterTable& patched, const StoppingRule& rule);
+
+// 以残局表加速的混合模拟：先载入或新建残局表，再以同一种子分别进行混合模拟和完整的特化引擎模拟，输出两者的胜率之差与加速比。
+// 两边的同号试验在查表之前完全相同，偏差以逐场之差的配对标准误为单位：另以配对模式把查表的场次续战到底，不计入用时
+int
+EndgameSimulation(const std::vector<MatchupTask>& tasks, uint64_t seed, const char* path, int hit_threshold);
+
+// 各对局的第 trial 号试验进行到第 round 回合结束时拍下局面，再从该局面续战 branches 场
+void
+BranchSimulation(const std::vector<MatchupTask>& tasks, uint64_t seed, uint64_t trial, int round);
+
+// 以虚函数参考实现为基准检查特化与批量引擎，任何一项不通过时返回非 0
+int
+VerifySimulation(const std::vector<MatchupTask>& tasks, uint64_t seed);
+
+// 每个对局在调用线程上串行运行，输出每场的硬件计数，再按出招方输出每次出招的开销
+void
+ProfileSimulation(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine);
@@ -0,0 +1,86 @@
+#include "modes.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "player.h"
+#include "profile.h"
+
+// 计数器不可用时显示 -
+static void
+PrintPerUnit(const ProfileReport& report, const ProfileCounts& counts, const uint64_t units, const bool per_turn) {
+    const bool* usable = per_turn ? report.per_turn : report.available;
+    const auto value   = [&](const PerfCounter counter) { return static_cast<double>(counts.value[static_cast<int>(counter)]); };
+    const auto column  = [&](const PerfCounter counter) {
+        if (usable[static_cast<int>(counter)] && units > 0) {
+            printf(" %12.1f", value(counter) / static_cast<double>(units));
+        } else {
+            printf(" %12s", "-");
+        }
+    };
+
+    column(PerfCounter::CYCLES);
+    column(PerfCounter::INSTRUCTIONS);
+    if (usable[static_cast<int>(PerfCounter::CYCLES)] && usable[static_cast<int>(PerfCounter::INSTRUCTIONS)] && value(PerfCounter::CYCLES) > 0.) {
+        printf(" %6.2f", value(PerfCounter::INSTRUCTIONS) / value(PerfCounter::CYCLES));
+    } else {
+        printf(" %6s", "-");
+    }
+    column(PerfCounter::BRANCH_MISSES);
+    column(PerfCounter::CACHE_MISSES);
+}
+
+void
+ProfileSimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine) {
+    const ProfileReport report = ProfileMatchups(tasks, seed, engine);
+
+    printf("性能剖析: %s 引擎，单线程\n", EngineName(engine));
+    if (!report.unavailable.empty()) printf("不可用的计数器: %s\n", report.unavailable.c_str());
+
+    std::string multiplexed;
+    for (int i = 0; i < kNumOfPerfCounter; ++i) {
+        if (!report.multiplexed[i]) continue;
+        if (!multiplexed.empty()) multiplexed += "，";
+        multiplexed += PerfCounterName(static_cast<PerfCounter>(i));
+    }
+    if (!multiplexed.empty()) printf("分时复用的计数器（已按运行时间外推，不按出招拆分）: %s\n", multiplexed.c_str());
+
+    const bool task_clock = report.available[static_cast<int>(PerfCounter::TASK_CLOCK)];
+    printf("%-36s %9s %10s %12s %12s %6s %12s %12s\n", "对局", "p0 胜率", "纳秒/场", "周期/场", "指令/场", "IPC", "分支失误/场", "缓存失误/场");
+
+    ProfileCounts total;
+    uint64_t battles = 0;
+    double seconds   = 0.;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupProfile& profile = report.matchups[t];
+        const uint64_t n              = profile.result.Battles();
+        const double nanoseconds      = task_clock ? static_cast<double>(profile.counts.value[static_cast<int>(PerfCounter::TASK_CLOCK)]) : profile.seconds * 1e9;
+
+        char matchup[128];
+        snprintf(matchup, sizeof(matchup), "%s vs %s", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name);
+        printf("%-36s %8.3f%% %10.1f", matchup, static_cast<double>(profile.result.p0_win) / static_cast<double>(n) * 100., nanoseconds / static_cast<double>(n));
+        PrintPerUnit(report, profile.counts, n, false);
+        printf("\n");
+
+        total += profile.counts;
+        battles += n;
+        seconds += profile.seconds;
+    }
+    printf("%-36s %9s %10.1f", "合计", "", (task_clock ? static_cast<double>(total.value[static_cast<int>(PerfCounter::TASK_CLOCK)]) : seconds * 1e9) / static_cast<double>(battles));
+    PrintPerUnit(report, total, battles, false);
+    printf("\n\n");
+
+    // 逐次出招只能在用户态读取，rdpmc 不可用的计数器只给出时间戳
+    char ticks_column[64];
+    snprintf(ticks_column, sizeof(ticks_column), "%s/次", report.ticks_unit);
+    printf("%-24s %12s %12s %12s %12s %6s %12s %12s\n", "出招方", "出招次数", ticks_column, "周期/次", "指令/次", "IPC", "分支失误/次", "缓存失误/次");
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        const uint64_t turns = report.turns.turns[c];
+        if (turns == 0) continue;
+        printf("%-24s %12llu %12.1f", GetPlayer(static_cast<Character>(c))->name, static_cast<unsigned long long>(turns), static_cast<double>(report.turns.counts[c].ticks) / static_cast<double>(turns));
+        PrintPerUnit(report, report.turns.counts[c], turns, true);
+        printf("\n");
+    }
+}
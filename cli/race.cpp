@@ -0,0 +1,24 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "player.h"
+
+void
+RaceSimulation(const RaceOptions& options, const uint64_t seed, const Engine engine) {
+    const auto begin       = std::chrono::steady_clock::now();
+    const RaceResult race  = RaceTopK(options, seed, engine);
+    const double seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const auto full_matrix = static_cast<double>(options.max_battles) * static_cast<double>(race.results.size());
+
+    printf("名次  %-12s %9s %9s  角色\n", "Copeland", "平均胜率", "BT");
+    for (std::size_t r = 0; r < race.standings.size(); ++r) {
+        const RaceStanding& standing = race.standings[r];
+        const char* status           = standing.status > 0 ? "前列" : standing.status < 0 ? "" : "?";
+        printf("%4zu  %5.1f ~ %-4.1f %8.3f%% %9.1f  %s  %s\n", r + 1, standing.copeland_lower, standing.copeland_upper, standing.battle_score * 100., standing.bradley_terry, GetPlayer(standing.character)->name, status);
+    }
+    printf("竞速: %d 轮  已确定 %d/%zu 个对局  共 %llu 场，为完整矩阵的 %.4f%%  整体置信水平 %g%%（每次判定 %.6f%%）\n", race.passes, race.settled_pairs, race.results.size(), static_cast<unsigned long long>(race.battles), static_cast<double>(race.battles) / full_matrix * 100., options.rule.confidence * 100., race.look_confidence * 100.);
+    printf("用时 %.3f 秒  %.0f 场/秒\n", seconds, static_cast<double>(race.battles) / seconds);
+}
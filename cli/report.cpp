@@ -0,0 +1,154 @@
+#include "report.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "character_table.h"
+#include "player.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+void
+PrintMatchupResult(const Character c0, const Character c1, const MatchupResult& result) {
+    const double battles = static_cast<double>(result.Battles());
+    printf("%s vs %s:\n    胜率: %8.4f%% / %8.4f%%\n", GetPlayer(c0)->name, GetPlayer(c1)->name, static_cast<double>(result.p0_win) / battles * 100., static_cast<double>(result.p1_win) / battles * 100.);
+    printf("    平均回合: %.3f  平局: %llu  反伤致死: %llu\n", static_cast<double>(result.rounds) / battles, static_cast<unsigned long long>(result.draw), static_cast<unsigned long long>(result.attacker_dead));
+#if defined(ENABLE_ALLOC_COUNTER) && (ENABLE_ALLOC_COUNTER == 1)
+    printf("    试验循环堆分配次数: %llu\n", static_cast<unsigned long long>(result.alloc_count));
+#endif
+}
+
+static void
+PrintConfidenceInterval(const MatchupResult& result, const StoppingRule& rule) {
+    const auto [lower, upper] = ConfidenceInterval(result.p0_win, result.Battles(), rule);
+    printf("    %g%% 置信区间 (%s): [%8.4f%%, %8.4f%%]  宽度: %.4f%%  试验次数: %llu\n", rule.confidence * 100., rule.interval == Interval::WILSON ? "Wilson" : "Clopper-Pearson", lower * 100., upper * 100., (upper - lower) * 100., static_cast<unsigned long long>(result.Battles()));
+}
+
+const char*
+EngineName(const Engine engine) {
+    // clang-format off
+    switch (engine) {
+    case Engine::VIRTUAL:     return "virtual";
+    case Engine::SPECIALIZED: return "specialized";
+    case Engine::BATCH:       return "batch";
+    default: abort();
+    }
+    // clang-format on
+}
+
+static void
+WriteCsvResults(const std::vector<MatchupTask>& tasks, const std::vector<MatchupResult>& results, const StoppingRule& rule) {
+    printf("c0,c1,battles,p0_win,p1_win,draw,attacker_dead,p0_win_rate,average_rounds%s\n", rule.Enabled() ? ",ci_lower,ci_upper" : "");
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupResult& result = results[t];
+        const double battles        = static_cast<double>(result.Battles());
+        printf("%s,%s,%llu,%llu,%llu,%llu,%llu,%.8f,%.6f", CharacterKey(tasks[t].c0), CharacterKey(tasks[t].c1), static_cast<unsigned long long>(result.Battles()), static_cast<unsigned long long>(result.p0_win), static_cast<unsigned long long>(result.p1_win), static_cast<unsigned long long>(result.draw), static_cast<unsigned long long>(result.attacker_dead), static_cast<double>(result.p0_win) / battles, static_cast<double>(result.rounds) / battles);
+        if (rule.Enabled()) {
+            const auto [lower, upper] = ConfidenceInterval(result.p0_win, result.Battles(), rule);
+            printf(",%.8f,%.8f", lower, upper);
+        }
+        printf("\n");
+    }
+}
+
+static void
+WriteJsonResults(const std::vector<MatchupTask>& tasks, const std::vector<MatchupResult>& results, const StoppingRule& rule, const uint64_t seed, const Engine engine, const double seconds, const uint64_t battles) {
+    printf("{\n  \"seed\": %llu,\n  \"engine\": \"%s\",\n  \"threads\": %d,\n", static_cast<unsigned long long>(seed), EngineName(engine), ThreadPool::Instance().NumThreads());
+    printf("  \"seconds\": %.6f,\n  \"battles\": %llu,\n  \"battles_per_second\": %.0f,\n  \"matchups\": [", seconds, static_cast<unsigned long long>(battles), static_cast<double>(battles) / seconds);
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupResult& result = results[t];
+        const double num_battles    = static_cast<double>(result.Battles());
+        printf("%s\n    {\"c0\": \"%s\", \"c1\": \"%s\", \"battles\": %llu, \"p0_win\": %llu, \"p1_win\": %llu, \"draw\": %llu, \"attacker_dead\": %llu, \"p0_win_rate\": %.8f, \"average_rounds\": %.6f", t == 0 ? "" : ",", CharacterKey(tasks[t].c0), CharacterKey(tasks[t].c1), static_cast<unsigned long long>(result.Battles()), static_cast<unsigned long long>(result.p0_win), static_cast<unsigned long long>(result.p1_win), static_cast<unsigned long long>(result.draw), static_cast<unsigned long long>(result.attacker_dead), static_cast<double>(result.p0_win) / num_battles, static_cast<double>(result.rounds) / num_battles);
+        if (rule.Enabled()) {
+            const auto [lower, upper] = ConfidenceInterval(result.p0_win, result.Battles(), rule);
+            printf(", \"ci_lower\": %.8f, \"ci_upper\": %.8f", lower, upper);
+        }
+        printf("}");
+    }
+    printf("\n  ]\n}\n");
+}
+
+void
+PrintWinRateMatrix(const std::vector<double>& win_rates) {
+    printf("%-4s", "");
+    for (int i = 0; i < kNumOfCharacter; ++i) printf("%9d", i);
+    printf("\n");
+    for (int j = 0; j < kNumOfCharacter; ++j) {
+        printf("%-4d", j);
+        for (int i = 0; i < kNumOfCharacter; ++i) printf("%8.3f%%", win_rates[static_cast<std::size_t>(j * kNumOfCharacter + i)] * 100.);
+        printf("  %s\n", GetPlayer(static_cast<Character>(j))->name);
+    }
+}
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+// 汇总所有对局的事件计数和直方图；事件按角色每参战一场的平均次数输出
+static void
+PrintBattleStats(const std::vector<MatchupTask>& tasks, const std::vector<MatchupResult>& results) {
+    BattleStats stats;
+    uint64_t appearances[kNumOfCharacter] = {};
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        stats += results[t].stats;
+        appearances[static_cast<int>(tasks[t].c0)] += results[t].Battles();
+        appearances[static_cast<int>(tasks[t].c1)] += results[t].Battles();
+    }
+
+    printf("每场平均事件次数:\n    %s\n", "     必杀     普攻   未命中     眩晕     麻痹     魅惑     复活     反弹");
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        if (appearances[c] == 0) continue;
+        printf("%-4d", c);
+        for (int e = 0; e < kNumOfStatEvent; ++e) printf("%9.3f", static_cast<double>(stats.events[c][e]) / static_cast<double>(appearances[c]));
+        printf("  %s\n", GetPlayer(static_cast<Character>(c))->name);
+    }
+
+    const auto print_quantiles = [](const char* title, const uint64_t* histogram, const int size) {
+        printf("%s: p10 %d  p50 %d  p90 %d  p99 %d", title, HistogramQuantile(histogram, size, 0.1), HistogramQuantile(histogram, size, 0.5), HistogramQuantile(histogram, size, 0.9), HistogramQuantile(histogram, size, 0.99));
+        for (int i = size - 1; i >= 0; --i) {
+            if (histogram[i] == 0) continue;
+            printf("  最大 %d\n", i);
+            return;
+        }
+        printf("\n");
+    };
+
+    print_quantiles("结束回合", stats.rounds, kRoundHistogramSize);
+    if (stats.rounds[kRoundHistogramSize - 1] != 0) printf("    超过 %d 回合（含平局）: %llu 场\n", kRoundHistogramSize - 2, static_cast<unsigned long long>(stats.rounds[kRoundHistogramSize - 1]));
+
+    uint64_t winner_hit[kHitHistogramSize] = {};
+    for (int h = 0; h < kHitHistogramSize; ++h) winner_hit[h] = stats.winner_hit[0][h] + stats.winner_hit[1][h];
+    print_quantiles("胜方剩余血量", winner_hit, kHitHistogramSize);
+}
+#endif
+
+void
+ReportResults(const std::vector<MatchupTask>& tasks, const std::vector<MatchupResult>& results, const uint64_t seed, const Engine engine, const bool full_matrix, const StoppingRule& rule, const OutputFormat format, const double seconds, const uint64_t battles, [[maybe_unused]] const bool print_stats) {
+    if (format == OutputFormat::JSON) {
+        WriteJsonResults(tasks, results, rule, seed, engine, seconds, battles);
+        return;
+    }
+
+    // CSV 的 stdout 只留给数据，运行信息写到 stderr
+    if (format == OutputFormat::CSV) {
+        WriteCsvResults(tasks, results, rule);
+        fprintf(stderr, "随机种子: %llu  用时 %.3f 秒  共 %llu 场  %.0f 场/秒\n", static_cast<unsigned long long>(seed), seconds, static_cast<unsigned long long>(battles), static_cast<double>(battles) / seconds);
+        return;
+    }
+
+    if (!full_matrix) {
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            PrintMatchupResult(tasks[t].c0, tasks[t].c1, results[t]);
+            if (rule.Enabled()) PrintConfidenceInterval(results[t], rule);
+        }
+    } else {
+        std::vector<double> win_rates;
+        for (const auto& result : results) win_rates.push_back(static_cast<double>(result.p0_win) / static_cast<double>(result.Battles()));
+        PrintWinRateMatrix(win_rates);
+    }
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    if (print_stats) PrintBattleStats(tasks, results);
+#endif
+
+    printf("用时 %.3f 秒  共 %llu 场  %.0f 场/秒\n", seconds, static_cast<unsigned long long>(battles), static_cast<double>(battles) / seconds);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "adaptive.h"
+#include "engine.h"
+
+enum class OutputFormat {
+    TABLE,  // 供人阅读的文字
+    CSV,    // 每个对局一行，第一行为表头
+    JSON,   // 一个对象，运行信息之外 matchups 数组中每个对局一项
+};
+
+const char*
+EngineName(Engine engine);
+
+void
+PrintMatchupResult(Character c0, Character c1, const MatchupResult& result);
+
+// 第 j 行第 i 列为 j 号角色对 i 号角色的胜率，win_rates 按行排列
+void
+PrintWinRateMatrix(const std::vector<double>& win_rates);
+
+// 按 format 输出各对局的结果；battles 为本次实际模拟的场次，用于计算吞吐量
+void
+ReportResults(const std::vector<MatchupTask>& tasks, const std::vector<MatchupResult>& results, uint64_t seed, Engine engine, bool full_matrix, const StoppingRule& rule, OutputFormat format, double seconds, uint64_t battles, bool print_stats = false);
@@ -0,0 +1,43 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "thread_pool.h"
+
+void
+ScalingReport(const uint64_t times, const uint64_t seed, const Engine engine) {
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int max_threads = pool.NumThreads();
+
+    std::vector<int> thread_counts;
+    for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) thread_counts.push_back(num_threads);
+    thread_counts.push_back(max_threads);
+
+    std::vector<MatchupTask> tasks;
+    for (int j = 0; j < kNumOfCharacter; ++j) {
+        for (int i = j + 1; i < kNumOfCharacter; ++i) tasks.push_back({static_cast<Character>(j), static_cast<Character>(i), times});
+    }
+
+    printf("线程数      场次/秒    加速比    并行效率\n");
+
+    double base_rate = 0.;
+    for (const int num_threads : thread_counts) {
+        pool.SetNumThreads(num_threads);
+
+        const auto begin = std::chrono::steady_clock::now();
+
+        uint64_t battles = 0;
+        for (const auto& result : RunMatchups(tasks, seed, engine)) battles += result.Battles();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const double rate    = static_cast<double>(battles) / seconds;
+        if (num_threads == 1) base_rate = rate;
+
+        printf("%6d %14.0f %8.2fx %10.1f%%\n", num_threads, rate, rate / base_rate, rate / base_rate / num_threads * 100.);
+    }
+
+    pool.SetNumThreads(max_threads);
+}
@@ -0,0 +1,53 @@
+#include "modes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+int
+ShardedSimulation(const ShardRun& run, const Engine engine, const std::string& dir, const int processes, const OutputFormat format) {
+    const int threads = std::max(1, ThreadPool::Instance().NumThreads() / processes);
+
+    std::vector<MatchupResult> results;
+    const auto begin     = std::chrono::steady_clock::now();
+    const bool ok        = RunShardsLocally(run, engine, dir, threads, results);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (!ok) return 1;
+
+    uint64_t battles = 0;
+    for (const auto& result : results) battles += result.Battles();
+    if (format == OutputFormat::TABLE) printf("分片: %d 个进程，每个 %d 线程，分片文件位于 %s\n", processes, threads, dir.c_str());
+    ReportResults(run.tasks, results, run.seed, engine, run.full_matrix, {}, format, seconds, battles);
+    return 0;
+}
+
+int
+ShardSimulation(const ShardRun& run, const Engine engine, const int index, const char* path) {
+    const auto begin                         = std::chrono::steady_clock::now();
+    const std::vector<MatchupResult> results = RunMatchups(ShardTasks(run.tasks, index, run.count), run.seed, engine);
+    const double seconds                     = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (!WriteShardFile(path, run, index, results, seconds)) {
+        fprintf(stderr, "无法写入分片文件: %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+int
+MergeSimulation(const std::vector<std::string>& paths, const Engine engine, const OutputFormat format) {
+    ShardRun run;
+    std::vector<MatchupResult> results;
+    double seconds = 0.;
+    if (!MergeShardFiles(paths, run, results, seconds)) return 1;
+
+    uint64_t battles = 0;
+    for (const auto& result : results) battles += result.Battles();
+    if (format == OutputFormat::TABLE) printf("随机种子: %llu\n合并 %d 个分片，用时取最慢的分片\n", static_cast<unsigned long long>(run.seed), run.count);
+    ReportResults(run.tasks, results, run.seed, engine, run.full_matrix, {}, format, seconds, battles);
+    return 0;
+}
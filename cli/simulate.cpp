@@ -0,0 +1,30 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+void
+Simulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine, const bool full_matrix, const StoppingRule& rule, const OutputFormat format, ResultCache* cache, const bool print_stats) {
+    CachedRunStats cache_stats;
+
+    const auto begin                         = std::chrono::steady_clock::now();
+    const std::vector<MatchupResult> results = cache != nullptr ? RunMatchupsCached(tasks, seed, engine, *cache, cache_stats) : rule.Enabled() ? RunMatchupsAdaptive(tasks, seed, engine, rule) : RunMatchups(tasks, seed, engine);
+    const double seconds                     = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t battles     = 0;
+    uint64_t max_battles = 0;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        battles += results[t].Battles();
+        max_battles += tasks[t].times;
+    }
+    if (cache != nullptr) battles = cache_stats.simulated_battles;
+
+    if (format == OutputFormat::TABLE) {
+        if (cache != nullptr) printf("结果缓存: %d/%zu 个对局无需模拟  复用 %llu 场  新模拟 %llu 场  缓存共 %zu 项\n", cache_stats.reused_matchups, tasks.size(), static_cast<unsigned long long>(cache_stats.cached_battles), static_cast<unsigned long long>(cache_stats.simulated_battles), cache->Size());
+        if (rule.Enabled()) printf("自适应试验: 共 %llu 场，为固定场次的 %.2f%%\n", static_cast<unsigned long long>(battles), static_cast<double>(battles) / static_cast<double>(max_battles) * 100.);
+    }
+
+    ReportResults(tasks, results, seed, engine, full_matrix, rule, format, seconds, battles, print_stats);
+}
@@ -0,0 +1,28 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "player.h"
+
+void
+TournamentSimulation(const TournamentOptions& options, const uint64_t seed, const Engine engine) {
+    const auto begin              = std::chrono::steady_clock::now();
+    const TournamentResult result = RunTournament(options, seed, engine);
+    const double seconds          = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 单循环的 66 场比赛不逐场列出
+    if (options.format != TournamentFormat::ROUND_ROBIN) {
+        for (const MatchRecord& match : result.matches) {
+            printf("第 %d 轮  %s vs %s  %llu : %llu（平 %llu）  %s\n", match.round, GetPlayer(match.a)->name, GetPlayer(match.b)->name, static_cast<unsigned long long>(match.a_win), static_cast<unsigned long long>(match.b_win), static_cast<unsigned long long>(match.draw), match.score == 1. ? "胜" : match.score == 0. ? "负" : "平");
+        }
+    }
+
+    printf("名次  %6s %9s %9s %9s  角色\n", "积分", "战斗得分", "BT", "Elo");
+    for (std::size_t r = 0; r < result.standings.size(); ++r) {
+        const Standing& standing = result.standings[r];
+        printf("%4zu  %6.1f %8.3f%% %9.1f %9.1f  %s\n", r + 1, standing.points, standing.battle_score * 100., standing.bradley_terry, standing.elo, GetPlayer(standing.character)->name);
+    }
+    printf("用时 %.3f 秒  共 %llu 场  %.0f 场/秒\n", seconds, static_cast<unsigned long long>(result.battles), static_cast<double>(result.battles) / seconds);
+}
@@ -0,0 +1,41 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "player.h"
+
+void
+VarianceSimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed, const VarianceOptions& options) {
+    std::string methods;
+    if (options.antithetic) methods += " 对偶变量";
+    if (options.qmc_dims > 0) methods += " Sobol 前 " + std::to_string(options.qmc_dims) + " 次抽取";
+    if (options.variant != nullptr) methods += " 共同随机数";
+    printf("方差缩减:%s\n", methods.empty() ? " 无" : methods.c_str());
+
+    const auto begin                              = std::chrono::steady_clock::now();
+    const std::vector<VarianceEstimate> estimates = RunVarianceReduced(tasks, seed, options);
+    const double seconds                          = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const bool crn                                = options.variant != nullptr;
+
+    uint64_t battles    = 0;
+    double plain_sum_sq = 0.;
+    double sum_sq       = 0.;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const VarianceEstimate& estimate = estimates[t];
+        printf(crn ? "%s vs %s  胜率之差 %+.4f%% ± %.4f%%  普通 ± %.4f%%  VRF %.2f  ESS %.0f" : "%s vs %s  p0 胜率 %.4f%% ± %.4f%%  普通 ± %.4f%%  VRF %.2f  ESS %.0f", GetPlayer(tasks[t].c0)->name, GetPlayer(tasks[t].c1)->name, estimate.estimate * 100., estimate.std_error * 100., estimate.plain_std_error * 100., estimate.ReductionFactor(), estimate.EffectiveSampleSize());
+        if (crn) printf("  (%.3f%% -> %.3f%%)", estimate.win_rates[0] * 100., estimate.win_rates[1] * 100.);
+        printf("\n");
+
+        battles += estimate.battles * (crn ? 2 : 1);
+        plain_sum_sq += estimate.plain_std_error * estimate.plain_std_error;
+        sum_sq += estimate.std_error * estimate.std_error;
+    }
+
+    // 各对局场次相同，方差之和的比值即所有对局合计所需场次之比
+    if (sum_sq > 0.) printf("合计 VRF %.2f：所有对局达到同样标准误，普通蒙特卡洛约需 %.2f 倍场次\n", plain_sum_sq / sum_sq, plain_sum_sq / sum_sq);
+    printf("用时 %.3f 秒  共 %llu 场  %.0f 场/秒\n", seconds, static_cast<unsigned long long>(battles), static_cast<double>(battles) / seconds);
+}
@@ -0,0 +1,25 @@
+#include "modes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "verify.h"
+
+int
+VerifySimulation(const std::vector<MatchupTask>& tasks, const uint64_t seed) {
+    const auto begin          = std::chrono::steady_clock::now();
+    const VerifyReport report = VerifyEngines(tasks, seed);
+    const double seconds      = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    printf("脚本化出招: %llu 个局面  %llu 个随机分支  不一致 %zu 处\n", static_cast<unsigned long long>(report.scripted_positions), static_cast<unsigned long long>(report.scripted_branches), report.scripted_failures.size());
+    for (const auto& failure : report.scripted_failures) printf("    %s\n", failure.c_str());
+
+    for (const auto& engine : report.engines) {
+        printf("%-12s 同种子不一致 %llu/%zu 个对局  %s\n", EngineName(engine.engine), static_cast<unsigned long long>(engine.mismatched), tasks.size(), engine.Passed() ? "通过" : "不通过");
+    }
+
+    printf("%s  用时 %.3f 秒\n", report.Passed() ? "全部通过" : "存在不一致", seconds);
+    return report.Passed() ? 0 : 1;
+}
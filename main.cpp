@@ -1,645 +1,600 @@
-#include <atomic>
-#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <random>
-#include <thread>
-#include <utility>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "adaptive.h"
+#include "balance.h"
+#include "character_table.h"
+#include "config.h"
+#include "endgame.h"
+#include "engine.h"
+#include "modes.h"
+#include "profile.h"
+#include "result_cache.h"
+#include "server.h"
+#include "shard.h"
+#include "thread_pool.h"
+#include "tournament.h"
+#include "trace.h"
+#include "variance.h"
+#include "verify.h"
+
+// 运行模式：不指定时为对局模拟，其余的模式至多选择一种，在解析参数时设置
+enum class RunMode {
+    SIMULATE,
+    EXACT,       // --exact / --check
+    SCALING,
+    BALANCE,
+    TOURNAMENT,
+    RACE,
+    VARIANCE,    // --variance / --antithetic / --qmc / --crn
+    AB,          // --ab / --patch
+    ENDGAME,
+    BRANCH,
+    VERIFY,
+    PROFILE,
+    DATASET,
+    SERVE,
+    PROCESSES,
+    SHARD,
+    MERGE,
+};
 
-#define ENABLE_LOG 0
+// 修饰运行方式的选项，按位组合；各运行模式只接受用得到的选项
+enum RunOption : uint32_t {
+    OPTION_MATRIX   = 1u << 0,
+    OPTION_SELECT   = 1u << 1,
+    OPTION_FORMAT   = 1u << 2,
+    OPTION_STATS    = 1u << 3,
+    OPTION_TRACE    = 1u << 4,
+    OPTION_CACHE    = 1u << 5,
+    OPTION_CI_WIDTH = 1u << 6,
+};
 
-#if defined(ENABLE_LOG) && (ENABLE_LOG == 1)
-#    define LOG(fmt, ...) printf(fmt, __VA_ARGS__)
-#else
-#    define LOG(fmt, ...)
-#endif
+constexpr const char* kRunOptionNames[] = {"--matrix", "--matchup / --character", "--format", "--stats", "--trace", "--cache", "--ci-width"};
 
-static float
-GetRandom() {
-    static thread_local std::mt19937 re(std::random_device{}());
-    static thread_local std::uniform_real_distribution<float> rnd(0.f, 1.f);
-    return rnd(re);
+static uint32_t
+AcceptedOptions(const RunMode mode) {
+    // clang-format off
+    switch (mode) {
+    case RunMode::SIMULATE:   return OPTION_MATRIX | OPTION_SELECT | OPTION_FORMAT | OPTION_STATS | OPTION_TRACE | OPTION_CACHE | OPTION_CI_WIDTH;
+    case RunMode::EXACT:      return OPTION_MATRIX | OPTION_SELECT;                    // 精确解不掷骰子，没有可记录的试验
+    case RunMode::SCALING:    return OPTION_TRACE;                                     // 总是跑全部对局，只有文字输出
+    case RunMode::BALANCE:    return OPTION_TRACE;
+    case RunMode::TOURNAMENT: return OPTION_TRACE;
+    case RunMode::RACE:       return OPTION_TRACE;
+    case RunMode::VARIANCE:   return OPTION_MATRIX | OPTION_SELECT;                    // 逐场比较胜负，只输出胜率的估计
+    case RunMode::AB:         return OPTION_MATRIX | OPTION_SELECT | OPTION_CI_WIDTH;  // 以 --ci-width / --confidence 为目标精度
+    case RunMode::ENDGAME:    return OPTION_MATRIX | OPTION_SELECT;                    // 只输出与完整模拟比较的胜率、偏差与用时
+    case RunMode::BRANCH:     return OPTION_MATRIX | OPTION_SELECT;                    // 只输出从快照出发的胜负
+    case RunMode::VERIFY:     return OPTION_MATRIX | OPTION_SELECT;                    // 自行决定种子的使用方式，只输出检查结论
+    case RunMode::PROFILE:    return OPTION_MATRIX | OPTION_SELECT;                    // 在调用线程上逐个对局进行，只输出计数器的读数
+    case RunMode::DATASET:    return OPTION_MATRIX | OPTION_SELECT | OPTION_FORMAT | OPTION_STATS;
+    case RunMode::SERVE:      return OPTION_CACHE | OPTION_CI_WIDTH;                   // 对局由查询决定，--ci-width 为默认的目标精度
+    case RunMode::PROCESSES:  return OPTION_MATRIX | OPTION_SELECT | OPTION_FORMAT;    // 分片只保存胜负计数
+    case RunMode::SHARD:      return OPTION_MATRIX | OPTION_SELECT;
+    case RunMode::MERGE:      return OPTION_FORMAT;                                    // 对局列表与种子都取自分片文件
+    default: abort();
+    }
+    // clang-format on
 }
 
-static int
-GetRandom(const int min_value, const int max_value) {
-    static thread_local std::mt19937 re(std::random_device{}());
-    return std::uniform_int_distribution<int>{min_value, max_value}(re);
+// 选择运行模式，mode_option 记下最先选择该模式的选项；已选择了另一种模式时在 stderr 说明冲突并返回 false
+static bool
+SelectRunMode(RunMode& mode, const char*& mode_option, const RunMode value, const char* option) {
+    if (mode != RunMode::SIMULATE && mode != value) {
+        fprintf(stderr, "%s 不能与 %s 同时使用\n", option, mode_option);
+        return false;
+    }
+    if (mode == RunMode::SIMULATE) mode_option = option;
+    mode = value;
+    return true;
 }
 
-class Player : public std::enable_shared_from_this<Player> {
-public:
-    enum class AttackResult {
-        ATTACKER_DEAD,
-        DEFENDER_DEAD,
-        ALL_ALIVE,
-    };
-
-    Player() = default;
-
-    Player(const int hit, const int def, const int atk, const int spd, std::string name) : name(std::move(name)), hit(hit), def(def), atk(atk), spd(spd) {}
-
-    Player(const Player& other)     = default;
-    Player(Player&& other) noexcept = default;
-    Player& operator=(const Player& other) = default;
-    Player& operator=(Player&& other) noexcept = default;
+// 检查修饰选项是否适用于所选的运行模式，不适用时在 stderr 说明原因并返回 false
+static bool
+CheckRunOptions(const RunMode mode, const char* mode_option, const uint32_t options) {
+    const char* subject = mode_option;
+    uint32_t rejected   = options & ~AcceptedOptions(mode);
 
-    virtual ~Player() = default;
-
-    virtual AttackResult Attack(int round, Player& defender) = 0;
-
-    virtual AttackResult DoAtk(const int round, const std::shared_ptr<Player>& attacker, const int atk) {
-        const int acc_atk = attacker->IsHit() ? std::max(0, atk) : 0;
-        hit -= acc_atk;
-        LOG("回合%d %s 对 %s 普攻，造成%d点伤害，%s 剩余血量 %d\n", round, attacker->name.c_str(), name.c_str(), acc_atk, name.c_str(), hit);
-        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
-    }
-
-    virtual AttackResult DoUlt(const int round, const std::shared_ptr<Player>& attacker, const int atk, const std::string& skill_name) {
-        const int acc_atk = attacker->IsHit() ? atk : 0;
-        hit -= acc_atk;
-        LOG("回合%d %s 使用了技能：【%s】对 %s 造成%d点伤害，%s 剩余血量 %d\n", round, attacker->name.c_str(), skill_name.c_str(), name.c_str(), acc_atk, name.c_str(), hit);
-        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
+    // 全矩阵总是包含全部对局
+    if (rejected == 0 && (options & OPTION_SELECT) != 0) {
+        subject  = "--matchup / --character";
+        rejected = options & OPTION_MATRIX;
     }
-
-    [[nodiscard]] bool IsHit() const { return GetRandom() <= hit_rate; }
-
-    [[nodiscard]] bool GetAndRefreshCharmState() {
-        if (buff_charm == 0) return false;
-        return buff_charm-- != 0;
+    // 逐场统计只以文字输出
+    if (rejected == 0 && (options & OPTION_FORMAT) != 0) {
+        subject  = "--format";
+        rejected = options & OPTION_STATS;
     }
-
-    std::string name;
-
-    int hit = 0;
-    int def = 0;
-    int atk = 0;
-    int spd = 0;
-
-    float hit_rate    = 1.f;
-    bool is_group     = false;
-    int buff_opponent = 0;
-    int buff_charm    = 0;
-};
-
-class Kiana final : public Player {
-public:
-    Kiana() : Player(100, 11, 24, 23, "琪亚娜") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_self_ || buff_opponent) {
-            if (buff_self_) --buff_self_;
-            if (buff_opponent) --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            const auto result = defender.DoUlt(round, shared_from_this(), atk + defender.def, "吃我一矛！");
-            if (result != AttackResult::ALL_ALIVE) return result;
-
-            if (GetRandom() <= 0.35f) {
-                LOG("回合%d %s 因为【音浪~太强~】技能效果进入了眩晕状态\n", round, name.c_str());
-                buff_self_ = 1;
-            }
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-        }
-
-        return AttackResult::ALL_ALIVE;
+    // 缓存只保存胜负计数，不含逐场的统计、日志，也不能接续自适应试验的批次
+    if (rejected == 0 && mode == RunMode::SIMULATE && (options & OPTION_CACHE) != 0) {
+        subject  = "--cache";
+        rejected = options & (OPTION_CI_WIDTH | OPTION_STATS | OPTION_TRACE);
     }
+    if (rejected == 0) return true;
 
-private:
-    int buff_self_ = 0;
-
-    enum { ATK_EVERY_ROUND = 2 };
-};
-
-class Mei final : public Player {
-public:
-    Mei() : Player(100, 12, 22, 30, "芽衣") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            for (int i = 0; i < 5; ++i) {
-                const auto result = defender.DoUlt(round, shared_from_this(), 3, "雷电家的龙女仆");
-                if (result != AttackResult::ALL_ALIVE) return result;
-            }
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-
-            if (!is_charm && GetRandom() <= 0.3f) {
-                LOG("回合%d %s 使用了技能：【崩坏世界的歌姬】麻痹对方一回合\n", round, name.c_str());
-                defender.buff_opponent = 1;
-            }
-        }
-
-        return AttackResult::ALL_ALIVE;
+    std::string names;
+    for (int i = 0; i < static_cast<int>(std::size(kRunOptionNames)); ++i) {
+        if ((rejected & (1u << i)) == 0) continue;
+        if (!names.empty()) names += " / ";
+        names += kRunOptionNames[i];
     }
+    fprintf(stderr, "%s 不能与 %s 同时使用\n", subject, names.c_str());
+    return false;
+}
 
-private:
-    enum { ATK_EVERY_ROUND = 2 };
-};
-
-class Bronya final : public Player {
-public:
-    Bronya() : Player(100, 10, 21, 20, "布洛妮娅") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            const auto result = defender.DoUlt(round, shared_from_this(), GetRandom(1, 100), "摩托拜客哒！");
-            if (result != AttackResult::ALL_ALIVE) return result;
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-
-            if (!is_charm && GetRandom() < 0.25f) {
-                for (int i = 0; i < 4; ++i) {
-                    LOG("回合%d %s 使用了技能：【天使重构】\n", round, name.c_str());
-                    const auto ex_result = defender.DoAtk(round, shared_from_this(), 12 - defender.def);
-                    if (ex_result != AttackResult::ALL_ALIVE) return ex_result;
-                }
-            }
-        }
-
-        return AttackResult::ALL_ALIVE;
+// 以下三个函数把整个 text 读作十进制数写入 value；有多余的字符、溢出或超出范围时在 stderr 说明并返回 false，value 不变
+static bool
+ParseIntOption(const char* option, const char* text, const int min_value, const int max_value, int& value) {
+    char* end         = nullptr;
+    errno             = 0;
+    const long number = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || number < min_value || number > max_value) {
+        fprintf(stderr, "%s 需要 %d 到 %d 之间的整数: %s\n", option, min_value, max_value, text);
+        return false;
     }
+    value = static_cast<int>(number);
+    return true;
+}
 
-private:
-    enum { ATK_EVERY_ROUND = 3 };
-};
-
-class Himeko final : public Player {
-public:
-    Himeko() : Player(100, 9, 23, 12, "姬子") {
-        if (is_group) {
-            LOG("回合0 %s 使用了技能：【真爱不死】伤害提升100%%\n", name.c_str());
-        }
+static bool
+ParseUint64Option(const char* option, const char* text, const uint64_t min_value, uint64_t& value) {
+    char* end             = nullptr;
+    errno                 = 0;
+    const uint64_t number = std::strtoull(text, &end, 10);
+    // strtoull 接受负号并按补码回绕，只允许以数字开头
+    if (!std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' || errno == ERANGE || number < min_value) {
+        fprintf(stderr, "%s 需要不小于 %llu 的整数: %s\n", option, static_cast<unsigned long long>(min_value), text);
+        return false;
     }
+    value = number;
+    return true;
+}
 
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        const int gan = !is_charm && is_group ? 2 : 1;
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            LOG("回合%d %s 使用了技能：【干杯，朋友】攻击力提升了100%%，命中率下降35%%\n", round, name.c_str());
-            atk *= 2;
-            hit_rate = std::max(0.f, hit_rate - 0.35f);
-        }
-
-        return defender.DoAtk(round, shared_from_this(), (atk - defender.def) * gan);
+// 只检查是有限的数，取值范围由调用方按各选项的含义检查
+static bool
+ParseDoubleOption(const char* option, const char* text, double& value) {
+    char* end           = nullptr;
+    const double number = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(number)) {
+        fprintf(stderr, "%s 需要一个数: %s\n", option, text);
+        return false;
     }
+    value = number;
+    return true;
+}
 
-private:
-    enum { ATK_EVERY_ROUND = 2 };
-};
-
-class Rita final : public Player {
-public:
-    Rita() : Player(100, 11, 26, 17, "丽塔") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (round % ATK_EVERY_ROUND == 0) {
-            if (is_skill_activate_) {
-                LOG("回合%d %s 使用了技能：【完美心意】使 %s 回复了4点血量，并陷入两个回合的魅惑阶段\n", round, name.c_str(), defender.name.c_str());
+int
+main(int argc, char* argv[]) {
+    uint64_t times = 10000000;
+
+    RunMode mode            = RunMode::SIMULATE;
+    const char* mode_option = nullptr;
+    bool full_matrix        = false;
+    bool check              = false;
+    bool print_stats        = false;
+    bool times_set          = false;
+    uint64_t branch_trial   = 0;
+    int branch_round        = 0;
+    const char* trace_path   = nullptr;
+    const char* crn_path     = nullptr;
+    const char* save_path    = nullptr;
+    const char* cache_path   = nullptr;
+    const char* serve_path   = nullptr;
+    const char* shard_path   = nullptr;
+    const char* dataset_path = nullptr;
+    const char* ab_path      = nullptr;
+    const char* endgame_path = nullptr;
+    int endgame_hit          = kEndgameDefaultHit;
+    int processes            = 0;
+    int shard_index          = 0;
+    int shard_count          = 0;
+    std::string shard_dir    = ".";
+    std::vector<std::string> merge_paths;
+    std::vector<std::string_view> patches;
+    BalanceOptions balance_options;
+    TournamentOptions tournament_options;
+    RaceOptions race_options;
+    VarianceOptions variance_options;
+    Engine engine       = Engine::BATCH;
+    OutputFormat format = OutputFormat::TABLE;
+    StoppingRule rule;
+    // --matchup / --character 选中的对局，为空时跑全部对局
+    std::vector<std::pair<Character, Character>> selected;
+    uint64_t seed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--scaling") {
+            if (!SelectRunMode(mode, mode_option, RunMode::SCALING, argv[i])) return 1;
+        } else if (arg == "--matrix") {
+            full_matrix = true;
+        } else if (arg == "--exact") {
+            if (!SelectRunMode(mode, mode_option, RunMode::EXACT, argv[i])) return 1;
+        } else if (arg == "--check") {
+            if (!SelectRunMode(mode, mode_option, RunMode::EXACT, argv[i])) return 1;
+            check = true;
+        } else if (arg == "--verify") {
+            if (!SelectRunMode(mode, mode_option, RunMode::VERIFY, argv[i])) return 1;
+        } else if (arg == "--profile") {
+            if (!SelectRunMode(mode, mode_option, RunMode::PROFILE, argv[i])) return 1;
+        } else if (arg == "--stats") {
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            print_stats = true;
+#else
+            fprintf(stderr, "--stats 需要以 ENABLE_STATS=1 编译\n");
+            return 1;
+#endif
+        } else if (arg == "--dataset" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::DATASET, argv[i])) return 1;
+            dataset_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+#if defined(ENABLE_TRACE) && (ENABLE_TRACE == 1)
+            trace_path = argv[++i];
+#else
+            fprintf(stderr, "--trace 需要以 ENABLE_TRACE=1 编译\n");
+            return 1;
+#endif
+        } else if (arg == "--max-rounds" && i + 1 < argc) {
+            int max_rounds = 0;
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, max_rounds)) return 1;
+            SetMaxRounds(max_rounds);
+            ++i;
+        } else if (arg == "--matchup" && i + 2 < argc) {
+            Character c0, c1;
+            if (!ParseCharacterArg(argv[i + 1], c0) || !ParseCharacterArg(argv[i + 2], c1)) {
+                fprintf(stderr, "未知的角色: %s %s\n", argv[i + 1], argv[i + 2]);
+                return 1;
+            }
+            selected.emplace_back(c0, c1);
+            i += 2;
+        } else if (arg == "--character" && i + 1 < argc) {
+            Character c0;
+            if (!ParseCharacterArg(argv[++i], c0)) {
+                fprintf(stderr, "未知的角色: %s\n", argv[i]);
+                return 1;
+            }
+            for (int c = 0; c < kNumOfCharacter; ++c) {
+                if (c != static_cast<int>(c0)) selected.emplace_back(c0, static_cast<Character>(c));
+            }
+        } else if (arg == "--tournament" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::TOURNAMENT, argv[i])) return 1;
+            const std::string_view name = argv[++i];
+            if (name == "round-robin") {
+                tournament_options.format = TournamentFormat::ROUND_ROBIN;
+            } else if (name == "swiss") {
+                tournament_options.format = TournamentFormat::SWISS;
+            } else if (name == "elimination") {
+                tournament_options.format = TournamentFormat::SINGLE_ELIMINATION;
             } else {
-                LOG("回合%d %s 使用了技能：【完美心意】使 %s 回复了4点血量，并陷入两个回合的魅惑阶段，伤害永久减低60%%\n", round, name.c_str(), defender.name.c_str());
-                is_skill_activate_ = true;
+                fprintf(stderr, "未知的赛制: %s\n", argv[i]);
+                return 1;
             }
-
-            defender.hit        = std::min(100, defender.hit + 4);
-            defender.buff_charm = 2;
-        } else {
-            int current_round_atk = atk;
-            if (GetRandom() < 0.35f) {
-                current_round_atk = std::max(0, current_round_atk - 3);
-                defender.atk      = std::max(0, defender.atk - 4);
-                LOG("回合%d %s 使用了技能：【女仆的温柔清理】使 %s 攻击力永久下降4点\n", round, name.c_str(), defender.name.c_str());
+        } else if (arg == "--swiss-rounds" && i + 1 < argc) {
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, tournament_options.swiss_rounds)) return 1;
+            ++i;
+        } else if (arg == "--race" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::RACE, argv[i])) return 1;
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, kNumOfCharacter, race_options.top_k)) return 1;
+            ++i;
+        } else if (arg == "--tie-margin" && i + 1 < argc) {
+            if (!ParseDoubleOption(argv[i], argv[i + 1], race_options.tie_margin)) return 1;
+            if (race_options.tie_margin < 0. || race_options.tie_margin >= 0.5) {
+                fprintf(stderr, "平手范围必须在 [0, 0.5) 之内: %s\n", argv[i + 1]);
+                return 1;
             }
-
-            const auto result = defender.DoAtk(round, shared_from_this(), current_round_atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-        }
-
-        return AttackResult::ALL_ALIVE;
-    }
-
-    AttackResult DoAtk(const int round, const std::shared_ptr<Player>& attacker, const int atk) override { return Player::DoAtk(round, attacker, is_skill_activate_ ? static_cast<int>(std::round(static_cast<float>(atk) * 0.4f)) : atk); }
-
-    AttackResult DoUlt(const int round, const std::shared_ptr<Player>& attacker, const int atk, const std::string& skill_name) override { return Player::DoUlt(round, attacker, is_skill_activate_ ? static_cast<int>(std::round(static_cast<float>(atk) * 0.4f)) : atk, skill_name); }
-
-private:
-    enum { ATK_EVERY_ROUND = 4 };
-
-    bool is_skill_activate_ = false;
-};
-
-class Sakura final : public Player {
-public:
-    Sakura() : Player(100, 9, 20, 18, "八重樱&卡莲") { is_group = true; }
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (!is_charm && GetRandom() <= 0.3f) {
-            hit = std::min(100, hit + 25);
-            LOG("回合%d %s 使用了技能：【八重樱的饭团】吃下了饭团，回复25点血量\n", round, name.c_str());
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            const auto result = defender.DoUlt(round, shared_from_this(), 25, "卡莲的饭团");
-            if (result != AttackResult::ALL_ALIVE) return result;
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-        }
-
-        return AttackResult::ALL_ALIVE;
-    }
-
-private:
-    enum { ATK_EVERY_ROUND = 2 };
-};
-
-class Corvus final : public Player {
-public:
-    Corvus() : Player(100, 14, 23, 14, "渡鸦") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        float gan = 1.f;
-        if (!is_charm && (dynamic_cast<Kiana*>(&defender) != nullptr || GetRandom() <= 0.25f)) {
-            LOG("回合%d %s 使用了技能：【不是针对你】伤害提升了25%%\n", round, name.c_str());
-            gan += 0.25f;
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            for (int i = 0; i < 7; ++i) {
-                const auto result = defender.DoUlt(round, shared_from_this(), static_cast<int>(std::round(static_cast<float>(16 - defender.def) * gan)), "别墅小岛");
-                if (result != AttackResult::ALL_ALIVE) return result;
+            ++i;
+        } else if (arg == "--variance") {
+            if (!SelectRunMode(mode, mode_option, RunMode::VARIANCE, argv[i])) return 1;
+        } else if (arg == "--antithetic") {
+            if (!SelectRunMode(mode, mode_option, RunMode::VARIANCE, argv[i])) return 1;
+            variance_options.antithetic = true;
+        } else if (arg == "--qmc" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::VARIANCE, argv[i])) return 1;
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, kMaxQmcDims, variance_options.qmc_dims)) return 1;
+            ++i;
+        } else if (arg == "--crn" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::VARIANCE, argv[i])) return 1;
+            crn_path = argv[++i];
+        } else if (arg == "--ab" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::AB, argv[i])) return 1;
+            ab_path = argv[++i];
+        } else if (arg == "--patch" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::AB, argv[i])) return 1;
+            patches.emplace_back(argv[++i]);
+        } else if (arg == "--endgame" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::ENDGAME, argv[i])) return 1;
+            endgame_path = argv[++i];
+        } else if (arg == "--endgame-hp" && i + 1 < argc) {
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, endgame_hit)) return 1;
+            ++i;
+        } else if (arg == "--branch" && i + 2 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::BRANCH, argv[i])) return 1;
+            if (!ParseUint64Option(argv[i], argv[i + 1], 0, branch_trial) || !ParseIntOption(argv[i], argv[i + 2], 1, INT_MAX, branch_round)) return 1;
+            i += 2;
+        } else if (arg == "--serve" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::SERVE, argv[i])) return 1;
+            serve_path = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--processes" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::PROCESSES, argv[i])) return 1;
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, processes)) return 1;
+            ++i;
+        } else if (arg == "--shard-dir" && i + 1 < argc) {
+            shard_dir = argv[++i];
+        } else if (arg == "--shard" && i + 3 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::SHARD, argv[i])) return 1;
+            if (!ParseIntOption(argv[i], argv[i + 1], 0, INT_MAX, shard_index) || !ParseIntOption(argv[i], argv[i + 2], 1, INT_MAX, shard_count)) return 1;
+            shard_path = argv[i + 3];
+            i += 3;
+            if (shard_index >= shard_count) {
+                fprintf(stderr, "无效的分片: %d/%d\n", shard_index, shard_count);
+                return 1;
             }
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), static_cast<int>(std::round(static_cast<float>(atk - defender.def) * gan)));
-            if (result != AttackResult::ALL_ALIVE) return result;
-        }
-
-        return AttackResult::ALL_ALIVE;
-    }
-
-private:
-    enum { ATK_EVERY_ROUND = 3 };
-};
-
-class Theresa final : public Player {
-public:
-    Theresa() : Player(100, 12, 19, 22, "德莉莎") { is_group = true; }
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            for (int i = 0; i < 5; ++i) {
-                const auto result = defender.DoUlt(round, shared_from_this(), 16 - defender.def, "在线踢人");
-                if (result != AttackResult::ALL_ALIVE) return result;
+        } else if (arg == "--merge" && i + 1 < argc) {
+            if (!SelectRunMode(mode, mode_option, RunMode::MERGE, argv[i])) return 1;
+            while (i + 1 < argc && std::string_view(argv[i + 1]).substr(0, 2) != "--") merge_paths.emplace_back(argv[++i]);
+        } else if (arg == "--format" && i + 1 < argc) {
+            const std::string_view name = argv[++i];
+            if (name == "table") {
+                format = OutputFormat::TABLE;
+            } else if (name == "csv") {
+                format = OutputFormat::CSV;
+            } else if (name == "json") {
+                format = OutputFormat::JSON;
+            } else {
+                fprintf(stderr, "未知的输出格式: %s\n", argv[i]);
+                return 1;
             }
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk - defender.def);
-            if (result != AttackResult::ALL_ALIVE) return result;
-
-            if (!is_charm && GetRandom() <= 0.3f) {
-                LOG("回合%d %s 使用了技能：【血犹大第一可爱】降低了对方5点的防御\n", round, name.c_str());
-                defender.def = std::max(0, defender.def - 5);
+        } else if (arg == "--times" && i + 1 < argc) {
+            if (!ParseUint64Option(argv[i], argv[i + 1], 1, times)) return 1;
+            times_set = true;
+            ++i;
+        } else if (arg == "--params" && i + 1 < argc) {
+            CharacterTable table = GetCharacterTable();
+            if (!LoadCharacterTable(argv[++i], table)) return 1;
+            SetCharacterTable(table);
+        } else if (arg == "--dump-params") {
+            WriteCharacterTable(stdout, GetCharacterTable());
+            return 0;
+        } else if (arg == "--balance") {
+            if (!SelectRunMode(mode, mode_option, RunMode::BALANCE, argv[i])) return 1;
+        } else if (arg == "--generations" && i + 1 < argc) {
+            if (!ParseIntOption(argv[i], argv[i + 1], 0, INT_MAX, balance_options.generations)) return 1;
+            ++i;
+        } else if (arg == "--variants" && i + 1 < argc) {
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, balance_options.variants)) return 1;
+            ++i;
+        } else if (arg == "--grid") {
+            balance_options.grid = true;
+        } else if (arg == "--band" && i + 2 < argc) {
+            if (!ParseDoubleOption(argv[i], argv[i + 1], balance_options.low) || !ParseDoubleOption(argv[i], argv[i + 2], balance_options.high)) return 1;
+            i += 2;
+        } else if (arg == "--save-params" && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            int threads = 0;
+            if (!ParseIntOption(argv[i], argv[i + 1], 1, INT_MAX, threads)) return 1;
+            ThreadPool::Instance().SetNumThreads(threads);
+            ++i;
+        } else if (arg == "--backend" && i + 1 < argc) {
+            const std::string_view name = argv[++i];
+            if (name == "thread") {
+                ThreadPool::Instance().SetBackend(Backend::THREAD);
+#ifdef _OPENMP
+            } else if (name == "omp") {
+                ThreadPool::Instance().SetBackend(Backend::OPENMP);
+#endif
+            } else {
+                fprintf(stderr, "未知的线程后端: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const std::string_view name = argv[++i];
+            if (name == "virtual") {
+                engine = Engine::VIRTUAL;
+            } else if (name == "specialized") {
+                engine = Engine::SPECIALIZED;
+            } else if (name == "batch") {
+                engine = Engine::BATCH;
+            } else {
+                fprintf(stderr, "未知的引擎: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--ci-width" && i + 1 < argc) {
+            // 宽度为 0 表示不启用自适应，显式给出时必须为正数
+            if (!ParseDoubleOption(argv[i], argv[i + 1], rule.width)) return 1;
+            if (rule.width <= 0.) {
+                fprintf(stderr, "置信区间宽度必须为正数: %s\n", argv[i + 1]);
+                return 1;
             }
+            ++i;
+        } else if (arg == "--confidence" && i + 1 < argc) {
+            if (!ParseDoubleOption(argv[i], argv[i + 1], rule.confidence)) return 1;
+            ++i;
+        } else if (arg == "--interval" && i + 1 < argc) {
+            const std::string_view name = argv[++i];
+            if (name == "wilson") {
+                rule.interval = Interval::WILSON;
+            } else if (name == "clopper-pearson") {
+                rule.interval = Interval::CLOPPER_PEARSON;
+            } else {
+                fprintf(stderr, "未知的置信区间: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            if (!ParseUint64Option(argv[i], argv[i + 1], 0, seed)) return 1;
+            ++i;
+        } else {
+            fprintf(stderr, "用法: %s [--seed <种子>] [--times <每个对局的场次>] [--threads <线程数>] [--backend thread|omp] [--engine virtual|specialized|batch] [--matchup <角色> <角色>]... [--character <角色>] [--format table|csv|json] [--cache <文件>] [--serve <套接字>] [--processes <进程数> [--shard-dir <目录>]] [--shard <序号> <分片数> <文件>] [--merge <文件>...] [--tournament round-robin|swiss|elimination [--swiss-rounds <轮数>]] [--race <名次数> [--tie-margin <平手范围>]] [--variance] [--antithetic] [--qmc <维数>] [--crn <数值表>] [--ab <数值表>] [--patch <角色>.<项>=<值>]... [--endgame <残局表文件> [--endgame-hp <血量>]] [--branch <试验序号> <回合>] [--ci-width <区间宽度>] [--confidence <置信水平>] [--interval wilson|clopper-pearson] [--max-rounds <回合上限>] [--stats] [--trace <文件>] [--dataset <文件>] [--params <数值表>] [--dump-params] [--balance [--generations <代数>] [--variants <变体数>] [--grid] [--band <下限> <上限>] [--save-params <文件>]] [--matrix] [--exact] [--check] [--verify] [--profile] [--scaling]\n", argv[0]);
+            return 1;
         }
-
-        return AttackResult::ALL_ALIVE;
     }
 
-private:
-    enum { ATK_EVERY_ROUND = 3 };
-};
-
-class Olenyeva final : public Player {
-public:
-    Olenyeva() : Player(100, 10, 18, 10, "萝莎莉娅&莉莉娅") { is_group = true; }
-
-    AttackResult Attack(const int round, Player& defender) override {
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
-
-        if (boom_ > 0) {
-            --boom_;
-            defender.DoUlt(round, shared_from_this(), GetRandom() <= 0.5f ? 233 : 50, "变成星星吧！");
-        }
-
-        return defender.DoAtk(round, shared_from_this(), atk - defender.def);
+    if (rule.confidence <= 0. || rule.confidence >= 1.) {
+        fprintf(stderr, "置信水平必须在 0 和 1 之间: %g\n", rule.confidence);
+        return 1;
     }
 
-    AttackResult DoAtk(const int round, const std::shared_ptr<Player>& attacker, const int atk) override {
-        const int acc_atk = attacker->IsHit() ? std::max(0, atk) : 0;
-        hit -= acc_atk;
-        LOG("回合%d %s 对 %s 普攻，造成%d点伤害，%s 剩余血量 %d\n", round, attacker->name.c_str(), name.c_str(), acc_atk, name.c_str(), hit);
-
-        if (hit <= 0) {
-            if (buff_charm == 0 && resurrection_stone_ > 0) {
-                LOG("回合%d %s 使用了技能：【96度生命之水】并恢复至20点血量\n", round, name.c_str());
-                hit   = 20;
-                boom_ = 1;
-                --resurrection_stone_;
-                return AttackResult::ALL_ALIVE;
-            }
-            return AttackResult::DEFENDER_DEAD;
-        }
-        return AttackResult::ALL_ALIVE;
+    if (balance_options.low < 0. || balance_options.high > 1. || balance_options.low >= balance_options.high) {
+        fprintf(stderr, "目标胜率区间无效: [%g, %g]\n", balance_options.low, balance_options.high);
+        return 1;
     }
 
-    AttackResult DoUlt(const int round, const std::shared_ptr<Player>& attacker, const int atk, const std::string& skill_name) override {
-        const int acc_atk = attacker->IsHit() ? atk : 0;
-        hit -= acc_atk;
-        LOG("回合%d %s 使用了技能：【%s】对 %s 造成%d点伤害，%s 剩余血量 %d\n", round, attacker->name.c_str(), skill_name.c_str(), name.c_str(), acc_atk, name.c_str(), hit);
-
-        if (hit <= 0) {
-            if (buff_charm == 0 && resurrection_stone_ > 0) {
-                LOG("回合%d %s 使用了技能：【96度生命之水】并恢复至20点血量\n", round, name.c_str());
-                hit   = 20;
-                boom_ = 1;
-                --resurrection_stone_;
-                return AttackResult::ALL_ALIVE;
-            }
-            return AttackResult::DEFENDER_DEAD;
-        }
-        return AttackResult::ALL_ALIVE;
+    uint32_t options = 0;
+    if (full_matrix) options |= OPTION_MATRIX;
+    if (!selected.empty()) options |= OPTION_SELECT;
+    if (format != OutputFormat::TABLE) options |= OPTION_FORMAT;
+    if (print_stats) options |= OPTION_STATS;
+    if (trace_path != nullptr) options |= OPTION_TRACE;
+    if (cache_path != nullptr) options |= OPTION_CACHE;
+    if (rule.Enabled()) options |= OPTION_CI_WIDTH;
+    if (!CheckRunOptions(mode, mode_option, options)) return 1;
+
+    if (trace_path != nullptr && MaxRounds() > kTraceMaxRound) {
+        fprintf(stderr, "开启 --trace 时回合上限不能超过 %d\n", kTraceMaxRound);
+        return 1;
     }
 
-private:
-    int boom_               = 0;
-    int resurrection_stone_ = 1;
-};
-
-class Seele final : public Player {
-public:
-    Seele() : Player(100, 13, 23, 26, "希儿") { is_group = true; }
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
-
-        status_ ^= 1;
-        if (!is_charm) {
-            if (status_ == 0) {
-                const int origin_hit = hit;
-
-                hit = std::min(100, hit + GetRandom(1, 15));
-                def += 5;
-                atk -= 10;
-                LOG("回合%d 希尔转变为白形态，防御力上升了，攻击力下降了，回复了%d点血量\n", round, hit - origin_hit);
-            } else {
-                def -= 5;
-                atk += 10;
-                LOG("回合%d 希尔转变为黑形态，攻击力上升了，防御力下降了\n", round);
-            }
-        }
-
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
+    if (mode == RunMode::BRANCH && branch_round >= MaxRounds()) {
+        fprintf(stderr, "--branch 的回合必须小于回合上限 %d: %d\n", MaxRounds(), branch_round);
+        return 1;
+    }
 
-        return defender.DoAtk(round, shared_from_this(), atk - defender.def);
+    // 对照的数值表以 --params 之后的当前数值表为基础，只需写出改动的项
+    CharacterTable crn_table = GetCharacterTable();
+    if (crn_path != nullptr) {
+        if (!LoadCharacterTable(crn_path, crn_table)) return 1;
+        variance_options.variant = &crn_table;
     }
 
-private:
-    int status_ = 0;  // 0 是白希，1是黑希
-};
+    // 改动后的数值表：先载入 --ab 的数值表，再依次应用 --patch
+    CharacterTable ab_table = GetCharacterTable();
+    if (ab_path != nullptr && !LoadCharacterTable(ab_path, ab_table)) return 1;
+    for (const std::string_view patch : patches) {
+        if (!ApplyParamPatch(patch, ab_table)) return 1;
+    }
 
-class Durandal final : public Player {
-public:
-    Durandal() : Player(100, 10, 19, 15, "幽兰黛尔&史丹") { is_group = true; }
+    // 合并时对局列表与种子都取自分片文件
+    if (mode == RunMode::MERGE) return MergeSimulation(merge_paths, engine, format);
+
+    ResultCache cache;
+    if (cache_path != nullptr && !cache.Open(cache_path)) return 1;
+
+    if (mode == RunMode::SERVE) {
+        ServerOptions server_options;
+        server_options.socket_path = serve_path;
+        server_options.seed        = seed;
+        server_options.engine      = engine;
+        server_options.rule        = rule;
+        server_options.max_battles = times;
+        server_options.cache       = cache.IsOpen() ? &cache : nullptr;
+        printf("随机种子: %llu\n", static_cast<unsigned long long>(seed));
+        return RunServer(server_options);
+    }
 
-    AttackResult Attack(const int round, Player& defender) override {
-        atk += 3;
+    std::vector<MatchupTask> tasks;
+    if (selected.empty()) {
+        tasks = MakeMatchupTasks(times, full_matrix);
+    } else {
+        for (const auto& [c0, c1] : selected) tasks.push_back({c0, c1, times});
+    }
 
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
+    if (format == OutputFormat::TABLE) printf("随机种子: %llu\n", static_cast<unsigned long long>(seed));
 
-        return defender.DoAtk(round, shared_from_this(), atk - defender.def);
+    if (trace_path != nullptr && !OpenTrace(trace_path, seed)) {
+        fprintf(stderr, "无法写入 trace 文件: %s\n", trace_path);
+        return 1;
     }
 
-    AttackResult DoUlt(int round, const std::shared_ptr<Player>& attacker, const int atk, const std::string& name) override {
-        if (buff_charm == 0 && GetRandom() < 0.16f) {
-            attacker->hit -= 30;
-            return attacker->hit <= 0 ? AttackResult::ATTACKER_DEAD : AttackResult::ALL_ALIVE;
-        }
-        hit -= atk;
-        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
+    // 平衡搜索每个变体只需较少场次，未指定 --times 时使用 BalanceOptions 的默认值
+    if (mode == RunMode::BALANCE) {
+        if (times_set) balance_options.times = times;
+        BalanceSimulation(balance_options, seed, engine, save_path);
+        CloseTrace();
+        return 0;
     }
-};
 
-class FuHua final : public Player {
-public:
-    FuHua() : Player(100, 15, 17, 16, "符华") {}
-
-    AttackResult Attack(const int round, Player& defender) override {
-        const bool is_charm = GetAndRefreshCharmState();
+    // 赛事中 --times 为每场比赛的战斗场次，未指定时使用 TournamentOptions 的默认值；竞速中为每个对局的场次上限
+    if (mode == RunMode::TOURNAMENT) {
+        if (times_set) tournament_options.battles = times;
+        TournamentSimulation(tournament_options, seed, engine);
+        CloseTrace();
+        return 0;
+    }
 
-        if (buff_opponent) {
-            --buff_opponent;
-            return AttackResult::ALL_ALIVE;
-        }
+    if (mode == RunMode::RACE) {
+        race_options.max_battles     = times;
+        race_options.rule.confidence = rule.confidence;
+        race_options.rule.interval   = rule.interval;
+        RaceSimulation(race_options, seed, engine);
+        CloseTrace();
+        return 0;
+    }
 
-        if (!is_charm && round % ATK_EVERY_ROUND == 0) {
-            const auto result = defender.DoUlt(round, shared_from_this(), 18, "形之笔墨");
-            if (result != AttackResult::ALL_ALIVE) return result;
+    if (mode == RunMode::SCALING) {
+        ScalingReport(std::max<uint64_t>(times / 100, 1), seed, engine);
+        CloseTrace();
+        return 0;
+    }
 
-            defender.hit_rate = std::max(0.f, defender.hit_rate - 0.25f);
-        } else {
-            const auto result = defender.DoAtk(round, shared_from_this(), atk);
-            if (result != AttackResult::ALL_ALIVE) return result;
-        }
+    // --check 以精确解为基准检查蒙特卡洛引擎
+    if (mode == RunMode::EXACT) return ExactSimulation(tasks, full_matrix, check, seed, engine);
 
-        return AttackResult::ALL_ALIVE;
+    if (mode == RunMode::AB) {
+        ABSimulation(tasks, seed, ab_table, rule);
+        return 0;
     }
 
-private:
-    enum { ATK_EVERY_ROUND = 3 };
-};
-
-enum class Character : int {
-    KIANA,     // 琪亚娜
-    MEI,       // 芽衣
-    BRONYA,    // 布洛妮娅
-    HIMEKO,    // 姬子
-    RITA,      // 丽塔
-    SAKURA,    // 八重樱&卡莲
-    CORVUS,    // 渡鸦
-    THERESA,   // 德莉莎
-    OLENYEVA,  // 萝莎莉娅&莉莉娅
-    SEELE,     // 希尔
-    DURANDAL,  // 幽兰黛尔
-    FU_HUA,    // 符华
-    NUM_OF_CHARACTER
-};
+    if (mode == RunMode::ENDGAME) return EndgameSimulation(tasks, seed, endgame_path, endgame_hit);
 
-std::shared_ptr<Player>
-GetPlayer(const Character& character) {
-    // clang-format off
-    switch (character) {
-    case Character::KIANA:    return std::make_shared<Kiana>();
-    case Character::MEI:      return std::make_shared<Mei>();
-    case Character::BRONYA:   return std::make_shared<Bronya>();
-    case Character::HIMEKO:   return std::make_shared<Himeko>();
-    case Character::RITA:     return std::make_shared<Rita>();
-    case Character::SAKURA:   return std::make_shared<Sakura>();
-    case Character::CORVUS:   return std::make_shared<Corvus>();
-    case Character::THERESA:  return std::make_shared<Theresa>();
-    case Character::OLENYEVA: return std::make_shared<Olenyeva>();
-    case Character::SEELE:    return std::make_shared<Seele>();
-    case Character::DURANDAL: return std::make_shared<Durandal>();
-    case Character::FU_HUA:   return std::make_shared<FuHua>();
-    default: abort();
+    if (mode == RunMode::VARIANCE) {
+        VarianceSimulation(tasks, seed, variance_options);
+        return 0;
     }
-    // clang-format on
-}
 
-void
-SimulationSingle(const Character c0, const Character c1, const int times) {
-    const std::shared_ptr<Player> player_0 = GetPlayer(c0);
-    const std::shared_ptr<Player> player_1 = GetPlayer(c1);
-
-    std::atomic<int32_t> p0_win = 0;
-    std::atomic<int32_t> p1_win = 0;
-
-    if (player_0->spd > player_1->spd) {
-        #pragma omp parallel for
-        for (int k = 0; k < times; ++k) {
-            std::shared_ptr<Player> p_0 = GetPlayer(c0);
-            std::shared_ptr<Player> p_1 = GetPlayer(c1);
-
-            for (int round = 1;; ++round) {
-                const auto p0_status = p_0->Attack(round, *p_1);
-                if (p0_status != Player::AttackResult::ALL_ALIVE) {
-                    if (p0_status == Player::AttackResult::DEFENDER_DEAD) ++p0_win;
-                    if (p0_status == Player::AttackResult::ATTACKER_DEAD) ++p1_win;
-                    break;
-                }
-
-                const auto p1_status = p_1->Attack(round, *p_0);
-                if (p1_status != Player::AttackResult::ALL_ALIVE) {
-                    if (p1_status == Player::AttackResult::DEFENDER_DEAD) ++p1_win;
-                    if (p1_status == Player::AttackResult::ATTACKER_DEAD) ++p0_win;
-                    break;
-                }
-            }
+    // 未指定 --times 时每个对局使用 kProfileTimes 场
+    if (mode == RunMode::PROFILE) {
+        if (!times_set) {
+            for (auto& task : tasks) task.times = kProfileTimes;
         }
+        ProfileSimulation(tasks, seed, engine);
+        return 0;
     }
-    else {
-        #pragma omp parallel for
-        for (int k = 0; k < times; ++k) {
-            std::shared_ptr<Player> p_0 = GetPlayer(c0);
-            std::shared_ptr<Player> p_1 = GetPlayer(c1);
-
-            for (int round = 1;; ++round) {
-                const auto p1_status = p_1->Attack(round, *p_0);
-                if (p1_status != Player::AttackResult::ALL_ALIVE) {
-                    if (p1_status == Player::AttackResult::DEFENDER_DEAD) ++p1_win;
-                    if (p1_status == Player::AttackResult::ATTACKER_DEAD) ++p0_win;
-                    break;
-                }
-
-                const auto p0_status = p_0->Attack(round, *p_1);
-                if (p0_status != Player::AttackResult::ALL_ALIVE) {
-                    if (p0_status == Player::AttackResult::DEFENDER_DEAD) ++p0_win;
-                    if (p0_status == Player::AttackResult::ATTACKER_DEAD) ++p1_win;
-                    break;
-                }
-            }
+
+    // 未指定 --times 时每个对局使用 kVerifyTimes 场
+    if (mode == RunMode::VERIFY) {
+        if (!times_set) {
+            for (auto& task : tasks) task.times = kVerifyTimes;
         }
+        return VerifySimulation(tasks, seed);
     }
 
-    printf("%s vs %s:\n    胜率: %8.4f%% / %8.4f%%\n", player_0->name.c_str(), player_1->name.c_str(), static_cast<double>(p0_win) / static_cast<double>(times) * 100., (1.f - static_cast<double>(p0_win) / static_cast<double>(times)) * 100.);
-}
-
-void
-Simulation(const int times) {
-    const auto num_of_character = static_cast<std::underlying_type<Character>::type>(Character::NUM_OF_CHARACTER);
-
-    const Character characters[num_of_character] = {
-        Character::KIANA,
-        Character::MEI,
-        Character::BRONYA,
-        Character::HIMEKO,
-        Character::RITA,
-        Character::SAKURA,
-        Character::CORVUS,
-        Character::THERESA,
-        Character::OLENYEVA,
-        Character::SEELE,
-        Character::DURANDAL,
-        Character::FU_HUA,
-    };
-
-    for (int j = 0; j < num_of_character; ++j) {
-        for (int i = j + 1; i < num_of_character; ++i) {
-            SimulationSingle(characters[j], characters[i], times);
-        }
+    if (mode == RunMode::BRANCH) {
+        BranchSimulation(tasks, seed, branch_trial, branch_round);
+        return 0;
     }
-}
 
-int
-main(int argc, char* argv[]) {
-#if defined(ENABLE_LOG) && (ENABLE_LOG == 1)
-    const int times = 1;
-#else
-    const int times = 10000000;
-#endif
+    if (mode == RunMode::PROCESSES) return ShardedSimulation({seed, processes, full_matrix, tasks}, engine, shard_dir, processes, format);
+
+    // 单个分片只写出部分结果，由 --merge 汇总输出
+    if (mode == RunMode::SHARD) return ShardSimulation({seed, shard_count, full_matrix, tasks}, engine, shard_index, shard_path);
+
+    if (mode == RunMode::DATASET) return DatasetSimulation(dataset_path, tasks, seed, full_matrix, format, print_stats);
 
-    Simulation(times);
-    SimulationSingle(Character::RITA, Character::OLENYEVA, times);
+    Simulation(tasks, seed, engine, full_matrix, rule, format, cache.IsOpen() ? &cache : nullptr, print_stats);
+    CloseTrace();
 
     return 0;
 }
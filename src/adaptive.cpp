@@ -0,0 +1,129 @@
+#include "adaptive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// 二分求解
+double
+NormalQuantile(const double p) {
+    double lower = -40.;
+    double upper = 40.;
+    for (int i = 0; i < 200; ++i) {
+        const double middle = (lower + upper) / 2.;
+        (0.5 * std::erfc(-middle / std::sqrt(2.)) < p ? lower : upper) = middle;
+    }
+    return (lower + upper) / 2.;
+}
+
+// 不完全 Beta 函数的连分式展开（修正 Lentz 法）
+static double
+BetaContinuedFraction(const double a, const double b, const double x) {
+    constexpr double kTiny    = 1e-300;
+    constexpr double kEpsilon = 1e-15;
+
+    double c = 1.;
+    double d = 1. - (a + b) * x / (a + 1.);
+    d        = 1. / (std::abs(d) < kTiny ? kTiny : d);
+    double h = d;
+    for (int m = 1; m < 10000000; ++m) {
+        const double m2 = 2. * m;
+        for (const double numerator : {m * (b - m) * x / ((a + m2 - 1.) * (a + m2)), -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.))}) {
+            d = 1. + numerator * d;
+            d = 1. / (std::abs(d) < kTiny ? kTiny : d);
+            c = 1. + numerator / c;
+            c = std::abs(c) < kTiny ? kTiny : c;
+            h *= c * d;
+        }
+        if (std::abs(c * d - 1.) < kEpsilon) break;
+    }
+    return h;
+}
+
+// 正则化不完全 Beta 函数 I_x(a, b)，即 Beta(a, b) 分布的累积分布函数
+static double
+RegularizedIncompleteBeta(const double a, const double b, const double x) {
+    if (x <= 0.) return 0.;
+    if (x >= 1.) return 1.;
+
+    const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log1p(-x));
+    // 连分式在 x < (a + 1) / (a + b + 2) 时收敛快，否则借助 I_x(a, b) = 1 - I_{1-x}(b, a)
+    if (x < (a + 1.) / (a + b + 2.)) return front * BetaContinuedFraction(a, b, x) / a;
+    return 1. - front * BetaContinuedFraction(b, a, 1. - x) / b;
+}
+
+// Beta(a, b) 分布的 p 分位数，二分求解
+static double
+BetaQuantile(const double p, const double a, const double b) {
+    double lower = 0.;
+    double upper = 1.;
+    for (int i = 0; i < 100; ++i) {
+        const double middle = (lower + upper) / 2.;
+        (RegularizedIncompleteBeta(a, b, middle) < p ? lower : upper) = middle;
+    }
+    return (lower + upper) / 2.;
+}
+
+std::pair<double, double>
+ConfidenceInterval(const uint64_t wins, const uint64_t n, const StoppingRule& rule) {
+    if (n == 0) return {0., 1.};
+
+    const double alpha = 1. - rule.confidence;
+    const auto k       = static_cast<double>(wins);
+    const auto trials  = static_cast<double>(n);
+
+    if (rule.interval == Interval::CLOPPER_PEARSON) {
+        const double lower = wins == 0 ? 0. : BetaQuantile(alpha / 2., k, trials - k + 1.);
+        const double upper = wins == n ? 1. : BetaQuantile(1. - alpha / 2., k + 1., trials - k);
+        return {lower, upper};
+    }
+
+    const double z      = NormalQuantile(1. - alpha / 2.);
+    const double p      = k / trials;
+    const double scale  = 1. + z * z / trials;
+    const double center = (p + z * z / (2. * trials)) / scale;
+    const double half   = z / scale * std::sqrt(p * (1. - p) / trials + z * z / (4. * trials * trials));
+    return {std::max(0., center - half), std::min(1., center + half)};
+}
+
+std::vector<MatchupResult>
+RunMatchupsAdaptive(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine, const StoppingRule& rule) {
+    constexpr uint64_t kMinBlock = 1 << 16;
+
+    const double z = NormalQuantile(1. - (1. - rule.confidence) / 2.);
+
+    std::vector<MatchupResult> results(tasks.size());
+    std::vector<std::size_t> pending(tasks.size());
+    std::iota(pending.begin(), pending.end(), 0);
+
+    while (!pending.empty()) {
+        // 按当前胜率估计区间收窄到目标宽度所需的场次，但每批至多把场次扩大到 8 倍，避免早期估计偏差造成浪费
+        std::vector<MatchupTask> blocks;
+        for (const std::size_t t : pending) {
+            const uint64_t done = results[t].Battles();
+            uint64_t target     = kMinBlock;
+            if (done > 0) {
+                const double p    = (static_cast<double>(results[t].p0_win) + z * z / 2.) / (static_cast<double>(done) + z * z);
+                const double half = rule.width / 2.;
+                const auto needed = static_cast<uint64_t>(std::ceil(z * z * p * (1. - p) / (half * half)));
+                target            = std::clamp(needed, done + kMinBlock, done * 8);
+            }
+            target = std::min(target, tasks[t].times);
+            blocks.push_back({tasks[t].c0, tasks[t].c1, target - done, done, tasks[t].table});
+        }
+
+        const std::vector<MatchupResult> block_results = RunMatchups(blocks, seed, engine);
+
+        std::vector<std::size_t> still_pending;
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            MatchupResult& result = results[pending[b]];
+            result += block_results[b];
+
+            const auto [lower, upper] = ConfidenceInterval(result.p0_win, result.Battles(), rule);
+            if (upper - lower > rule.width && result.Battles() < tasks[pending[b]].times) still_pending.push_back(pending[b]);
+        }
+        pending.swap(still_pending);
+    }
+
+    return results;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "engine.h"
+
+enum class Interval {
+    WILSON,           // Wilson 得分区间
+    CLOPPER_PEARSON,  // 由 Beta 分布分位数给出的精确区间，偏保守
+};
+
+// 自适应试验次数：每个对局分批进行，直到 p0 胜率的置信区间宽度不超过 width，或者用完 times 次预算
+struct StoppingRule {
+    double width      = 0.;  // 0 表示不启用，固定进行 times 次
+    double confidence = 0.95;
+    Interval interval = Interval::WILSON;
+
+    [[nodiscard]] bool Enabled() const { return width > 0.; }
+};
+
+// 标准正态分布的 p 分位数
+double
+NormalQuantile(double p);
+
+// n 场中胜 wins 场时胜率的置信区间
+std::pair<double, double>
+ConfidenceInterval(uint64_t wins, uint64_t n, const StoppingRule& rule);
+
+// 所有对局一起分批推进，每一批仍交给同一个调度器；每个对局的试验序号连续，
+// 因此最终停在 n 场时的结果与固定跑 n 场完全相同
+std::vector<MatchupResult>
+RunMatchupsAdaptive(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine, const StoppingRule& rule);
@@ -0,0 +1,54 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// 替换后的 operator new/delete 内联进标准容器后，GCC 会误报 malloc 出来的内存交给了 free 以外的释放函数
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// 统计当前线程的堆分配次数，用来确认试验循环内没有任何 new/delete；只在 ENABLE_ALLOC_COUNTER=1 时编译
+static thread_local uint64_t g_alloc_count = 0;
+
+void*
+operator new(const std::size_t size) {
+    ++g_alloc_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// MatchupResult 等按缓存行对齐的类型经由对齐版本分配，同样计数；aligned_alloc 要求大小为对齐的整数倍
+void*
+operator new(const std::size_t size, const std::align_val_t alignment) {
+    ++g_alloc_count;
+    const auto align = static_cast<std::size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return ptr;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+uint64_t
+GetAllocCount() {
+    return g_alloc_count;
+}
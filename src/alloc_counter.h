@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+
+// 当前线程累计的堆分配次数，未启用 ENABLE_ALLOC_COUNTER 时恒为 0，alloc_counter.cpp 也不参与编译
+#if defined(ENABLE_ALLOC_COUNTER) && (ENABLE_ALLOC_COUNTER == 1)
+uint64_t
+GetAllocCount();
+#else
+inline uint64_t
+GetAllocCount() {
+    return 0;
+}
+#endif
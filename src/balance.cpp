@@ -0,0 +1,169 @@
+#include "balance.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "random.h"
+
+// 每次交给调度器的数值表个数上限；每个 worker 都为每个对局保留一份结果，一次提交过多会占用大量内存
+constexpr std::size_t kBalanceTablesPerRun = 16;
+
+// 扰动用的随机数流与对局的随机数流互不重叠
+constexpr uint64_t kBalanceStream = kNumOfCharacter * kNumOfCharacter;
+
+// 派生各代评估种子的流编号
+constexpr uint64_t kBalanceSeedStream = kBalanceStream + 1;
+
+enum class BalanceField {
+    HIT,
+    DEF,
+    ATK,
+    SPD,
+    PERIOD,
+    SKILL_RATE,
+};
+
+// 一个可调参数
+struct BalanceKnob {
+    Character character;
+    BalanceField field;
+};
+
+// 没有周期必杀技或不使用技能概率的角色不调这两项，其余参数都参与搜索
+static std::vector<BalanceKnob>
+MakeKnobs() {
+    std::vector<BalanceKnob> knobs;
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        const auto character          = static_cast<Character>(c);
+        const CharacterParams& params = kDefaultCharacterTable[character];
+        for (const BalanceField field : {BalanceField::HIT, BalanceField::DEF, BalanceField::ATK, BalanceField::SPD}) knobs.push_back({character, field});
+        if (params.period > 0) knobs.push_back({character, BalanceField::PERIOD});
+        if (params.skill_rate > 0.f) knobs.push_back({character, BalanceField::SKILL_RATE});
+    }
+    return knobs;
+}
+
+// 把参数调整 steps 步并限制在合理范围内，返回是否有变化；概率按 0.05 一步并取整到 0.01，保证写出的数值表能原样读回
+static bool
+Adjust(CharacterTable& table, const BalanceKnob& knob, const int steps) {
+    CharacterParams& params = table[knob.character];
+    const auto adjust_int   = [steps](int& value, const int step, const int min_value, const int max_value) {
+        const int origin = value;
+        value            = std::clamp(value + steps * step, min_value, max_value);
+        return value != origin;
+    };
+
+    // clang-format off
+    switch (knob.field) {
+    case BalanceField::HIT:    return adjust_int(params.hit, 5, 5, 100);
+    case BalanceField::DEF:    return adjust_int(params.def, 1, 0, 50);
+    case BalanceField::ATK:    return adjust_int(params.atk, 1, 1, 60);
+    case BalanceField::SPD:    return adjust_int(params.spd, 1, 1, 50);
+    case BalanceField::PERIOD: return adjust_int(params.period, 1, 1, kMaxPeriod);
+    case BalanceField::SKILL_RATE: {
+        const float origin = params.skill_rate;
+        params.SetSkillRate(static_cast<float>(std::clamp(std::round(static_cast<double>(origin) * 100. + steps * 5.), 0., 100.) / 100.));
+        return params.skill_rate != origin;
+    }
+    default: return false;
+    }
+    // clang-format on
+}
+
+static BalanceScore
+Score(const std::vector<MatchupResult>& results, const std::size_t first, const std::size_t count, const BalanceOptions& options) {
+    BalanceScore score;
+    for (std::size_t t = first; t < first + count; ++t) {
+        const MatchupResult& result = results[t];
+        const double win_rate       = (static_cast<double>(result.p0_win) + static_cast<double>(result.draw) / 2.) / static_cast<double>(result.Battles());
+        const double excess         = std::max({0., options.low - win_rate, win_rate - options.high});
+
+        score.loss += excess * excess;
+        score.worst = std::max(score.worst, excess);
+        score.in_band += excess == 0. ? 1 : 0;
+        score.win_rates.push_back(win_rate);
+    }
+    return score;
+}
+
+std::vector<BalanceScore>
+EvaluateCharacterTables(const std::vector<CharacterTable>& tables, const BalanceOptions& options, const uint64_t seed, const Engine engine) {
+    const std::vector<MatchupTask> matchups = MakeMatchupTasks(options.times, false);
+
+    std::vector<BalanceScore> scores;
+    for (std::size_t first = 0; first < tables.size(); first += kBalanceTablesPerRun) {
+        const std::size_t last = std::min(first + kBalanceTablesPerRun, tables.size());
+
+        std::vector<MatchupTask> tasks;
+        for (std::size_t v = first; v < last; ++v) {
+            for (MatchupTask task : matchups) {
+                task.table = &tables[v];
+                tasks.push_back(task);
+            }
+        }
+
+        const std::vector<MatchupResult> results = RunMatchups(tasks, seed, engine);
+        for (std::size_t v = first; v < last; ++v) scores.push_back(Score(results, (v - first) * matchups.size(), matchups.size(), options));
+    }
+    return scores;
+}
+
+// 第 generation 代评估用的种子：同一代的所有数值表共用，各代互不相同，搜索不会一直拟合同一批试验的抽样噪声
+static uint64_t
+GenerationSeed(const uint64_t seed, const int generation) {
+    return generation == 0 ? seed : RandomStream::MakeKey(seed, kBalanceSeedStream, static_cast<uint64_t>(generation));
+}
+
+CharacterTable
+AutoBalance(const CharacterTable& start, const BalanceOptions& options, const uint64_t seed, const Engine engine, BalanceScore& score, const std::function<void(int, const BalanceScore&, uint64_t)>& progress) {
+    const std::vector<BalanceKnob> knobs = MakeKnobs();
+
+    CharacterTable best = start;
+    score               = EvaluateCharacterTables({best}, options, seed, engine).front();
+    uint64_t evaluated  = 1;
+    if (progress) progress(0, score, evaluated);
+
+    for (int generation = 1; generation <= options.generations && score.loss > 0.; ++generation) {
+        std::vector<CharacterTable> variants;
+        if (options.grid) {
+            for (const BalanceKnob& knob : knobs) {
+                for (const int steps : {-1, 1}) {
+                    CharacterTable variant = best;
+                    if (Adjust(variant, knob, steps)) variants.push_back(variant);
+                }
+            }
+        } else {
+            // 每个变体同时调整 1 ~ 3 个参数，每个参数 ±1 或 ±2 步
+            RandomStream stream(seed, kBalanceStream, static_cast<uint64_t>(generation));
+            while (static_cast<int>(variants.size()) < options.variants) {
+                CharacterTable variant = best;
+                bool changed           = false;
+                for (int k = stream.NextInt(1, 3); k > 0; --k) {
+                    const BalanceKnob& knob = knobs[static_cast<std::size_t>(stream.NextInt(0, static_cast<int>(knobs.size()) - 1))];
+                    const int steps         = stream.NextInt(1, 2) * (stream.NextInt(0, 1) == 0 ? -1 : 1);
+                    changed |= Adjust(variant, knob, steps);
+                }
+                if (changed) variants.push_back(variant);
+            }
+        }
+
+        // 当前最优表与本代的变体在本代的种子上一起重新评估，比较仍使用共同随机数
+        std::vector<CharacterTable> candidates = {best};
+        candidates.insert(candidates.end(), variants.begin(), variants.end());
+        const std::vector<BalanceScore> scores = EvaluateCharacterTables(candidates, options, GenerationSeed(seed, generation), engine);
+        evaluated += candidates.size();
+
+        score               = scores.front();
+        const auto winner   = std::min_element(scores.begin() + 1, scores.end(), [](const BalanceScore& lhs, const BalanceScore& rhs) { return lhs.loss < rhs.loss; });
+        const bool improved = winner != scores.end() && winner->loss < score.loss;
+        if (improved) {
+            best  = candidates[static_cast<std::size_t>(winner - scores.begin())];
+            score = *winner;
+        }
+        if (progress) progress(generation, score, evaluated);
+
+        // 网格枚举的变体只取决于当前最优表，没有改进时不再继续
+        if (options.grid && !improved) break;
+    }
+    return best;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "character_table.h"
+#include "engine.h"
+
+// 自动平衡的搜索设置：目标是两两对局中 c0 的胜率（平局计半场）都落在 [low, high] 内
+struct BalanceOptions {
+    uint64_t times  = 20000;  // 每个变体每个对局的场次
+    int generations = 20;
+    int variants    = 32;     // 随机扰动时每代的变体数
+    bool grid       = false;  // 每代改为枚举每个参数单独增减一步的全部变体
+    double low      = 0.45;
+    double high     = 0.55;
+};
+
+// 一张数值表的评估结果，win_rates 与 MakeMatchupTasks(times, false) 的顺序一致
+struct BalanceScore {
+    double loss  = 0.;  // 各对局胜率超出目标区间部分的平方和
+    double worst = 0.;  // 离目标区间最远的对局的距离
+    int in_band  = 0;   // 落在目标区间内的对局数
+    std::vector<double> win_rates;
+};
+
+// 所有数值表的所有对局交给同一个调度器并行完成；各数值表使用同一种子和相同的试验序号，即共同随机数，
+// 两张表的得分之差只来自数值本身而不是抽样噪声
+std::vector<BalanceScore>
+EvaluateCharacterTables(const std::vector<CharacterTable>& tables, const BalanceOptions& options, uint64_t seed, Engine engine = Engine::BATCH);
+
+// 爬山搜索：每代由当前最优表生成一批变体，与当前最优表一起以该代的种子评估（各代种子不同，同一代内为共同随机数），
+// 取损失最小者，优于当前最优时替换；progress 在每代结束时以 (代数, 当前最优得分, 累计评估的变体数) 调用，score 返回最终最优表的得分
+CharacterTable
+AutoBalance(const CharacterTable& start, const BalanceOptions& options, uint64_t seed, Engine engine, BalanceScore& score, const std::function<void(int, const BalanceScore&, uint64_t)>& progress = {});
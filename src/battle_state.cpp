@@ -0,0 +1,118 @@
+#include "battle_state.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "random.h"
+#include "thread_pool.h"
+
+// 每个工作项包含的续战场次
+constexpr uint64_t kBranchesPerItem = 1 << 14;
+
+// 派生续战随机数流的编号，与各对局的 matchup 编号不重叠
+constexpr uint64_t kBranchStream = 0xB7A4C1E9D3F5062Bull;
+
+static uint64_t
+BranchStream(const BattleState& state) {
+    int32_t words[2 * sizeof(FighterState) / sizeof(int32_t)];
+    std::memcpy(words, state.fighters, sizeof(words));
+
+    uint64_t hash = Mix64(kBranchStream ^ static_cast<uint64_t>(state.round));
+    hash          = Mix64(hash ^ (static_cast<uint64_t>(state.characters[0]) << 8 | state.characters[1]));
+    for (const int32_t word : words) hash = Mix64(hash ^ static_cast<uint32_t>(word));
+    return hash;
+}
+
+using SnapshotFn = bool (*)(BattleState& state, uint64_t seed, uint64_t trial, int round);
+
+template <Character C0, Character C1, bool P0First>
+struct SnapshotKernel {
+    static bool Run(BattleState& state, const uint64_t seed, const uint64_t trial, const int round) {
+        constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+        SeedTrial(seed, matchup, trial);
+        CharacterType<C0> p_0;
+        CharacterType<C1> p_1;
+
+        // 达到 round 仍未分出胜负时 RunBattle 记为平局
+        const BattleOutcome outcome = P0First ? RunBattle(p_0, p_1, round) : RunBattle(p_1, p_0, round);
+        if (!outcome.draw) return false;
+
+        state.fighters[0]   = CaptureFighter(p_0);
+        state.fighters[1]   = CaptureFighter(p_1);
+        state.round         = round;
+        state.characters[0] = static_cast<uint8_t>(C0);
+        state.characters[1] = static_cast<uint8_t>(C1);
+        return true;
+    }
+};
+
+using BranchFn = void (*)(MatchupResult& result, const BattleState& state, uint64_t seed, uint64_t stream, uint64_t begin, uint64_t end);
+
+template <Character C0, Character C1, bool P0First>
+struct BranchKernel {
+    static void Run(MatchupResult& result, const BattleState& state, const uint64_t seed, const uint64_t stream, const uint64_t begin, const uint64_t end) {
+        using T0 = CharacterType<C0>;
+        using T1 = CharacterType<C1>;
+
+        const int max_rounds = MaxRounds();
+
+        // 局面只展开一次，之后每场续战从这份副本复制
+        T0 initial_0;
+        T1 initial_1;
+        RestoreFighter(state.fighters[0], initial_0);
+        RestoreFighter(state.fighters[1], initial_1);
+
+        T0 p_0;
+        T1 p_1;
+
+        for (uint64_t k = begin; k < end; ++k) {
+            SeedTrial(seed, stream, k);
+
+            p_0 = initial_0;
+            p_1 = initial_1;
+
+            if constexpr (P0First) {
+                Accumulate(result, RunBattle(p_0, p_1, max_rounds, state.round + 1), true);
+            } else {
+                Accumulate(result, RunBattle(p_1, p_0, max_rounds, state.round + 1), false);
+            }
+        }
+    }
+};
+
+constexpr auto kSnapshotKernels = MakeKernelTable<SnapshotFn, SnapshotKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+constexpr auto kBranchKernels   = MakeKernelTable<BranchFn, BranchKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+bool
+SnapshotBattle(const Character c0, const Character c1, const uint64_t seed, const uint64_t trial, const int round, BattleState& state) {
+    return kSnapshotKernels[KernelIndex(c0, c1, *g_character_table)](state, seed, trial, round);
+}
+
+MatchupResult
+BranchBattle(const BattleState& state, const uint64_t seed, const uint64_t branches) {
+    ThreadPool& pool                  = ThreadPool::Instance();
+    const CharacterTable* const table = g_character_table;
+    const BranchFn kernel             = kBranchKernels[KernelIndex(state.C0(), state.C1(), *table)];
+    const uint64_t stream             = BranchStream(state);
+
+    std::atomic<uint64_t> next_begin{0};
+    std::vector<MatchupResult> worker_results(static_cast<std::size_t>(pool.NumThreads()));
+
+    pool.Run([&](const int worker) {
+        const CharacterTable* const saved_table = g_character_table;
+        g_character_table                       = table;
+
+        for (uint64_t begin = next_begin.fetch_add(kBranchesPerItem); begin < branches; begin = next_begin.fetch_add(kBranchesPerItem)) {
+            kernel(worker_results[static_cast<std::size_t>(worker)], state, seed, stream, begin, std::min(begin + kBranchesPerItem, branches));
+        }
+
+        g_character_table = saved_table;
+    });
+
+    MatchupResult result;
+    for (const auto& worker_result : worker_results) result += worker_result;
+    return result;
+}
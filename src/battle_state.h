@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "character.h"
+#include "engine.h"
+#include "player.h"
+
+// 一方的全部可变状态；名字、速度、数值表指针等在同一张数值表下对每个角色都相同，不必保存
+struct FighterState {
+    float hit_rate;
+    int32_t hit;
+    int32_t def;
+    int32_t atk;
+    int32_t buff_opponent;
+    int32_t buff_charm;
+    int32_t extra;  // 子类的私有状态，即 ExtraState()
+};
+
+// 与 AttackOn 一样按具体类型调用
+template <class T>
+FighterState
+CaptureFighter(const T& player) {
+    return {player.hit_rate, player.hit, player.def, player.atk, player.buff_opponent, player.buff_charm, player.ExtraState()};
+}
+
+// player 须是按同一张数值表构造的同一角色
+template <class T>
+void
+RestoreFighter(const FighterState& state, T& player) {
+    player.SetHitRate(state.hit_rate);
+    player.hit           = state.hit;
+    player.def           = state.def;
+    player.atk           = state.atk;
+    player.buff_opponent = state.buff_opponent;
+    player.buff_charm    = state.buff_charm;
+    player.RestoreExtraState(state.extra);
+}
+
+// 一场战斗在某回合结束时的完整局面，双方的状态拼在一个缓存行内，可以直接按字节复制和保存
+struct BattleState {
+    FighterState fighters[2];  // 0 为 p0
+    int32_t round;             // 已经结束的回合数，续战从 round + 1 回合开始
+    uint8_t characters[2];
+
+    [[nodiscard]] Character C0() const { return static_cast<Character>(characters[0]); }
+
+    [[nodiscard]] Character C1() const { return static_cast<Character>(characters[1]); }
+};
+
+static_assert(std::is_trivially_copyable_v<BattleState> && sizeof(BattleState) <= kCacheLineSize);
+
+// 进行 c0 对 c1 的第 trial 号试验（与 RunMatchups 中同一种子的同号试验完全相同）到第 round 回合结束，
+// 战斗在此之前已经结束时返回 false；先手与双方属性取自当前线程的数值表
+bool
+SnapshotBattle(Character c0, Character c1, uint64_t seed, uint64_t trial, int round, BattleState& state);
+
+// 从 state 出发在线程池上进行 branches 场续战，直到分出胜负或达到回合上限；各场续战的随机数流由 seed 与局面派生，
+// 与快照之前的抽取无关。结果中的 rounds 包括快照之前的回合，须在拍摄快照时的数值表下调用
+MatchupResult
+BranchBattle(const BattleState& state, uint64_t seed, uint64_t branches);
@@ -0,0 +1,19 @@
+#pragma once
+
+enum class Character : int {
+    KIANA,     // 琪亚娜
+    MEI,       // 芽衣
+    BRONYA,    // 布洛妮娅
+    HIMEKO,    // 姬子
+    RITA,      // 丽塔
+    SAKURA,    // 八重樱&卡莲
+    CORVUS,    // 渡鸦
+    THERESA,   // 德莉莎
+    OLENYEVA,  // 萝莎莉娅&莉莉娅
+    SEELE,     // 希尔
+    DURANDAL,  // 幽兰黛尔
+    FU_HUA,    // 符华
+    NUM_OF_CHARACTER
+};
+
+constexpr int kNumOfCharacter = static_cast<int>(Character::NUM_OF_CHARACTER);
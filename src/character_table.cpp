@@ -0,0 +1,211 @@
+#include "character_table.h"
+
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "player.h"
+#include "random.h"
+
+static CharacterTable g_default_table = kDefaultCharacterTable;
+
+void
+SetCharacterTable(const CharacterTable& table) {
+    g_default_table   = table;
+    g_character_table = &g_default_table;
+}
+
+const CharacterTable&
+GetCharacterTable() {
+    return g_default_table;
+}
+
+const char*
+CharacterKey(const Character character) {
+    // clang-format off
+    switch (character) {
+    case Character::KIANA:    return "KIANA";
+    case Character::MEI:      return "MEI";
+    case Character::BRONYA:   return "BRONYA";
+    case Character::HIMEKO:   return "HIMEKO";
+    case Character::RITA:     return "RITA";
+    case Character::SAKURA:   return "SAKURA";
+    case Character::CORVUS:   return "CORVUS";
+    case Character::THERESA:  return "THERESA";
+    case Character::OLENYEVA: return "OLENYEVA";
+    case Character::SEELE:    return "SEELE";
+    case Character::DURANDAL: return "DURANDAL";
+    case Character::FU_HUA:   return "FU_HUA";
+    default: return "";
+    }
+    // clang-format on
+}
+
+bool
+ParseCharacter(const std::string_view key, Character& character) {
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        if (key == CharacterKey(static_cast<Character>(c))) {
+            character = static_cast<Character>(c);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+ParseCharacterArg(const std::string_view arg, Character& character) {
+    std::string key(arg);
+    for (char& ch : key) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+    if (ParseCharacter(key, character)) return true;
+
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        if (arg == GetPlayer(static_cast<Character>(c))->name) {
+            character = static_cast<Character>(c);
+            return true;
+        }
+    }
+
+    char* end     = nullptr;
+    const long id = std::strtol(key.c_str(), &end, 10);
+    if (key.empty() || *end != '\0' || id < 0 || id >= kNumOfCharacter) return false;
+    character = static_cast<Character>(id);
+    return true;
+}
+
+// 八项数值加上由 skill_rate 派生的两个阈值；新增数值项时也要计入散列
+static_assert(sizeof(CharacterParams) == 8 * 4 + 2 * 8, "CharacterDefinitionHash must hash every field of CharacterParams");
+
+uint64_t
+CharacterDefinitionHash(const Character character, const CharacterTable& table) {
+    const CharacterParams& params = table[character];
+
+    uint32_t skill_rate_bits;
+    memcpy(&skill_rate_bits, &params.skill_rate, sizeof(skill_rate_bits));
+    uint32_t damage_taken_bits;
+    memcpy(&damage_taken_bits, &params.damage_taken, sizeof(damage_taken_bits));
+
+    uint64_t hash = Mix64(static_cast<uint64_t>(character) << 32 | static_cast<uint32_t>(kCharacterRevision[static_cast<int>(character)]));
+    for (const uint64_t field : {static_cast<uint64_t>(params.hit), static_cast<uint64_t>(params.def), static_cast<uint64_t>(params.atk), static_cast<uint64_t>(params.spd), static_cast<uint64_t>(params.period), static_cast<uint64_t>(skill_rate_bits), static_cast<uint64_t>(damage_taken_bits), static_cast<uint64_t>(params.revive_hit)}) hash = Mix64(hash ^ field);
+    return hash;
+}
+
+// 角色代码假定有周期的必杀技周期至少为 1，没有的恒为 0；减伤倍率在 [0, 1] 内，复活后的血量至少为 1，不使用这两项的角色保持默认值
+static bool
+IsValidParams(const Character character, const CharacterParams& params) {
+    const bool has_period   = kDefaultCharacterTable[character].period > 0;
+    const bool valid_period = has_period ? params.period >= 1 && params.period <= kMaxPeriod : params.period == 0;
+    const bool valid_taken  = character == Character::RITA ? params.damage_taken >= 0.f && params.damage_taken <= 1.f : params.damage_taken == 1.f;
+    const bool valid_revive = character == Character::OLENYEVA ? params.revive_hit >= 1 : params.revive_hit == 0;
+    return params.hit > 0 && params.def >= 0 && params.atk >= 0 && params.spd >= 0 && valid_period && params.skill_rate >= 0.f && params.skill_rate <= 1.f && valid_taken && valid_revive;
+}
+
+bool
+LoadCharacterTable(const char* path, CharacterTable& table) {
+    FILE* in = fopen(path, "r");
+    if (in == nullptr) {
+        fprintf(stderr, "无法打开数值表: %s\n", path);
+        return false;
+    }
+
+    CharacterTable loaded = table;
+    char line[256];
+    for (int line_number = 1; fgets(line, sizeof(line), in) != nullptr; ++line_number) {
+        if (char* comment = strchr(line, '#')) *comment = '\0';
+
+        char key[32];
+        CharacterParams params;
+        const int fields = sscanf(line, "%31s %d %d %d %d %d %f %f %d", key, &params.hit, &params.def, &params.atk, &params.spd, &params.period, &params.skill_rate, &params.damage_taken, &params.revive_hit);
+        if (fields <= 0) continue;
+
+        // 省略最后两列的行（本项加入之前写出的数值表）取该角色的默认值
+        Character character{};
+        const bool known = ParseCharacter(key, character);
+        if (known && fields == 7) {
+            params.damage_taken = kDefaultCharacterTable[character].damage_taken;
+            params.revive_hit   = kDefaultCharacterTable[character].revive_hit;
+        }
+        if ((fields != 7 && fields != 9) || !known || !IsValidParams(character, params)) {
+            fprintf(stderr, "%s:%d: 无效的数值行\n", path, line_number);
+            fclose(in);
+            return false;
+        }
+        params.SetSkillRate(params.skill_rate);
+        loaded[character] = params;
+    }
+    fclose(in);
+
+    table = loaded;
+    return true;
+}
+
+bool
+ApplyParamPatch(const std::string_view patch, CharacterTable& table) {
+    const std::size_t dot   = patch.find('.');
+    const std::size_t equal = patch.find('=', dot == std::string_view::npos ? 0 : dot);
+    Character character{};
+    if (dot == std::string_view::npos || equal == std::string_view::npos || !ParseCharacterArg(patch.substr(0, dot), character)) {
+        fprintf(stderr, "无效的数值改动: %.*s（应为 <角色>.<项>=<值>）\n", static_cast<int>(patch.size()), patch.data());
+        return false;
+    }
+
+    const std::string_view field = patch.substr(dot + 1, equal - dot - 1);
+    const std::string value(patch.substr(equal + 1));
+    char* end           = nullptr;
+    const double number = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0') {
+        fprintf(stderr, "无效的数值改动: %.*s（值不是数字）\n", static_cast<int>(patch.size()), patch.data());
+        return false;
+    }
+    // 转换之前先检查范围，NaN 和超出目标类型的值转换为 int / float 是未定义行为；概率的合理范围本来就在 [0, 1] 内
+    const bool is_rate = field == "skill_rate" || field == "damage_taken";
+    if (!std::isfinite(number) || number < (is_rate ? 0. : static_cast<double>(INT_MIN)) || number > (is_rate ? 1. : static_cast<double>(INT_MAX))) {
+        fprintf(stderr, "无效的数值改动: %.*s（超出该项的取值范围）\n", static_cast<int>(patch.size()), patch.data());
+        return false;
+    }
+
+    CharacterParams params = table[character];
+    if (field == "hit") {
+        params.hit = static_cast<int>(number);
+    } else if (field == "def") {
+        params.def = static_cast<int>(number);
+    } else if (field == "atk") {
+        params.atk = static_cast<int>(number);
+    } else if (field == "spd") {
+        params.spd = static_cast<int>(number);
+    } else if (field == "period") {
+        params.period = static_cast<int>(number);
+    } else if (field == "skill_rate") {
+        params.skill_rate = static_cast<float>(number);
+    } else if (field == "damage_taken") {
+        params.damage_taken = static_cast<float>(number);
+    } else if (field == "revive_hit") {
+        params.revive_hit = static_cast<int>(number);
+    } else {
+        fprintf(stderr, "无效的数值改动: %.*s（没有 %.*s 这一项）\n", static_cast<int>(patch.size()), patch.data(), static_cast<int>(field.size()), field.data());
+        return false;
+    }
+    if (!is_rate && number != static_cast<double>(static_cast<int>(number))) {
+        fprintf(stderr, "无效的数值改动: %.*s（该项为整数）\n", static_cast<int>(patch.size()), patch.data());
+        return false;
+    }
+    if (!IsValidParams(character, params)) {
+        fprintf(stderr, "无效的数值改动: %.*s（超出该项的取值范围）\n", static_cast<int>(patch.size()), patch.data());
+        return false;
+    }
+
+    params.SetSkillRate(params.skill_rate);
+    table[character] = params;
+    return true;
+}
+
+void
+WriteCharacterTable(FILE* out, const CharacterTable& table) {
+    fprintf(out, "# 角色       hit  def  atk  spd  period  skill_rate  damage_taken  revive_hit\n");
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        const CharacterParams& params = table.params[c];
+        fprintf(out, "%-10s %5d %4d %4d %4d %7d  %-10g  %-12g  %d\n", CharacterKey(static_cast<Character>(c)), params.hit, params.def, params.atk, params.spd, params.period, static_cast<double>(params.skill_rate), static_cast<double>(params.damage_taken), params.revive_hit);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+#include "character.h"
+#include "random.h"
+
+// 角色的可调数值：基础属性、必杀技周期、技能概率和个别角色的技能数值，平衡性实验只需改动这张表
+struct CharacterParams {
+    int hit            = 100;
+    int def            = 0;
+    int atk            = 0;
+    int spd            = 0;
+    int period         = 0;    // 每 period 回合释放一次必杀技，不超过 kMaxPeriod；0 表示没有按回合释放的必杀技
+    float skill_rate   = 0.f;  // 技能触发概率；姬子、符华为必杀技降低的命中率，萝莎莉娅&莉莉娅为必杀技造成 233 点伤害的概率，0 表示不使用
+    float damage_taken = 1.f;  // 丽塔释放过必杀技后受到伤害的倍率（四舍五入），其他角色恒为 1
+    int revive_hit     = 0;    // 萝莎莉娅&莉莉娅复活后的血量，其他角色恒为 0
+
+    // 由 skill_rate 派生的 RandomAtMost / RandomBelow 判定阈值，角色出招时直接与随机位比较；只能经由 SetSkillRate 与 skill_rate 一起修改
+    uint64_t skill_at_most = RandomStream::AtMostThreshold(0.f);
+    uint64_t skill_below   = RandomStream::BelowThreshold(0.f);
+
+    constexpr void SetSkillRate(const float rate) {
+        skill_rate    = rate;
+        skill_at_most = RandomStream::AtMostThreshold(rate);
+        skill_below   = RandomStream::BelowThreshold(rate);
+    }
+};
+
+// 必杀技周期的上限；角色每回合判断是否释放必杀技，以查表的乘法代替取模
+constexpr int kMaxPeriod = 16;
+
+// round % period == 0 当且仅当 round * kPeriodMagic[period] <= kPeriodMagic[period] - 1（Lemire 的整除判定，对 32 位 round 成立）
+inline constexpr auto kPeriodMagic = [] {
+    std::array<uint64_t, kMaxPeriod + 1> magic{};
+    for (int period = 1; period <= kMaxPeriod; ++period) magic[static_cast<std::size_t>(period)] = UINT64_MAX / static_cast<uint64_t>(period) + 1;
+    return magic;
+}();
+
+struct CharacterTable {
+    CharacterParams params[kNumOfCharacter];
+
+    constexpr const CharacterParams& operator[](const Character character) const { return params[static_cast<int>(character)]; }
+
+    constexpr CharacterParams& operator[](const Character character) { return params[static_cast<int>(character)]; }
+};
+
+// 按各项的 skill_rate 算好判定阈值
+constexpr CharacterTable
+WithThresholds(CharacterTable table) {
+    for (CharacterParams& params : table.params) params.SetSkillRate(params.skill_rate);
+    return table;
+}
+
+// 原版数值，与 Character 枚举顺序一致
+// clang-format off
+inline constexpr CharacterTable kDefaultCharacterTable = WithThresholds({{
+    {100, 11, 24, 23, 2, 0.35f},          // 琪亚娜
+    {100, 12, 22, 30, 2, 0.3f},           // 芽衣
+    {100, 10, 21, 20, 3, 0.25f},          // 布洛妮娅
+    {100, 9,  23, 12, 2, 0.35f},          // 姬子
+    {100, 11, 26, 17, 4, 0.35f, 0.4f},    // 丽塔
+    {100, 9,  20, 18, 2, 0.3f},           // 八重樱&卡莲
+    {100, 14, 23, 14, 3, 0.25f},          // 渡鸦
+    {100, 12, 19, 22, 3, 0.3f},           // 德莉莎
+    {100, 10, 18, 10, 0, 0.5f, 1.f, 20},  // 萝莎莉娅&莉莉娅
+    {100, 13, 23, 26, 0, 0.f},            // 希儿
+    {100, 10, 19, 15, 0, 0.16f},          // 幽兰黛尔
+    {100, 15, 17, 16, 3, 0.25f},          // 符华
+}});
+// clang-format on
+
+// 各角色出招逻辑的版本号：修改某个角色的技能实现后递增对应一项，结果缓存、分片与残局表中涉及该角色的项随之失效
+inline constexpr int kCharacterRevision[kNumOfCharacter] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+// 当前线程构造角色时读取的数值表；调度器在每个工作项开始前按对局设置，角色对象构造后只持有其中一项的指针
+inline thread_local const CharacterTable* g_character_table = &kDefaultCharacterTable;
+
+// 未单独指定数值表的对局使用的进程默认数值表，只应在没有对局运行时修改；同时设置调用线程的 g_character_table
+void
+SetCharacterTable(const CharacterTable& table);
+
+const CharacterTable&
+GetCharacterTable();
+
+// 数值表文件中的角色名，即枚举名
+const char*
+CharacterKey(Character character);
+
+bool
+ParseCharacter(std::string_view key, Character& character);
+
+// 命令行与查询服务中的角色，可以用枚举名（不区分大小写）、中文名或编号指定
+bool
+ParseCharacterArg(std::string_view arg, Character& character);
+
+// 角色定义（出招逻辑的版本号与 table 中的数值）的散列，两个角色的定义相同时对局结果才相同
+uint64_t
+CharacterDefinitionHash(Character character, const CharacterTable& table);
+
+// 每行一个角色：角色名 hit def atk spd period skill_rate [damage_taken revive_hit]，# 之后为注释，省略最后两列时取默认数值；未出现的角色保持 table 中原有的数值。
+// 出错时在 stderr 给出行号并返回 false
+bool
+LoadCharacterTable(const char* path, CharacterTable& table);
+
+// 按 "<角色>.<项>=<值>" 修改 table 中的一项，项为数值表文件的列名 hit / def / atk / spd / period / skill_rate / damage_taken / revive_hit，
+// 角色的写法与 ParseCharacterArg 相同。出错时在 stderr 说明原因并返回 false，table 不变
+bool
+ApplyParamPatch(std::string_view patch, CharacterTable& table);
+
+// 写出的文本可由 LoadCharacterTable 原样读回
+void
+WriteCharacterTable(FILE* out, const CharacterTable& table);
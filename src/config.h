@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdio>
+
+// 替换全局 operator new/delete 以统计试验循环中的堆分配，只用于检查，可由构建系统打开，默认关闭
+#ifndef ENABLE_ALLOC_COUNTER
+#    define ENABLE_ALLOC_COUNTER 0
+#endif
+
+// 战斗事件计数与直方图，可由构建系统覆盖
+#ifndef ENABLE_STATS
+#    define ENABLE_STATS 1
+#endif
+
+// 二进制战斗日志（trace），可由构建系统覆盖，默认关闭
+#ifndef ENABLE_TRACE
+#    define ENABLE_TRACE 0
+#endif
+
+// 批量引擎依赖 GCC / Clang 的向量扩展，其他编译器回退到特化内核；批量引擎按 lane 推进，无法逐场记录日志，trace 构建下同样回退
+#if (defined(__GNUC__) || defined(__clang__)) && !(defined(ENABLE_TRACE) && (ENABLE_TRACE == 1))
+#    define ENABLE_BATCH_ENGINE 1
+#else
+#    define ENABLE_BATCH_ENGINE 0
+#endif
@@ -0,0 +1,409 @@
+#include "dataset.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#if !defined(_WIN32)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "random.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+constexpr char kDatasetMagic[8]         = {'H', 'K', 'B', 'A', 'T', 'T', 'L', 'E'};
+constexpr uint32_t kDatasetVersion      = 1;
+constexpr std::size_t kDatasetAlignment = 64;
+
+// 每个工作项的行数，也是各线程列缓冲区的容量
+constexpr uint64_t kDatasetRowsPerItem = 1 << 15;
+
+static_assert(sizeof(DatasetHeader) == 40 && sizeof(DatasetColumn) == 32 && sizeof(DatasetSegment) == 32, "dataset headers are stored on disk as is");
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+constexpr int kNumOfDatasetColumnWritten = kNumOfDatasetColumn;
+#else
+constexpr int kNumOfDatasetColumnWritten = static_cast<int>(DatasetColumnId::ULT_0);
+#endif
+
+// 每场战斗记录的事件计数，依次对应 ULT / PROC / CHARM / RESURRECT 两列一组
+constexpr int kNumOfDatasetEvent = 4;
+
+const char*
+DatasetColumnName(const DatasetColumnId column) {
+    // clang-format off
+    switch (column) {
+    case DatasetColumnId::C0:          return "c0";
+    case DatasetColumnId::C1:          return "c1";
+    case DatasetColumnId::P0_FIRST:    return "p0_first";
+    case DatasetColumnId::WINNER:      return "winner";
+    case DatasetColumnId::ROUNDS:      return "rounds";
+    case DatasetColumnId::HIT_0:       return "hit_0";
+    case DatasetColumnId::HIT_1:       return "hit_1";
+    case DatasetColumnId::ULT_0:       return "ult_0";
+    case DatasetColumnId::ULT_1:       return "ult_1";
+    case DatasetColumnId::PROC_0:      return "proc_0";
+    case DatasetColumnId::PROC_1:      return "proc_1";
+    case DatasetColumnId::CHARM_0:     return "charm_0";
+    case DatasetColumnId::CHARM_1:     return "charm_1";
+    case DatasetColumnId::RESURRECT_0: return "resurrect_0";
+    case DatasetColumnId::RESURRECT_1: return "resurrect_1";
+    default: return "";
+    }
+    // clang-format on
+}
+
+static ColumnType
+DatasetColumnType(const DatasetColumnId column) {
+    // clang-format off
+    switch (column) {
+    case DatasetColumnId::C0:
+    case DatasetColumnId::C1:
+    case DatasetColumnId::P0_FIRST: return ColumnType::U8;
+    case DatasetColumnId::WINNER:   return ColumnType::I8;
+    case DatasetColumnId::HIT_0:
+    case DatasetColumnId::HIT_1:    return ColumnType::I16;
+    default:                        return ColumnType::U16;
+    }
+    // clang-format on
+}
+
+static uint8_t
+ColumnWidth(const ColumnType type) {
+    return type == ColumnType::U8 || type == ColumnType::I8 ? 1 : 2;
+}
+
+static uint64_t
+AlignUp(const uint64_t offset) {
+    return (offset + kDatasetAlignment - 1) / kDatasetAlignment * kDatasetAlignment;
+}
+
+// 一个工作项的各列，c0 / c1 / p0_first 在工作项内不变，写出时再展开
+struct DatasetBuffer {
+    int8_t winner[kDatasetRowsPerItem];
+    uint16_t rounds[kDatasetRowsPerItem];
+    int16_t hit[2][kDatasetRowsPerItem];
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    uint16_t events[kNumOfDatasetEvent][2][kDatasetRowsPerItem];
+#endif
+    uint8_t constant[kDatasetRowsPerItem];
+};
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+// 从调用线程的 g_battle_stats 读出 character 各类事件的累计次数
+static void
+ReadEvents(const Character character, uint64_t (&counts)[kNumOfDatasetEvent]) {
+    const uint64_t* events = g_battle_stats.events[static_cast<int>(character)];
+    counts[0]              = events[static_cast<int>(StatEvent::ULT)];
+    counts[1]              = events[static_cast<int>(StatEvent::STUN)] + events[static_cast<int>(StatEvent::PARALYZE)] + events[static_cast<int>(StatEvent::REFLECT)];
+    counts[2]              = events[static_cast<int>(StatEvent::CHARM)];
+    counts[3]              = events[static_cast<int>(StatEvent::RESURRECT)];
+}
+#endif
+
+using DatasetKernelFn = void (*)(MatchupResult& result, DatasetBuffer& buffer, uint64_t seed, uint64_t begin, uint64_t end);
+
+// 与特化引擎的 SimulateRange 相同，另把每场战斗写入 buffer 的第 k - begin 行。
+// 事件按发起的角色计数，镜像对局中双方无法区分，全部记在 p0 一侧
+template <Character C0, Character C1, bool P0First>
+struct DatasetKernel {
+    static void Run(MatchupResult& result, DatasetBuffer& buffer, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+        constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+        using T0 = CharacterType<C0>;
+        using T1 = CharacterType<C1>;
+
+        const int max_rounds = MaxRounds();
+
+        const T0 initial_0;
+        const T1 initial_1;
+
+        T0 p_0;
+        T1 p_1;
+
+        for (uint64_t k = begin; k < end; ++k) {
+            const auto row = static_cast<std::size_t>(k - begin);
+            SeedTrial(seed, matchup, k);
+
+            p_0 = initial_0;
+            p_1 = initial_1;
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            uint64_t before[2][kNumOfDatasetEvent];
+            ReadEvents(C0, before[0]);
+            ReadEvents(C1, before[1]);
+#endif
+
+            const BattleOutcome outcome = P0First ? RunBattle(p_0, p_1, max_rounds) : RunBattle(p_1, p_0, max_rounds);
+            Accumulate(result, outcome, P0First);
+
+            buffer.winner[row] = static_cast<int8_t>(outcome.draw ? -1 : (outcome.first_win == P0First ? 0 : 1));
+            buffer.rounds[row] = static_cast<uint16_t>(outcome.rounds);
+            buffer.hit[0][row] = static_cast<int16_t>(p_0.hit);
+            buffer.hit[1][row] = static_cast<int16_t>(p_1.hit);
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            uint64_t after[2][kNumOfDatasetEvent];
+            ReadEvents(C0, after[0]);
+            ReadEvents(C1, after[1]);
+            for (int e = 0; e < kNumOfDatasetEvent; ++e) {
+                buffer.events[e][0][row] = static_cast<uint16_t>(std::min<uint64_t>(after[0][e] - before[0][e], 0xFFFF));
+                buffer.events[e][1][row] = C0 == C1 ? 0 : static_cast<uint16_t>(std::min<uint64_t>(after[1][e] - before[1][e], 0xFFFF));
+            }
+#endif
+        }
+    }
+};
+
+constexpr auto kDatasetKernels = MakeKernelTable<DatasetKernelFn, DatasetKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+#if !defined(_WIN32)
+// 写满 bytes 字节，被信号打断或只写了一部分时继续
+static bool
+WriteAt(const int fd, const void* data, std::size_t bytes, uint64_t offset) {
+    const auto* cursor = static_cast<const unsigned char*>(data);
+    while (bytes > 0) {
+        const ssize_t written = pwrite(fd, cursor, bytes, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        cursor += written;
+        bytes -= static_cast<std::size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+// 一个工作项：tasks[task] 的 [begin, end) 号试验，写到从 first_row 开始的行
+struct DatasetItem {
+    std::size_t task;
+    uint64_t begin;
+    uint64_t end;
+    uint64_t first_row;
+};
+
+bool
+ExportDataset(const char* path, const std::vector<MatchupTask>& tasks, const uint64_t seed, std::vector<MatchupResult>& results) {
+    if (MaxRounds() > kDatasetMaxRound) {
+        fprintf(stderr, "导出数据集时回合上限不能超过 %d: %d\n", kDatasetMaxRound, MaxRounds());
+        return false;
+    }
+
+    // 文件头、列与各对局的行段
+    DatasetHeader header{};
+    memcpy(header.magic, kDatasetMagic, sizeof(header.magic));
+    header.version      = kDatasetVersion;
+    header.num_columns  = kNumOfDatasetColumnWritten;
+    header.num_segments = static_cast<uint32_t>(tasks.size());
+    header.max_rounds   = MaxRounds();
+    header.seed         = seed;
+
+    std::vector<DatasetSegment> segments(tasks.size());
+    std::vector<DatasetItem> items;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupTask& task = tasks[t];
+        DatasetSegment& segment = segments[t];
+        segment.c0              = static_cast<uint8_t>(task.c0);
+        segment.c1              = static_cast<uint8_t>(task.c1);
+        segment.p0_first        = static_cast<uint8_t>(KernelIndex(task.c0, task.c1, task.Table()) % 2);
+        segment.begin           = task.begin;
+        segment.first_row       = header.rows;
+        segment.rows            = task.times;
+
+        for (uint64_t begin = 0; begin < task.times; begin += kDatasetRowsPerItem) {
+            items.push_back({t, task.begin + begin, task.begin + std::min(begin + kDatasetRowsPerItem, task.times), header.rows + begin});
+        }
+        header.rows += task.times;
+    }
+
+    DatasetColumn columns[kNumOfDatasetColumn] = {};
+    uint64_t offset                            = AlignUp(sizeof(DatasetHeader) + sizeof(DatasetColumn) * kNumOfDatasetColumnWritten + sizeof(DatasetSegment) * segments.size());
+    for (int c = 0; c < kNumOfDatasetColumnWritten; ++c) {
+        const auto id = static_cast<DatasetColumnId>(c);
+        strncpy(columns[c].name, DatasetColumnName(id), sizeof(columns[c].name) - 1);
+        columns[c].type   = DatasetColumnType(id);
+        columns[c].width  = ColumnWidth(columns[c].type);
+        columns[c].offset = offset;
+        offset            = AlignUp(offset + header.rows * columns[c].width);
+    }
+
+    // 先写到临时文件再替换，中途失败不会留下截断的数据集，也不会损坏原有的文件
+    const std::string temp_path = std::string(path) + ".tmp";
+    const int fd                = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "无法写入数据集文件: %s\n", path);
+        return false;
+    }
+
+    // 先把文件扩展到最终大小，各线程再把自己的行写到各列中对应的位置
+    bool ok = ftruncate(fd, static_cast<off_t>(offset)) == 0 && WriteAt(fd, &header, sizeof(header), 0) && WriteAt(fd, columns, sizeof(DatasetColumn) * kNumOfDatasetColumnWritten, sizeof(header)) &&
+              WriteAt(fd, segments.data(), sizeof(DatasetSegment) * segments.size(), sizeof(header) + sizeof(DatasetColumn) * kNumOfDatasetColumnWritten);
+
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int num_workers = pool.NumThreads();
+
+    std::atomic<std::size_t> next_item{0};
+    std::atomic<bool> failed{!ok};
+    std::vector<MatchupResult> worker_results(static_cast<std::size_t>(num_workers) * tasks.size());
+
+    pool.Run([&](const int worker) {
+        MatchupResult* const worker_result      = &worker_results[static_cast<std::size_t>(worker) * tasks.size()];
+        const CharacterTable* const saved_table = g_character_table;
+        const auto buffer                       = std::make_unique<DatasetBuffer>();
+
+        // 写出一列的 rows 行，数据来自 buffer 中的 data
+        const auto write_column = [&](const DatasetColumnId id, const void* data, const DatasetItem& item) {
+            const DatasetColumn& column = columns[static_cast<int>(id)];
+            if (!WriteAt(fd, data, static_cast<std::size_t>(item.end - item.begin) * column.width, column.offset + item.first_row * column.width)) failed = true;
+        };
+
+        for (std::size_t i = next_item.fetch_add(1); i < items.size() && !failed.load(std::memory_order_relaxed); i = next_item.fetch_add(1)) {
+            const DatasetItem& item = items[i];
+            const MatchupTask& task = tasks[item.task];
+            const auto rows         = static_cast<std::size_t>(item.end - item.begin);
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            g_battle_stats = BattleStats();
+#endif
+            g_character_table = &task.Table();
+            kDatasetKernels[KernelIndex(task.c0, task.c1, task.Table())](worker_result[item.task], *buffer, seed, item.begin, item.end);
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            worker_result[item.task].stats += g_battle_stats;
+#endif
+
+            const DatasetSegment& segment = segments[item.task];
+            std::fill_n(buffer->constant, rows, segment.c0);
+            write_column(DatasetColumnId::C0, buffer->constant, item);
+            std::fill_n(buffer->constant, rows, segment.c1);
+            write_column(DatasetColumnId::C1, buffer->constant, item);
+            std::fill_n(buffer->constant, rows, segment.p0_first);
+            write_column(DatasetColumnId::P0_FIRST, buffer->constant, item);
+
+            write_column(DatasetColumnId::WINNER, buffer->winner, item);
+            write_column(DatasetColumnId::ROUNDS, buffer->rounds, item);
+            write_column(DatasetColumnId::HIT_0, buffer->hit[0], item);
+            write_column(DatasetColumnId::HIT_1, buffer->hit[1], item);
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            for (int e = 0; e < kNumOfDatasetEvent; ++e) {
+                write_column(static_cast<DatasetColumnId>(static_cast<int>(DatasetColumnId::ULT_0) + 2 * e), buffer->events[e][0], item);
+                write_column(static_cast<DatasetColumnId>(static_cast<int>(DatasetColumnId::ULT_1) + 2 * e), buffer->events[e][1], item);
+            }
+#endif
+        }
+
+        g_character_table = saved_table;
+    });
+
+    // 无论成败都要关闭文件
+    ok = close(fd) == 0 && !failed;
+    if (ok) ok = std::rename(temp_path.c_str(), path) == 0;
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        fprintf(stderr, "写入数据集文件失败: %s\n", path);
+        return false;
+    }
+
+    results.assign(tasks.size(), MatchupResult());
+    for (int worker = 0; worker < num_workers; ++worker) {
+        for (std::size_t t = 0; t < tasks.size(); ++t) results[t] += worker_results[static_cast<std::size_t>(worker) * tasks.size() + t];
+    }
+    return true;
+}
+
+BattleDataset::~BattleDataset() {
+    Close();
+}
+
+bool
+BattleDataset::Open(const char* path) {
+    Close();
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "无法打开数据集文件: %s\n", path);
+        return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(DatasetHeader)) {
+        fprintf(stderr, "不是数据集文件: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    const auto bytes = static_cast<std::size_t>(st.st_size);
+    void* address    = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        fprintf(stderr, "无法映射数据集文件: %s\n", path);
+        return false;
+    }
+
+    bytes_    = bytes;
+    base_     = static_cast<const unsigned char*>(address);
+    header_   = static_cast<const DatasetHeader*>(address);
+    columns_  = reinterpret_cast<const DatasetColumn*>(header_ + 1);
+    segments_ = reinterpret_cast<const DatasetSegment*>(columns_ + header_->num_columns);
+
+    bool valid = memcmp(header_->magic, kDatasetMagic, sizeof(kDatasetMagic)) == 0 && header_->version == kDatasetVersion && header_->num_columns <= kNumOfDatasetColumn &&
+                 sizeof(DatasetHeader) + sizeof(DatasetColumn) * header_->num_columns + sizeof(DatasetSegment) * header_->num_segments <= bytes;
+    for (uint32_t c = 0; valid && c < header_->num_columns; ++c) {
+        const DatasetColumn& column = columns_[c];
+        valid = column.name[sizeof(column.name) - 1] == '\0' && column.width == ColumnWidth(column.type) && column.offset % kDatasetAlignment == 0 && column.offset + header_->rows * column.width <= bytes;
+    }
+    for (uint32_t s = 0; valid && s < header_->num_segments; ++s) {
+        const DatasetSegment& segment = segments_[s];
+        valid = segment.c0 < kNumOfCharacter && segment.c1 < kNumOfCharacter && segment.first_row + segment.rows <= header_->rows;
+    }
+    if (!valid) {
+        fprintf(stderr, "不是有效的数据集文件，或版本不受支持: %s\n", path);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void
+BattleDataset::Close() {
+    if (base_ != nullptr) munmap(const_cast<unsigned char*>(base_), bytes_);
+    bytes_    = 0;
+    base_     = nullptr;
+    header_   = nullptr;
+    columns_  = nullptr;
+    segments_ = nullptr;
+}
+#else
+// 数据集依赖 POSIX 的 pwrite 与 mmap
+bool
+ExportDataset(const char* path, [[maybe_unused]] const std::vector<MatchupTask>& tasks, [[maybe_unused]] const uint64_t seed, [[maybe_unused]] std::vector<MatchupResult>& results) {
+    fprintf(stderr, "此平台不支持导出数据集: %s\n", path);
+    return false;
+}
+
+BattleDataset::~BattleDataset() = default;
+
+bool
+BattleDataset::Open(const char* path) {
+    fprintf(stderr, "此平台不支持读取数据集: %s\n", path);
+    return false;
+}
+
+void
+BattleDataset::Close() {}
+#endif
+
+const DatasetColumn*
+BattleDataset::FindColumn(const char* name) const {
+    if (header_ == nullptr) return nullptr;
+    for (uint32_t c = 0; c < header_->num_columns; ++c) {
+        if (strcmp(columns_[c].name, name) == 0) return &columns_[c];
+    }
+    return nullptr;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+// 列的存储类型，均为小端定宽整数
+enum class ColumnType : uint8_t {
+    U8,
+    I8,
+    U16,
+    I16,
+};
+
+// 战斗数据集的各列，每场战斗一行。事件计数列只在以 HONKAI_STATS 编译时写出
+enum class DatasetColumnId : int {
+    C0,           // p0 的角色编号
+    C1,           // p1 的角色编号
+    P0_FIRST,     // p0 是否先手，由双方速度决定
+    WINNER,       // 0 / 1 为 p0 / p1 胜，-1 为平局
+    ROUNDS,       // 结束回合
+    HIT_0,        // 结束时 p0 的剩余血量，倒下时可能为负
+    HIT_1,
+    ULT_0,        // p0 释放必杀技的次数
+    ULT_1,
+    PROC_0,       // p0 触发的眩晕、麻痹、反弹等概率效果的次数
+    PROC_1,
+    CHARM_0,      // p0 使对方陷入魅惑的次数
+    CHARM_1,
+    RESURRECT_0,  // p0 复活的次数
+    RESURRECT_1,
+    NUM_OF_DATASET_COLUMN
+};
+
+constexpr int kNumOfDatasetColumn = static_cast<int>(DatasetColumnId::NUM_OF_DATASET_COLUMN);
+
+// rounds 列为 U16 能记录的最大回合，回合上限超过它时拒绝导出
+constexpr int kDatasetMaxRound = UINT16_MAX;
+
+// 文件依次为 DatasetHeader、num_columns 个 DatasetColumn、num_segments 个 DatasetSegment，
+// 之后每列的全部行连续存放，起始位置按 64 字节对齐，整个文件可以直接映射后按列访问
+struct DatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_columns;
+    uint32_t num_segments;
+    int32_t max_rounds;
+    uint64_t seed;
+    uint64_t rows;
+};
+
+struct DatasetColumn {
+    char name[16];  // 以 '\0' 结尾
+    ColumnType type;
+    uint8_t width;  // 每行的字节数
+    uint8_t reserved[6];
+    uint64_t offset;  // 该列首行在文件中的位置
+};
+
+// 同一对局连续的一段行：第 first_row + i 行为 begin + i 号试验
+struct DatasetSegment {
+    uint8_t c0;
+    uint8_t c1;
+    uint8_t p0_first;
+    uint8_t reserved[5];
+    uint64_t begin;
+    uint64_t first_row;
+    uint64_t rows;
+};
+
+// 用特化引擎完成所有对局，并把每场战斗写成 path 处的列式数据集；各线程把一个工作项的结果填入定宽的列缓冲区，
+// 再直接写到各列中对应的位置，行的顺序与 tasks 和试验序号一致，与线程数无关。
+// 先写到 path.tmp，成功后再改名为 path。返回值与 tasks 一一对应，与同一种子下的普通模拟相同；
+// 无法写入或回合上限超过 kDatasetMaxRound 时在 stderr 说明原因并返回 false
+bool
+ExportDataset(const char* path, const std::vector<MatchupTask>& tasks, uint64_t seed, std::vector<MatchupResult>& results);
+
+// 以只读方式映射的数据集文件
+class BattleDataset {
+public:
+    BattleDataset() = default;
+
+    BattleDataset(const BattleDataset&)            = delete;
+    BattleDataset& operator=(const BattleDataset&) = delete;
+
+    ~BattleDataset();
+
+    // 文件格式不符时在 stderr 说明原因并返回 false
+    bool Open(const char* path);
+
+    void Close();
+
+    [[nodiscard]] const DatasetHeader& Header() const { return *header_; }
+
+    [[nodiscard]] uint64_t Rows() const { return header_ != nullptr ? header_->rows : 0; }
+
+    [[nodiscard]] const DatasetColumn* Columns() const { return columns_; }
+
+    [[nodiscard]] const DatasetSegment* Segments() const { return segments_; }
+
+    // 按名称查找列，没有该列时返回空
+    [[nodiscard]] const DatasetColumn* FindColumn(const char* name) const;
+
+    // 按名称取出一列的全部行；没有该列或 T 的宽度与列不符时返回空
+    template <class T>
+    [[nodiscard]] const T* Column(const char* name) const {
+        const DatasetColumn* column = FindColumn(name);
+        if (column == nullptr || column->width != sizeof(T)) return nullptr;
+        return reinterpret_cast<const T*>(base_ + column->offset);
+    }
+
+private:
+    std::size_t bytes_              = 0;
+    const unsigned char* base_      = nullptr;
+    const DatasetHeader* header_    = nullptr;
+    const DatasetColumn* columns_   = nullptr;
+    const DatasetSegment* segments_ = nullptr;
+};
+
+const char*
+DatasetColumnName(DatasetColumnId column);
@@ -0,0 +1,522 @@
+#include "endgame.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "exact_state_space.h"
+#include "random.h"
+#include "result_cache.h"
+#include "thread_pool.h"
+
+constexpr char kEndgameMagic[8]    = {'H', 'K', 'E', 'N', 'D', 'G', 'A', 'M'};
+constexpr uint32_t kEndgameVersion = 1;
+
+// 每个工作项的试验场次
+constexpr uint64_t kEndgameTrialsPerItem = 1 << 15;
+
+// 文件依次为 EndgameFileHeader 和 num_tables 张表，每张表是一个 EndgameTableHeader 后接 num_entries 个 EndgameEntry
+struct EndgameFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_tables;
+};
+
+struct EndgameTableHeader {
+    uint64_t key;
+    int32_t hit_threshold;
+    int32_t round_period;
+    uint8_t first;
+    uint8_t second;
+    uint8_t reserved[6];
+    uint64_t num_entries;
+};
+
+static_assert(sizeof(EndgameFileHeader) == 16 && sizeof(EndgameTableHeader) == 32, "endgame headers are stored on disk as is");
+static_assert(sizeof(FighterState) * 2 % sizeof(uint64_t) == 0);
+
+// 每回合结束时都可能查表，逐字乘加后只混合一次，比逐字 Mix64 的依赖链短得多
+static uint64_t
+EndgameHash(const FighterState (&fighters)[2], const int32_t phase) {
+    uint64_t words[sizeof(FighterState) * 2 / sizeof(uint64_t)];
+    std::memcpy(words, fighters, sizeof(words));
+
+    uint64_t hash = static_cast<uint32_t>(phase);
+    for (const uint64_t word : words) hash = hash * RandomStream::kGamma + word;
+    return Mix64(hash);
+}
+
+EndgameTable::EndgameTable(const uint64_t key, const Character first, const Character second, const int hit_threshold, const int round_period, std::vector<EndgameEntry> entries)
+    : key_(key), first_(first), second_(second), hit_threshold_(hit_threshold), round_period_(round_period), entries_(std::move(entries)) {
+    // 装载率不超过一半
+    uint64_t capacity = 16;
+    while (capacity < entries_.size() * 2) capacity *= 2;
+    mask_ = capacity - 1;
+    slots_.assign(static_cast<std::size_t>(capacity), UINT32_MAX);
+
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        uint64_t slot = EndgameHash(entries_[i].fighters, entries_[i].phase) & mask_;
+        while (slots_[slot] != UINT32_MAX) slot = (slot + 1) & mask_;
+        slots_[slot] = static_cast<uint32_t>(i);
+    }
+}
+
+const EndgameEntry*
+EndgameTable::Find(const FighterState (&fighters)[2], const int32_t phase) const {
+    if (entries_.empty()) return nullptr;
+
+    for (uint64_t slot = EndgameHash(fighters, phase) & mask_;; slot = (slot + 1) & mask_) {
+        const uint32_t index = slots_[slot];
+        if (index == UINT32_MAX) return nullptr;
+
+        const EndgameEntry& entry = entries_[index];
+        if (entry.phase == phase && std::memcmp(entry.fighters, fighters, sizeof(entry.fighters)) == 0) return &entry;
+    }
+}
+
+// 局面在某个半回合的续战结果，含义与 EndgameEntry 的同名项相同；rounds 为本回合之后还要进行的回合数
+struct EndgameValue {
+    double first_win     = 0.;
+    double second_win    = 0.;
+    double attacker_dead = 0.;
+    double rounds        = 0.;
+};
+
+// 以精确求解器的局面表枚举从开局出发能到达的全部 (局面, 回合数模周期, 出招方)，即半回合节点；
+// 某回合结束时双方血量都不超过 hit_threshold 的节点收入残局表，它们能到达的节点从 0 开始同步迭代 2 * kEndgameHorizon 个半回合，
+// 第 n 次迭代后的值恰为 n 个半回合内分出胜负的概率，在此期间没有分出胜负的概率超过 kEndgameTolerance 的局面不收录
+template <class First, class Second>
+static void
+BuildEndgame(const int hit_threshold, std::vector<EndgameEntry>& entries, int& round_period, uint64_t& states) {
+    RandomScript script;
+    const RandomHooks hooks{&script};
+    g_random_hooks = &hooks;
+
+    ExactStateSpace<First, Second> space(script);
+    round_period      = space.RoundPeriod();
+    const auto period = static_cast<std::size_t>(round_period);
+    const auto phases = period * 2;
+
+    // 节点编号为 局面 * phases + 回合数模周期 * 2 + 出招方，出招方 0 为先手；先手出招后轮到同一回合的后手，后手出招后进入下一回合
+    const auto node_phase = [&](const std::size_t node) { return node % phases / 2; };
+    const auto successor  = [&](const std::size_t node, const uint32_t target) {
+        const std::size_t phase = node_phase(node);
+        return node % 2 == 0 ? target * phases + phase * 2 + 1 : target * phases + (phase + 1) % period * 2;
+    };
+    const auto transitions = [&](const std::size_t node) { return space.Transitions(static_cast<uint32_t>(node / phases), round_period + static_cast<int>(node_phase(node)), node % 2 == 0); };
+
+    // 从开局出发的全部节点，同时记下残局表收录的回合间节点
+    const std::size_t initial = space.Intern(First(), Second()) * phases + 1 % period * 2;
+    std::vector<bool> visited(space.NumStates() * phases);
+    std::vector<std::size_t> stack{initial};
+    std::vector<std::size_t> endgame;
+    visited[initial] = true;
+
+    while (!stack.empty()) {
+        const std::size_t node = stack.back();
+        stack.pop_back();
+
+        const auto state = static_cast<uint32_t>(node / phases);
+        if (node % 2 == 0 && space.FirstOf(state).hit <= hit_threshold && space.SecondOf(state).hit <= hit_threshold) endgame.push_back(node);
+
+        const auto [begin, end] = transitions(node);
+        visited.resize(space.NumStates() * phases);
+        for (auto transition = begin; transition != end; ++transition) {
+            if (transition->target >= kExactTerminal) continue;
+            const std::size_t next = successor(node, transition->target);
+            if (!visited[next]) {
+                visited[next] = true;
+                stack.push_back(next);
+            }
+        }
+    }
+
+    // 残局节点能到达的节点都已展开过，之后取转移不再改变局面表，各节点的转移区间一直有效
+    std::vector<int32_t> closure_index(visited.size(), -1);
+    std::vector<std::size_t> closure;
+    std::vector<std::pair<const ExactTransition*, const ExactTransition*>> ranges;
+    for (const std::size_t node : endgame) {
+        closure_index[node] = static_cast<int32_t>(closure.size());
+        closure.push_back(node);
+    }
+    for (std::size_t i = 0; i < closure.size(); ++i) {
+        ranges.push_back(transitions(closure[i]));
+        for (auto transition = ranges[i].first; transition != ranges[i].second; ++transition) {
+            if (transition->target >= kExactTerminal) continue;
+            const std::size_t next = successor(closure[i], transition->target);
+            if (closure_index[next] < 0) {
+                closure_index[next] = static_cast<int32_t>(closure.size());
+                closure.push_back(next);
+            }
+        }
+    }
+
+    std::vector<EndgameValue> current(closure.size());
+    std::vector<EndgameValue> next(closure.size());
+    for (int step = 0; step < 2 * kEndgameHorizon; ++step) {
+        for (std::size_t i = 0; i < closure.size(); ++i) {
+            EndgameValue value;
+            const double round_end = closure[i] % 2 == 0 ? 0. : 1.;
+            for (auto transition = ranges[i].first; transition != ranges[i].second; ++transition) {
+                const double probability = transition->probability;
+                if (transition->target >= kExactTerminal) {
+                    ((transition->target & 1u) != 0 ? value.first_win : value.second_win) += probability;
+                    value.attacker_dead += (transition->target & 2u) != 0 ? probability : 0.;
+                } else {
+                    const EndgameValue& after = current[static_cast<std::size_t>(closure_index[successor(closure[i], transition->target)])];
+                    value.first_win += probability * after.first_win;
+                    value.second_win += probability * after.second_win;
+                    value.attacker_dead += probability * after.attacker_dead;
+                    value.rounds += probability * (round_end + after.rounds);
+                }
+            }
+            next[i] = value;
+        }
+        current.swap(next);
+    }
+
+    g_random_hooks = nullptr;
+
+    // 残局节点排在 closure 的最前面
+    for (std::size_t i = 0; i < endgame.size(); ++i) {
+        const EndgameValue& value = current[i];
+        if (1. - value.first_win - value.second_win > kEndgameTolerance) continue;
+
+        const auto state = static_cast<uint32_t>(endgame[i] / phases);
+        EndgameEntry entry{};
+        entry.fighters[0]   = CaptureFighter(space.FirstOf(state));
+        entry.fighters[1]   = CaptureFighter(space.SecondOf(state));
+        entry.phase         = static_cast<int32_t>(node_phase(endgame[i]));
+        entry.first_win     = value.first_win;
+        entry.second_win    = value.second_win;
+        entry.attacker_dead = value.attacker_dead;
+        entry.rounds        = 1. + value.rounds;
+        entries.push_back(entry);
+    }
+    states += space.NumStates();
+}
+
+using EndgameBuildFn = void (*)(int hit_threshold, std::vector<EndgameEntry>& entries, int& round_period, uint64_t& states);
+
+template <Character C0, Character C1, bool P0First>
+struct EndgameBuildKernel {
+    static void Run(const int hit_threshold, std::vector<EndgameEntry>& entries, int& round_period, uint64_t& states) {
+        if constexpr (P0First) {
+            BuildEndgame<CharacterType<C0>, CharacterType<C1>>(hit_threshold, entries, round_period, states);
+        } else {
+            BuildEndgame<CharacterType<C1>, CharacterType<C0>>(hit_threshold, entries, round_period, states);
+        }
+    }
+};
+
+constexpr auto kEndgameBuilders = MakeKernelTable<EndgameBuildFn, EndgameBuildKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+// 读出 path 中的全部表；文件不存在时 tables 为空并返回 true
+static bool
+LoadEndgameFile(const char* path, std::vector<EndgameTable>& tables) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return errno == ENOENT;
+
+    // 各表的项数不能超过文件的剩余部分，文件损坏时不会按错误的项数分配内存
+    long remaining = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    rewind(file);
+
+    EndgameFileHeader header{};
+    bool ok = remaining >= 0 && fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, kEndgameMagic, sizeof(kEndgameMagic)) == 0 && header.version == kEndgameVersion;
+    remaining -= static_cast<long>(sizeof(header));
+
+    for (uint32_t t = 0; ok && t < header.num_tables; ++t) {
+        EndgameTableHeader table_header{};
+        ok = fread(&table_header, sizeof(table_header), 1, file) == 1 && table_header.round_period >= 1 && table_header.first < kNumOfCharacter && table_header.second < kNumOfCharacter;
+        remaining -= static_cast<long>(sizeof(table_header));
+        if (!ok || table_header.num_entries > static_cast<uint64_t>(std::max(0L, remaining)) / sizeof(EndgameEntry)) {
+            ok = false;
+            break;
+        }
+
+        std::vector<EndgameEntry> entries(static_cast<std::size_t>(table_header.num_entries));
+        ok = entries.empty() || fread(entries.data(), sizeof(EndgameEntry), entries.size(), file) == entries.size();
+        remaining -= static_cast<long>(entries.size() * sizeof(EndgameEntry));
+        if (ok) tables.emplace_back(table_header.key, static_cast<Character>(table_header.first), static_cast<Character>(table_header.second), table_header.hit_threshold, table_header.round_period, std::move(entries));
+    }
+
+    fclose(file);
+    return ok;
+}
+
+// 先写到临时文件再替换，中途失败不会损坏原有的表
+static bool
+SaveEndgameFile(const char* path, const std::vector<EndgameTable>& tables) {
+    const std::string temp_path = std::string(path) + ".tmp";
+    FILE* file                  = fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    EndgameFileHeader header{};
+    memcpy(header.magic, kEndgameMagic, sizeof(header.magic));
+    header.version    = kEndgameVersion;
+    header.num_tables = static_cast<uint32_t>(tables.size());
+    bool ok           = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (const auto& table : tables) {
+        const std::vector<EndgameEntry>& entries = table.Entries();
+
+        EndgameTableHeader table_header{};
+        table_header.key           = table.Key();
+        table_header.hit_threshold = table.HitThreshold();
+        table_header.round_period  = table.RoundPeriod();
+        table_header.first         = static_cast<uint8_t>(table.FirstCharacter());
+        table_header.second        = static_cast<uint8_t>(table.SecondCharacter());
+        table_header.num_entries   = entries.size();
+        ok = ok && fwrite(&table_header, sizeof(table_header), 1, file) == 1 && (entries.empty() || fwrite(entries.data(), sizeof(EndgameEntry), entries.size(), file) == entries.size());
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (ok) ok = std::rename(temp_path.c_str(), path) == 0;
+    if (!ok) std::remove(temp_path.c_str());
+    return ok;
+}
+
+uint64_t
+EndgameTables::TableKey(const MatchupTask& task) const {
+    const CharacterTable& table = task.Table();
+    const bool p0_first         = KernelIndex(task.c0, task.c1, table) % 2 == 1;
+
+    uint64_t key = Mix64(static_cast<uint64_t>(kEndgameVersion) << 32 | static_cast<uint32_t>(kEndgameHorizon));
+    key          = Mix64(key ^ kSimulationRevision);
+    key          = Mix64(key ^ CharacterDefinitionHash(p0_first ? task.c0 : task.c1, table));
+    key          = Mix64(key ^ CharacterDefinitionHash(p0_first ? task.c1 : task.c0, table));
+    key          = Mix64(key ^ static_cast<uint64_t>(hit_threshold_));
+    return key;
+}
+
+const EndgameTable*
+EndgameTables::Find(const MatchupTask& task) const {
+    const uint64_t key = TableKey(task);
+    for (const auto& table : tables_) {
+        if (table.Key() == key) return &table;
+    }
+    return nullptr;
+}
+
+bool
+EndgameTables::Prepare(const char* path, const std::vector<MatchupTask>& tasks, EndgameBuildStats& stats) {
+    tables_.clear();
+    if (path != nullptr && !LoadEndgameFile(path, tables_)) {
+        fprintf(stderr, "不是有效的残局表文件: %s\n", path);
+        tables_.clear();
+        return false;
+    }
+
+    // 先后手相同的对局共用一张表，每张缺少的表只建一次
+    std::vector<std::size_t> missing;
+    std::vector<uint64_t> missing_keys;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const uint64_t key = TableKey(tasks[t]);
+        if (Find(tasks[t]) != nullptr || std::find(missing_keys.begin(), missing_keys.end(), key) != missing_keys.end()) continue;
+        missing.push_back(t);
+        missing_keys.push_back(key);
+    }
+
+    std::vector<EndgameTable> built(missing.size());
+    std::atomic<std::size_t> next_table{0};
+    std::atomic<uint64_t> states{0};
+
+    ThreadPool::Instance().Run([&](int) {
+        const CharacterTable* const saved_table = g_character_table;
+        for (std::size_t i = next_table++; i < missing.size(); i = next_table++) {
+            const MatchupTask& task = tasks[missing[i]];
+            const std::size_t index = KernelIndex(task.c0, task.c1, task.Table());
+            const bool p0_first     = index % 2 == 1;
+
+            std::vector<EndgameEntry> entries;
+            int round_period  = 1;
+            uint64_t explored = 0;
+            g_character_table = &task.Table();
+            kEndgameBuilders[index](hit_threshold_, entries, round_period, explored);
+
+            built[i] = EndgameTable(missing_keys[i], p0_first ? task.c0 : task.c1, p0_first ? task.c1 : task.c0, hit_threshold_, round_period, std::move(entries));
+            states += explored;
+        }
+        g_character_table = saved_table;
+    });
+
+    std::vector<uint64_t> used;
+    for (const auto& task : tasks) {
+        const uint64_t key = TableKey(task);
+        if (std::find(used.begin(), used.end(), key) != used.end()) continue;
+        used.push_back(key);
+        if (std::find(missing_keys.begin(), missing_keys.end(), key) == missing_keys.end()) {
+            ++stats.loaded;
+            stats.entries += Find(task)->Entries().size();
+        }
+    }
+    for (auto& table : built) {
+        stats.entries += table.Entries().size();
+        tables_.push_back(std::move(table));
+    }
+    stats.built  = static_cast<int>(missing.size());
+    stats.states = states;
+
+    if (path != nullptr && !missing.empty() && !SaveEndgameFile(path, tables_)) {
+        fprintf(stderr, "无法写入残局表文件: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+// 把分出胜负或达到回合上限的一场计入 result，与 Accumulate 相同
+static void
+AccumulateFinished(EndgameResult& result, const BattleOutcome& outcome, const bool p0_first) {
+    if (outcome.draw) {
+        result.draw += 1.;
+    } else if (outcome.first_win == p0_first) {
+        result.p0_win += 1.;
+        result.p0_win_sq += 1.;
+    } else {
+        result.p1_win += 1.;
+    }
+    result.attacker_dead += outcome.attacker_dead ? 1. : 0.;
+    result.rounds += outcome.rounds;
+    result.simulated_rounds += static_cast<uint64_t>(outcome.rounds);
+}
+
+// 与 RunBattle 相同地进行一场战斗，另在每回合结束时查表，收录了该局面就按表中的概率计入 result 并提前结束；
+// paired 时查表后不再结束，续战到底后把表中的 p0 胜率与续战结果之差的平方计入 result
+template <class First, class Second>
+static void
+RunEndgameBattle(EndgameResult& result, const EndgameTable& table, First& first, Second& second, const int max_rounds, const bool p0_first, const bool paired) {
+    // 距回合上限不足 kEndgameHorizon 回合时表中的概率不再适用
+    const int last_lookup = table.Entries().empty() ? 0 : max_rounds - kEndgameHorizon;
+    const int threshold   = table.HitThreshold();
+
+    double table_p0_win = -1.;  // 已查表时为表中的 p0 胜率
+    const auto finish   = [&](const BattleOutcome& outcome) {
+        if (table_p0_win < 0.) {
+            AccumulateFinished(result, outcome, p0_first);
+            return;
+        }
+        const double diff = table_p0_win - (!outcome.draw && outcome.first_win == p0_first ? 1. : 0.);
+        result.p0_diff_sq += diff * diff;
+    };
+
+    ++result.battles;
+    for (int round = 1; round <= max_rounds; ++round) {
+        const auto first_status = first.AttackOn(round, second);
+        if (first_status != Player::AttackResult::ALL_ALIVE) {
+            finish({first_status == Player::AttackResult::DEFENDER_DEAD, first_status == Player::AttackResult::ATTACKER_DEAD, false, round});
+            return;
+        }
+
+        const auto second_status = second.AttackOn(round, first);
+        if (second_status != Player::AttackResult::ALL_ALIVE) {
+            finish({second_status == Player::AttackResult::ATTACKER_DEAD, second_status == Player::AttackResult::ATTACKER_DEAD, false, round});
+            return;
+        }
+
+        if (table_p0_win < 0. && round <= last_lookup && first.hit <= threshold && second.hit <= threshold) {
+            const EndgameEntry* entry = table.Find(first, second, round);
+            if (entry != nullptr) {
+                const double p0_win = p0_first ? entry->first_win : entry->second_win;
+                result.p0_win += p0_win;
+                result.p0_win_sq += p0_win * p0_win;
+                result.p1_win += p0_first ? entry->second_win : entry->first_win;
+                result.draw += std::max(0., 1. - entry->first_win - entry->second_win);
+                result.attacker_dead += entry->attacker_dead;
+                result.rounds += round + entry->rounds;
+                result.simulated_rounds += static_cast<uint64_t>(round);
+                ++result.stopped;
+                if (!paired) return;
+                table_p0_win = p0_win;
+            }
+        }
+    }
+    finish({false, false, true, max_rounds});
+}
+
+using EndgameKernelFn = void (*)(EndgameResult& result, const EndgameTable& table, uint64_t seed, uint64_t begin, uint64_t end, bool paired);
+
+// 与特化引擎的 SimulateRange 相同，每场战斗改由 RunEndgameBattle 进行
+template <Character C0, Character C1, bool P0First>
+struct EndgameKernel {
+    static void Run(EndgameResult& result, const EndgameTable& table, const uint64_t seed, const uint64_t begin, const uint64_t end, const bool paired) {
+        constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+        using T0 = CharacterType<C0>;
+        using T1 = CharacterType<C1>;
+
+        const int max_rounds = MaxRounds();
+
+        const T0 initial_0;
+        const T1 initial_1;
+
+        T0 p_0;
+        T1 p_1;
+
+        for (uint64_t k = begin; k < end; ++k) {
+            SeedTrial(seed, matchup, k);
+
+            p_0 = initial_0;
+            p_1 = initial_1;
+
+            if constexpr (P0First) {
+                RunEndgameBattle(result, table, p_0, p_1, max_rounds, true, paired);
+            } else {
+                RunEndgameBattle(result, table, p_1, p_0, max_rounds, false, paired);
+            }
+        }
+    }
+};
+
+constexpr auto kEndgameKernels = MakeKernelTable<EndgameKernelFn, EndgameKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+// 一个工作项：tasks[task] 的 [begin, end) 号试验
+struct EndgameItem {
+    std::size_t task;
+    uint64_t begin;
+    uint64_t end;
+};
+
+std::vector<EndgameResult>
+RunMatchupsEndgame(const std::vector<MatchupTask>& tasks, const uint64_t seed, const EndgameTables& tables, const bool paired) {
+    static const EndgameTable kNoTable;
+
+    std::vector<const EndgameTable*> task_tables;
+    std::vector<EndgameItem> items;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const EndgameTable* table = tables.Find(tasks[t]);
+        task_tables.push_back(table != nullptr ? table : &kNoTable);
+
+        const uint64_t end = tasks[t].begin + tasks[t].times;
+        for (uint64_t begin = tasks[t].begin; begin < end; begin += kEndgameTrialsPerItem) items.push_back({t, begin, std::min(begin + kEndgameTrialsPerItem, end)});
+    }
+
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int num_workers = pool.NumThreads();
+
+    std::atomic<std::size_t> next_item{0};
+    std::vector<EndgameResult> worker_results(static_cast<std::size_t>(num_workers) * tasks.size());
+
+    pool.Run([&](const int worker) {
+        EndgameResult* const results            = &worker_results[static_cast<std::size_t>(worker) * tasks.size()];
+        const CharacterTable* const saved_table = g_character_table;
+
+        for (std::size_t i = next_item.fetch_add(1); i < items.size(); i = next_item.fetch_add(1)) {
+            const EndgameItem& item = items[i];
+            const MatchupTask& task = tasks[item.task];
+            g_character_table       = &task.Table();
+            kEndgameKernels[KernelIndex(task.c0, task.c1, task.Table())](results[item.task], *task_tables[item.task], seed, item.begin, item.end, paired);
+        }
+
+        g_character_table = saved_table;
+    });
+
+    std::vector<EndgameResult> results(tasks.size());
+    for (int worker = 0; worker < num_workers; ++worker) {
+        for (std::size_t t = 0; t < tasks.size(); ++t) results[t] += worker_results[static_cast<std::size_t>(worker) * tasks.size() + t];
+    }
+    return results;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "battle_state.h"
+#include "engine.h"
+
+// 残局表默认收录的局面：某回合结束时双方血量都不超过该值
+constexpr int kEndgameDefaultHit = 50;
+
+// 只收录 kEndgameHorizon 回合内分出胜负的概率不低于 1 - kEndgameTolerance 的局面；距回合上限不足 kEndgameHorizon 回合时不再查表，
+// 因此表中的概率与按回合上限进行到底的结果至多相差 kEndgameTolerance
+constexpr int kEndgameHorizon      = 64;
+constexpr double kEndgameTolerance = 1e-12;
+
+// 残局表中的一项：某回合结束时的局面，以及从该局面续战的精确结果
+struct EndgameEntry {
+    FighterState fighters[2];  // 0 为先手方
+    int32_t phase;             // 下一回合的回合数模 round_period
+    int32_t reserved;
+    double first_win;      // 先手获胜的概率
+    double second_win;     // 后手获胜的概率
+    double attacker_dead;  // 以出招方被反伤致死结束的概率
+    double rounds;         // 从下一回合起到结束还要进行的期望回合数，结束的一回合计入
+};
+
+static_assert(std::is_trivially_copyable_v<EndgameEntry> && sizeof(EndgameEntry) == 96, "endgame entries are stored on disk as is");
+
+// 一个对局的残局表，各项放在开放寻址散列表中按局面查找。(c0, c1) 与 (c1, c0) 的先后手相同，共用一张表
+class EndgameTable {
+public:
+    EndgameTable() = default;
+
+    EndgameTable(uint64_t key, Character first, Character second, int hit_threshold, int round_period, std::vector<EndgameEntry> entries);
+
+    [[nodiscard]] uint64_t Key() const { return key_; }
+
+    [[nodiscard]] Character FirstCharacter() const { return first_; }
+
+    [[nodiscard]] Character SecondCharacter() const { return second_; }
+
+    [[nodiscard]] int HitThreshold() const { return hit_threshold_; }
+
+    [[nodiscard]] int RoundPeriod() const { return round_period_; }
+
+    [[nodiscard]] const std::vector<EndgameEntry>& Entries() const { return entries_; }
+
+    // 第 round 回合结束时的局面，没有收录时返回空；与 AttackOn 一样按具体类型调用
+    template <class First, class Second>
+    [[nodiscard]] const EndgameEntry* Find(const First& first, const Second& second, const int round) const {
+        const FighterState fighters[2] = {CaptureFighter(first), CaptureFighter(second)};
+        return Find(fighters, (round + 1) % round_period_);
+    }
+
+private:
+    [[nodiscard]] const EndgameEntry* Find(const FighterState (&fighters)[2], int32_t phase) const;
+
+    uint64_t key_      = 0;
+    Character first_   = Character::KIANA;
+    Character second_  = Character::KIANA;
+    int hit_threshold_ = 0;
+    int round_period_  = 1;
+    uint64_t mask_     = 0;
+    std::vector<EndgameEntry> entries_;
+    std::vector<uint32_t> slots_;  // entries_ 的下标，UINT32_MAX 为空位
+};
+
+struct EndgameBuildStats {
+    int loaded       = 0;  // 取自文件的表
+    int built        = 0;  // 本次新建的表
+    uint64_t states  = 0;  // 新建时枚举的局面数
+    uint64_t entries = 0;  // 所用各表的项数之和
+};
+
+// 各对局的残局表，可以缓存在文件中，只为缺少的对局新建
+class EndgameTables {
+public:
+    explicit EndgameTables(int hit_threshold = kEndgameDefaultHit) : hit_threshold_(hit_threshold) {}
+
+    // 从 path 载入已有的表（文件不存在时从空表开始），再在线程池上以精确求解新建 tasks 中缺少的表，有新建的表时写回 path。
+    // 表以双方的角色定义与血量上限为键，数值表改动后自动重建。文件格式不符或无法写入时在 stderr 说明原因并返回 false
+    bool Prepare(const char* path, const std::vector<MatchupTask>& tasks, EndgameBuildStats& stats);
+
+    // 该对局在它自己的数值表下的残局表，没有时返回空
+    [[nodiscard]] const EndgameTable* Find(const MatchupTask& task) const;
+
+    [[nodiscard]] int HitThreshold() const { return hit_threshold_; }
+
+private:
+    [[nodiscard]] uint64_t TableKey(const MatchupTask& task) const;
+
+    int hit_threshold_;
+    std::vector<EndgameTable> tables_;
+};
+
+// 混合模拟的结果：查表结束的战斗按表中的概率计入，因此胜负等计数为小数
+struct alignas(kCacheLineSize) EndgameResult {
+    double p0_win        = 0.;
+    double p1_win        = 0.;
+    double draw          = 0.;
+    double attacker_dead = 0.;
+    double rounds        = 0.;
+    double p0_win_sq     = 0.;  // 每场计入的 p0 胜场数的平方和，用于估计混合模拟本身的标准误
+    double p0_diff_sq    = 0.;  // 配对模式下每场表中的 p0 胜率与续战到底的 p0 胜场数之差的平方和
+
+    uint64_t battles          = 0;
+    uint64_t stopped          = 0;  // 查表提前结束的场次
+    uint64_t simulated_rounds = 0;  // 实际模拟的回合数
+
+    EndgameResult& operator+=(const EndgameResult& other) {
+        p0_win += other.p0_win;
+        p1_win += other.p1_win;
+        draw += other.draw;
+        attacker_dead += other.attacker_dead;
+        rounds += other.rounds;
+        p0_win_sq += other.p0_win_sq;
+        p0_diff_sq += other.p0_diff_sq;
+        battles += other.battles;
+        stopped += other.stopped;
+        simulated_rounds += other.simulated_rounds;
+        return *this;
+    }
+};
+
+// 与特化引擎逐场相同地进行各对局的试验，每回合结束时双方血量都不超过表的上限即查表，收录了该局面就以表中的概率结束这一场。
+// 返回值与 tasks 一一对应，期望与同一种子下的普通模拟相同。
+// paired 时查表的一场照常计入后不提前结束，而是续战到底，只把表中的 p0 胜率与续战结果之差计入 p0_diff_sq；
+// 续战与同一种子下特化引擎的同号试验逐场相同，用于估计混合模拟与完整模拟之差的配对标准误
+std::vector<EndgameResult>
+RunMatchupsEndgame(const std::vector<MatchupTask>& tasks, uint64_t seed, const EndgameTables& tables, bool paired = false);
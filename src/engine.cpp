@@ -0,0 +1,627 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+#include "alloc_counter.h"
+#include "config.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+// 向量类型只在本文件内的 static 函数之间传递，不受调用约定变化影响
+#if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+static int g_max_rounds = kDefaultMaxRounds;
+
+void
+SetMaxRounds(const int max_rounds) {
+    g_max_rounds = max_rounds;
+}
+
+int
+MaxRounds() {
+    return g_max_rounds;
+}
+
+void
+Accumulate(MatchupResult& result, const BattleOutcome& outcome, const bool p0_first) {
+    if (outcome.draw) {
+        ++result.draw;
+    } else if (outcome.first_win == p0_first) {
+        ++result.p0_win;
+    } else {
+        ++result.p1_win;
+    }
+    result.attacker_dead += outcome.attacker_dead ? 1 : 0;
+    result.rounds += static_cast<uint64_t>(outcome.rounds);
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    const int winner = outcome.draw ? -1 : (outcome.first_win == p0_first ? 0 : 1);
+    g_battle_stats.RecordBattle(outcome.rounds, winner, outcome.first_win ? outcome.first_hit : outcome.second_hit);
+#endif
+}
+
+// 以下 Simulate*Range 内核都在调用线程上串行完成 [begin, end) 号试验，并行由调度器负责
+template <Character C0, Character C1, bool P0First>
+static void
+SimulateVirtualRange(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+    constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+    const int max_rounds = MaxRounds();
+
+    FighterSlot slot_0;
+    FighterSlot slot_1;
+
+    for (uint64_t k = begin; k < end; ++k) {
+        SeedTrial(seed, matchup, k);
+        TRACE_TRIAL(matchup, k);
+
+        Player& p_0 = slot_0.Reset(C0);
+        Player& p_1 = slot_1.Reset(C1);
+
+        Accumulate(result, P0First ? RunBattle(p_0, p_1, max_rounds) : RunBattle(p_1, p_0, max_rounds), P0First);
+    }
+}
+
+template <Character C0, Character C1, bool P0First>
+static void
+SimulateRange(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+    constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+    using T0 = CharacterType<C0>;
+    using T1 = CharacterType<C1>;
+
+    const int max_rounds = MaxRounds();
+
+    // 初始属性只从数值表读取一次，每场试验开始时整体复制
+    const T0 initial_0;
+    const T1 initial_1;
+
+    T0 p_0;
+    T1 p_1;
+
+    for (uint64_t k = begin; k < end; ++k) {
+        SeedTrial(seed, matchup, k);
+        TRACE_TRIAL(matchup, k);
+
+        p_0 = initial_0;
+        p_1 = initial_1;
+
+        if constexpr (P0First) {
+            Accumulate(result, RunBattle(p_0, p_1, max_rounds), true);
+        } else {
+            Accumulate(result, RunBattle(p_1, p_0, max_rounds), false);
+        }
+    }
+}
+
+#if defined(ENABLE_BATCH_ENGINE) && (ENABLE_BATCH_ENGINE == 1)
+// 批量引擎同时推进 kBatchWidth * kBatchGroups 场战斗，每条 lane 保存一场战斗的状态（SoA），
+// 所有分支都改写为掩码运算，由编译器映射到 AVX2 / AVX-512 指令。
+// 64 位随机数状态每组占 kBatchWidth * 8 字节，超过一个 512 位寄存器时 GCC 会把选择运算标量化，所以宽度取 8
+constexpr int kBatchWidth  = 8;
+constexpr int kBatchGroups = 2;
+
+using BatchInt   = int32_t __attribute__((vector_size(kBatchWidth * sizeof(int32_t))));
+using BatchFloat = float __attribute__((vector_size(kBatchWidth * sizeof(float))));
+using BatchU32   = uint32_t __attribute__((vector_size(kBatchWidth * sizeof(uint32_t))));
+using BatchI64   = int64_t __attribute__((vector_size(kBatchWidth * sizeof(int64_t))));
+using BatchU64   = uint64_t __attribute__((vector_size(kBatchWidth * sizeof(uint64_t))));
+
+// 目前只支持不涉及魅惑、麻痹等跨角色状态的角色
+constexpr bool
+IsBatchSupported(const Character character) {
+    return character == Character::HIMEKO || character == Character::SAKURA || character == Character::SEELE || character == Character::DURANDAL || character == Character::FU_HUA;
+}
+
+struct BatchFighter {
+    BatchInt hit;
+    BatchInt def;
+    BatchInt atk;
+    BatchInt status;  // 希儿的形态
+    BatchInt phase;   // round % RoundPeriod()，为 0 的回合释放必杀技
+    BatchFloat hit_rate;
+};
+
+struct BatchLanes {
+    BatchFighter fighter[2];  // 0 为先手方
+    BatchU64 key;
+    BatchU64 counter;
+    BatchInt round;
+};
+
+// 与 RandomStream 相同的抽取序列（逐次计算，不分组缓冲），只有 mask 内的 lane 推进计数器
+static BatchU32
+BatchNextBits(BatchLanes& lanes, const BatchInt mask) {
+    const BatchU64 counter = lanes.counter + RandomStream::kGamma;
+    const BatchU64 bits    = Mix64(lanes.key + counter) >> 32;
+    lanes.counter          = __builtin_convertvector(mask, BatchI64) ? counter : lanes.counter;
+    return __builtin_convertvector(bits, BatchU32);
+}
+
+static BatchFloat
+BatchNextFloat(BatchLanes& lanes, const BatchInt mask) {
+    return __builtin_convertvector(BatchNextBits(lanes, mask) >> 8, BatchFloat) * 0x1p-24f;
+}
+
+static bool
+BatchAny(const BatchInt mask) {
+    int32_t any = 0;
+    for (int lane = 0; lane < kBatchWidth; ++lane) any |= mask[lane];
+    return any != 0;
+}
+
+// 与 RandomStream::BoundedInt 相同的拒绝采样，被拒绝的 lane 各自重抽，直到所有 lane 都被接受
+static BatchInt
+BatchNextInt(BatchLanes& lanes, const BatchInt mask, const int min_value, const int max_value) {
+    const auto range  = static_cast<uint32_t>(static_cast<int64_t>(max_value) - min_value + 1);
+    const auto reject = static_cast<uint64_t>((0u - range) % range);
+    BatchU64 product  = __builtin_convertvector(BatchNextBits(lanes, mask), BatchU64) * range;
+    BatchInt rejected = mask & __builtin_convertvector((product & 0xFFFFFFFFull) < reject, BatchInt);
+    while (BatchAny(rejected)) {
+        const BatchU64 retry = __builtin_convertvector(BatchNextBits(lanes, rejected), BatchU64) * range;
+        product              = __builtin_convertvector(rejected, BatchI64) ? retry : product;
+        rejected             = rejected & __builtin_convertvector((product & 0xFFFFFFFFull) < reject, BatchInt);
+    }
+    return min_value + __builtin_convertvector(product >> 32, BatchInt);
+}
+
+static BatchInt
+BatchMax(const BatchInt a, const BatchInt b) {
+    return a > b ? a : b;
+}
+
+static BatchInt
+BatchMin(const BatchInt a, const BatchInt b) {
+    return a < b ? a : b;
+}
+
+static BatchFloat
+BatchMax(const BatchFloat a, const BatchFloat b) {
+    return a > b ? a : b;
+}
+
+// 以下 Batch* 函数逐一对应各角色的 DoAtk / DoUlt / Attack，
+// defender_dead / attacker_dead 为对应 lane 上 DEFENDER_DEAD / ATTACKER_DEAD 的掩码
+struct BatchTurnResult {
+    BatchInt defender_dead;
+    BatchInt attacker_dead;
+};
+
+// 一方角色在各 lane 上的事件计数，与标量路径的 STAT 一一对应
+struct BatchStatEvents {
+    BatchInt count[kNumOfStatEvent];
+};
+
+static void
+BatchStat([[maybe_unused]] BatchStatEvents& events, [[maybe_unused]] const StatEvent event, [[maybe_unused]] const BatchInt mask) {
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    events.count[static_cast<int>(event)] -= mask;
+#endif
+}
+
+template <Character D>
+static BatchTurnResult
+BatchDoAtk(BatchLanes& lanes, const BatchFighter& attacker, BatchFighter& defender, const BatchInt mask, const BatchInt atk, BatchStatEvents& attacker_events) {
+    const BatchInt is_hit = BatchNextFloat(lanes, mask) <= attacker.hit_rate;
+    BatchStat(attacker_events, StatEvent::MISS, mask & ~is_hit);
+    defender.hit -= (mask & is_hit) ? BatchMax(atk, BatchInt{}) : 0;
+    return {mask & (defender.hit <= 0), BatchInt{}};
+}
+
+template <Character D>
+static BatchTurnResult
+BatchDoUlt(BatchLanes& lanes, BatchFighter& attacker, BatchFighter& defender, const BatchInt mask, const int atk, BatchStatEvents& attacker_events, BatchStatEvents& defender_events, [[maybe_unused]] const CharacterParams& defender_params) {
+    if constexpr (D == Character::DURANDAL) {
+        const BatchInt reflect = mask & (BatchNextFloat(lanes, mask) < defender_params.skill_rate);
+        BatchStat(defender_events, StatEvent::REFLECT, reflect);
+        attacker.hit -= reflect ? 30 : 0;
+        defender.hit -= (mask & ~reflect) ? atk : 0;
+        return {mask & ~reflect & (defender.hit <= 0), reflect & (attacker.hit <= 0)};
+    } else {
+        const BatchInt is_hit = BatchNextFloat(lanes, mask) <= attacker.hit_rate;
+        BatchStat(attacker_events, StatEvent::MISS, mask & ~is_hit);
+        defender.hit -= (mask & is_hit) ? atk : 0;
+        return {mask & (defender.hit <= 0), BatchInt{}};
+    }
+}
+
+template <Character A, Character D>
+static BatchTurnResult
+BatchAttack(BatchLanes& lanes, BatchFighter& attacker, BatchFighter& defender, const BatchInt mask, BatchStatEvents& attacker_events, BatchStatEvents& defender_events, const CharacterParams& attacker_params, const CharacterParams& defender_params) {
+    static_assert(IsBatchSupported(A) && IsBatchSupported(D), "character is not supported by the batch engine");
+
+    if constexpr (A == Character::HIMEKO) {
+        const BatchInt is_ult = mask & (attacker.phase == 0);
+        attacker.atk          = is_ult ? attacker.atk * 2 : attacker.atk;
+        attacker.hit_rate     = is_ult ? BatchMax(attacker.hit_rate - attacker_params.skill_rate, BatchFloat{}) : attacker.hit_rate;
+        BatchStat(attacker_events, StatEvent::ULT, is_ult);
+        BatchStat(attacker_events, StatEvent::ATTACK, mask);
+        return BatchDoAtk<D>(lanes, attacker, defender, mask, attacker.atk - defender.def, attacker_events);
+    } else if constexpr (A == Character::SAKURA) {
+        const BatchInt is_heal = mask & (BatchNextFloat(lanes, mask) <= attacker_params.skill_rate);
+        attacker.hit           = is_heal ? BatchMin(attacker.hit + 25, BatchInt{} + 100) : attacker.hit;
+
+        const BatchInt is_ult = mask & (attacker.phase == 0);
+        BatchStat(attacker_events, StatEvent::ULT, is_ult);
+        BatchStat(attacker_events, StatEvent::ATTACK, mask & ~is_ult);
+
+        const BatchTurnResult ult   = BatchDoUlt<D>(lanes, attacker, defender, is_ult, 25, attacker_events, defender_events, defender_params);
+        const BatchTurnResult plain = BatchDoAtk<D>(lanes, attacker, defender, mask & ~is_ult, attacker.atk - defender.def, attacker_events);
+        return {ult.defender_dead | plain.defender_dead, ult.attacker_dead | plain.attacker_dead};
+    } else if constexpr (A == Character::SEELE) {
+        attacker.status ^= mask & 1;
+        const BatchInt is_white = mask & (attacker.status == 0);
+        const BatchInt heal     = BatchNextInt(lanes, is_white, 1, 15);
+        attacker.hit            = is_white ? BatchMin(attacker.hit + heal, BatchInt{} + 100) : attacker.hit;
+        attacker.def += is_white ? 5 : (mask ? -5 : 0);
+        attacker.atk += is_white ? -10 : (mask ? 10 : 0);
+        BatchStat(attacker_events, StatEvent::ATTACK, mask);
+        return BatchDoAtk<D>(lanes, attacker, defender, mask, attacker.atk - defender.def, attacker_events);
+    } else if constexpr (A == Character::DURANDAL) {
+        attacker.atk += mask & 3;
+        BatchStat(attacker_events, StatEvent::ATTACK, mask);
+        return BatchDoAtk<D>(lanes, attacker, defender, mask, attacker.atk - defender.def, attacker_events);
+    } else {
+        const BatchInt is_ult = mask & (attacker.phase == 0);
+        BatchStat(attacker_events, StatEvent::ULT, is_ult);
+        BatchStat(attacker_events, StatEvent::ATTACK, mask & ~is_ult);
+
+        const BatchTurnResult ult = BatchDoUlt<D>(lanes, attacker, defender, is_ult, 18, attacker_events, defender_events, defender_params);
+        const BatchInt survived   = is_ult & ~ult.defender_dead & ~ult.attacker_dead;
+        defender.hit_rate         = survived ? BatchMax(defender.hit_rate - attacker_params.skill_rate, BatchFloat{}) : defender.hit_rate;
+
+        const BatchTurnResult plain = BatchDoAtk<D>(lanes, attacker, defender, mask & ~is_ult, attacker.atk, attacker_events);
+        return {ult.defender_dead | plain.defender_dead, ult.attacker_dead | plain.attacker_dead};
+    }
+}
+
+// 将 mask 内的 lane 重置为第 1 回合开始时的状态；所有 lane 同时处理，避免逐元素写入后整向量读取造成的转发停顿
+template <class T>
+static void
+BatchReset(BatchFighter& fighter, const BatchInt mask) {
+    const T prototype;
+    fighter.hit      = mask ? prototype.hit : fighter.hit;
+    fighter.def      = mask ? prototype.def : fighter.def;
+    fighter.atk      = mask ? prototype.atk : fighter.atk;
+    fighter.status   = mask ? 0 : fighter.status;
+    fighter.phase    = mask ? 1 % prototype.RoundPeriod() : fighter.phase;
+    fighter.hit_rate = mask ? prototype.hit_rate : fighter.hit_rate;
+}
+
+// 必杀技周期来自运行时的数值表，向量上没有整数除法，改为每回合递推 round % period；没有周期必杀技的角色不需要
+template <Character C>
+static void
+BatchAdvancePhase(BatchFighter& fighter, const CharacterParams& params) {
+    if constexpr (kDefaultCharacterTable[C].period > 0) fighter.phase = fighter.phase + 1 == params.period ? 0 : fighter.phase + 1;
+}
+
+// 一组 kBatchWidth 条 lane 及其统计；多组交替推进以掩盖随机数混合的乘法延迟
+// 批量引擎的直方图把结束回合、p0 / p1 胜出时的剩余血量排在一起，末尾每条 lane 各有一个桶收纳未结束的 lane，
+// 这样每条 lane 每回合都无条件记一次，不引入难以预测的分支，也不会让所有累加串在同一个地址上
+constexpr int kBatchHitBucket     = kRoundHistogramSize;
+constexpr int kBatchIdleBucket    = kBatchHitBucket + 2 * kHitHistogramSize;
+constexpr int kBatchHistogramSize = kBatchIdleBucket + kBatchWidth;
+constexpr int kBatchLogSteps      = 32;
+
+struct BatchGroup {
+    BatchLanes lanes{};
+    BatchU64 trial{};
+    BatchInt active{};
+
+    BatchInt first_wins{};
+    BatchInt draws{};
+    BatchInt attacker_deads{};
+    BatchU64 rounds{};
+
+    BatchStatEvents events[2]{};  // 0 为先手方
+    CharacterParams params[2]{};
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    // 每回合把各 lane 的直方图桶号整向量写入日志，攒满后再集中逐个累加，热循环里不必逐 lane 取出元素
+    BatchInt bucket_log[kBatchLogSteps][2]{};
+    int log_size = 0;
+    uint32_t histogram[kBatchHistogramSize]{};
+#endif
+};
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+static void
+BatchFlushLog(BatchGroup& group) {
+    for (int step = 0; step < group.log_size; ++step) {
+        for (const BatchInt& buckets : group.bucket_log[step]) {
+            for (int lane = 0; lane < kBatchWidth; ++lane) ++group.histogram[buckets[lane]];
+        }
+    }
+    group.log_size = 0;
+}
+#endif
+
+// 把组内的事件计数和直方图转入线程局部统计并清零；每条 lane 每回合每种事件至多计一次，定期转存即可避免 32 位计数溢出
+template <Character kFirst, Character kSecond>
+static void
+BatchFlushStats([[maybe_unused]] BatchGroup& group) {
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    constexpr Character kSides[2] = {kFirst, kSecond};
+    for (int side = 0; side < 2; ++side) {
+        for (int e = 0; e < kNumOfStatEvent; ++e) {
+            uint64_t count = 0;
+            for (int lane = 0; lane < kBatchWidth; ++lane) count += static_cast<uint32_t>(group.events[side].count[e][lane]);
+            g_battle_stats.events[static_cast<int>(kSides[side])][e] += count;
+            group.events[side].count[e] = BatchInt{};
+        }
+    }
+
+    BatchFlushLog(group);
+    for (int r = 0; r < kRoundHistogramSize; ++r) g_battle_stats.rounds[r] += group.histogram[r];
+    for (int h = 0; h < 2 * kHitHistogramSize; ++h) g_battle_stats.winner_hit[h / kHitHistogramSize][h % kHitHistogramSize] += group.histogram[kBatchHitBucket + h];
+    std::fill(std::begin(group.histogram), std::end(group.histogram), 0u);
+#endif
+}
+
+// 推进组内所有 lane 一个回合，结束的 lane 立即结算并换上自己的下一场试验
+template <Character kFirst, Character kSecond, bool P0First>
+static void
+BatchStep(BatchGroup& group, const uint64_t key_base, const uint64_t end, const int max_rounds) {
+    using First  = CharacterType<kFirst>;
+    using Second = CharacterType<kSecond>;
+
+    BatchLanes& lanes = group.lanes;
+
+    const BatchTurnResult first  = BatchAttack<kFirst, kSecond>(lanes, lanes.fighter[0], lanes.fighter[1], group.active, group.events[0], group.events[1], group.params[0], group.params[1]);
+    const BatchInt first_done    = first.defender_dead | first.attacker_dead;
+    const BatchTurnResult second = BatchAttack<kSecond, kFirst>(lanes, lanes.fighter[1], lanes.fighter[0], group.active & ~first_done, group.events[1], group.events[0], group.params[1], group.params[0]);
+
+    const BatchInt killed    = first_done | second.defender_dead | second.attacker_dead;
+    const BatchInt draw      = group.active & ~killed & (lanes.round >= max_rounds);
+    const BatchInt done      = killed | draw;
+    const BatchInt first_win = first.defender_dead | second.attacker_dead;
+    group.first_wins -= first_win;
+    group.draws -= draw;
+    group.attacker_deads -= first.attacker_dead | second.attacker_dead;
+    group.rounds += __builtin_convertvector(done ? lanes.round : 0, BatchU64);
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    static_assert(kBatchWidth == 8, "lane_index assumes 8 lanes");
+    const BatchInt lane_index = {0, 1, 2, 3, 4, 5, 6, 7};
+    const BatchInt winner     = first_win ? BatchInt{} + (P0First ? 0 : 1) : BatchInt{} + (P0First ? 1 : 0);
+    const BatchInt hit        = BatchMax(BatchMin(first_win ? lanes.fighter[0].hit : lanes.fighter[1].hit, BatchInt{} + (kHitHistogramSize - 1)), BatchInt{});
+    group.bucket_log[group.log_size][0] = done ? BatchMin(lanes.round, BatchInt{} + (kRoundHistogramSize - 1)) : kBatchIdleBucket + lane_index;
+    group.bucket_log[group.log_size][1] = killed ? kBatchHitBucket + winner * kHitHistogramSize + hit : kBatchIdleBucket + lane_index;
+    if (++group.log_size == kBatchLogSteps) BatchFlushLog(group);
+#endif
+
+    const BatchI64 done_64 = __builtin_convertvector(done, BatchI64);
+    group.trial            = done_64 ? group.trial + kBatchWidth * kBatchGroups : group.trial;
+    BatchAdvancePhase<kFirst>(lanes.fighter[0], group.params[0]);
+    BatchAdvancePhase<kSecond>(lanes.fighter[1], group.params[1]);
+    BatchReset<First>(lanes.fighter[0], done);
+    BatchReset<Second>(lanes.fighter[1], done);
+    lanes.key     = done_64 ? Mix64(key_base ^ group.trial) : lanes.key;
+    lanes.counter = done_64 ? 0 : lanes.counter;
+    lanes.round   = done ? 1 : lanes.round + 1;
+
+    group.active &= __builtin_convertvector(group.trial < end, BatchInt);
+}
+
+// 处理 [begin, end) 号试验：第 g 组的 lane i 依次进行 begin + g * kBatchWidth + i 号试验，
+// 之后每次前进 kBatchWidth * kBatchGroups 号
+template <Character C0, Character C1, bool P0First>
+static void
+SimulateBatchRange(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+    constexpr Character kFirst  = P0First ? C0 : C1;
+    constexpr Character kSecond = P0First ? C1 : C0;
+
+    constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+    const uint64_t key_base    = Mix64(Mix64(seed) ^ matchup);
+    const int max_rounds       = MaxRounds();
+
+    BatchGroup groups[kBatchGroups];
+    for (int g = 0; g < kBatchGroups; ++g) {
+        BatchGroup& group = groups[g];
+        for (int lane = 0; lane < kBatchWidth; ++lane) group.trial[lane] = begin + static_cast<uint64_t>(g * kBatchWidth + lane);
+
+        group.active    = __builtin_convertvector(group.trial < end, BatchInt);
+        group.params[0] = (*g_character_table)[kFirst];
+        group.params[1] = (*g_character_table)[kSecond];
+        BatchReset<CharacterType<kFirst>>(group.lanes.fighter[0], group.active);
+        BatchReset<CharacterType<kSecond>>(group.lanes.fighter[1], group.active);
+        group.lanes.key   = Mix64(key_base ^ group.trial);
+        group.lanes.round = BatchInt{} + 1;
+    }
+
+    uint64_t step = 0;
+    for (bool any_active = true; any_active;) {
+        any_active = false;
+        for (BatchGroup& group : groups) {
+            BatchStep<kFirst, kSecond, P0First>(group, key_base, end, max_rounds);
+            any_active |= BatchAny(group.active);
+        }
+        if (++step % (1 << 24) == 0) {
+            for (BatchGroup& group : groups) BatchFlushStats<kFirst, kSecond>(group);
+        }
+    }
+    for (BatchGroup& group : groups) BatchFlushStats<kFirst, kSecond>(group);
+
+    for (int g = 0; g < kBatchGroups; ++g) {
+        const BatchGroup& group = groups[g];
+        for (int lane = 0; lane < kBatchWidth; ++lane) {
+            const uint64_t battles = (group.trial[lane] - begin - static_cast<uint64_t>(g * kBatchWidth + lane)) / (kBatchWidth * kBatchGroups);
+            const auto first_win   = static_cast<uint64_t>(group.first_wins[lane]);
+            const auto draw        = static_cast<uint64_t>(group.draws[lane]);
+
+            result.p0_win += P0First ? first_win : battles - first_win - draw;
+            result.p1_win += P0First ? battles - first_win - draw : first_win;
+            result.draw += draw;
+            result.attacker_dead += static_cast<uint64_t>(group.attacker_deads[lane]);
+            result.rounds += group.rounds[lane];
+        }
+    }
+}
+
+template <Character C0, Character C1, bool P0First>
+static void
+SimulateBatchOrScalarRange(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+    if constexpr (IsBatchSupported(C0) && IsBatchSupported(C1)) {
+        SimulateBatchRange<C0, C1, P0First>(result, seed, begin, end);
+    } else {
+        SimulateRange<C0, C1, P0First>(result, seed, begin, end);
+    }
+}
+#else
+template <Character C0, Character C1, bool P0First>
+static void
+SimulateBatchOrScalarRange(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+    SimulateRange<C0, C1, P0First>(result, seed, begin, end);
+}
+#endif
+
+template <Character C0, Character C1, bool P0First>
+struct VirtualKernel {
+    static void Run(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) { SimulateVirtualRange<C0, C1, P0First>(result, seed, begin, end); }
+};
+
+template <Character C0, Character C1, bool P0First>
+struct SpecializedKernel {
+    static void Run(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) { SimulateRange<C0, C1, P0First>(result, seed, begin, end); }
+};
+
+template <Character C0, Character C1, bool P0First>
+struct BatchKernel {
+    static void Run(MatchupResult& result, const uint64_t seed, const uint64_t begin, const uint64_t end) { SimulateBatchOrScalarRange<C0, C1, P0First>(result, seed, begin, end); }
+};
+
+constexpr auto kVirtualKernels     = MakeKernelTable<RangeKernel, VirtualKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+constexpr auto kSpecializedKernels = MakeKernelTable<RangeKernel, SpecializedKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+constexpr auto kBatchKernels       = MakeKernelTable<RangeKernel, BatchKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+std::size_t
+KernelIndex(const Character c0, const Character c1, const CharacterTable& table) {
+    const bool p0_first = table[c0].spd > table[c1].spd;
+    return (static_cast<std::size_t>(c0) * kNumOfCharacter + static_cast<std::size_t>(c1)) * 2 + (p0_first ? 1 : 0);
+}
+
+RangeKernel
+GetRangeKernel(const Character c0, const Character c1, const Engine engine, const CharacterTable& table) {
+    const auto index = KernelIndex(c0, c1, table);
+
+    // clang-format off
+    switch (engine) {
+    case Engine::VIRTUAL:     return kVirtualKernels[index];
+    case Engine::SPECIALIZED: return kSpecializedKernels[index];
+    case Engine::BATCH:       return kBatchKernels[index];
+    default: abort();
+    }
+    // clang-format on
+}
+
+// 每个对局的试验被切成若干块作为工作项，各 worker 先处理自己的队列，空了再从其他 worker 的队尾窃取
+struct WorkItem {
+    std::size_t task;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct alignas(kCacheLineSize) WorkQueue {
+    std::mutex mutex;
+    std::vector<WorkItem> items;
+    std::size_t head = 0;
+    std::size_t tail = 0;
+
+    bool Pop(WorkItem& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (head == tail) return false;
+        item = items[head++];
+        return true;
+    }
+
+    bool Steal(WorkItem& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (head == tail) return false;
+        item = items[--tail];
+        return true;
+    }
+};
+
+std::vector<MatchupResult>
+RunMatchups(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine) {
+    constexpr uint64_t kTrialsPerItem = 1 << 15;
+
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int num_workers = pool.NumThreads();
+
+    std::vector<RangeKernel> kernels;
+    for (const auto& task : tasks) kernels.push_back(GetRangeKernel(task.c0, task.c1, engine, task.Table()));
+
+    // 按轮转方式分发，使每个 worker 的队列里混有长短不一的对局
+    std::vector<WorkQueue> queues(static_cast<std::size_t>(num_workers));
+    std::size_t next_queue = 0;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const uint64_t end = tasks[t].begin + tasks[t].times;
+        for (uint64_t begin = tasks[t].begin; begin < end; begin += kTrialsPerItem) {
+            queues[next_queue].items.push_back({t, begin, std::min(begin + kTrialsPerItem, end)});
+            next_queue = (next_queue + 1) % queues.size();
+        }
+    }
+    for (auto& queue : queues) queue.tail = queue.items.size();
+
+    std::vector<MatchupResult> worker_results(static_cast<std::size_t>(num_workers) * tasks.size());
+
+    pool.Run([&](const int worker) {
+        MatchupResult* const results = &worker_results[static_cast<std::size_t>(worker) * tasks.size()];
+
+        // 调用线程本身是 0 号 worker，结束后恢复它原来的数值表，对局的数值表可能只在本次调用期间有效
+        const CharacterTable* const saved_table = g_character_table;
+
+        const auto process = [&](const WorkItem& item) {
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            g_battle_stats = BattleStats();
+#endif
+            g_character_table          = &tasks[item.task].Table();
+            const uint64_t alloc_begin = GetAllocCount();
+            kernels[item.task](results[item.task], seed, item.begin, item.end);
+            results[item.task].alloc_count += GetAllocCount() - alloc_begin;
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+            results[item.task].stats += g_battle_stats;
+#endif
+        };
+
+        WorkItem item{};
+        while (queues[static_cast<std::size_t>(worker)].Pop(item)) process(item);
+
+        for (int offset = 1; offset < num_workers; ++offset) {
+            WorkQueue& victim = queues[static_cast<std::size_t>((worker + offset) % num_workers)];
+            while (victim.Steal(item)) process(item);
+        }
+
+        // 线程池的线程常驻，trace 缓冲区中剩余的记录要在本轮结束前写出
+        FlushTrace();
+        g_character_table = saved_table;
+    });
+
+    std::vector<MatchupResult> results(tasks.size());
+    for (int worker = 0; worker < num_workers; ++worker) {
+        for (std::size_t t = 0; t < tasks.size(); ++t) results[t] += worker_results[static_cast<std::size_t>(worker) * tasks.size() + t];
+    }
+    return results;
+}
+
+MatchupResult
+RunMatchup(const Character c0, const Character c1, const uint64_t times, const uint64_t seed, const Engine engine) {
+    return RunMatchups({{c0, c1, times}}, seed, engine).front();
+}
+
+std::vector<MatchupTask>
+MakeMatchupTasks(const uint64_t times, const bool full_matrix) {
+    std::vector<MatchupTask> tasks;
+    for (int j = 0; j < kNumOfCharacter; ++j) {
+        for (int i = full_matrix ? 0 : j + 1; i < kNumOfCharacter; ++i) {
+            tasks.push_back({static_cast<Character>(j), static_cast<Character>(i), times});
+        }
+    }
+    return tasks;
+}
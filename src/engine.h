@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "character_table.h"
+#include "config.h"
+#include "player.h"
+#include "stats.h"
+
+enum class Engine {
+    VIRTUAL,      // 虚函数参考实现
+    SPECIALIZED,  // 按角色组合编译期特化的内核
+    BATCH,        // SIMD 锁步批量内核，不支持的角色组合自动回退到 SPECIALIZED
+};
+
+// 避免不同线程的累加器落在同一缓存行上
+constexpr std::size_t kCacheLineSize = 64;
+
+struct alignas(kCacheLineSize) MatchupResult {
+    uint64_t p0_win        = 0;
+    uint64_t p1_win        = 0;
+    uint64_t draw          = 0;
+    uint64_t attacker_dead = 0;  // 攻击方被反伤致死而结束的场次
+    uint64_t rounds        = 0;
+    uint64_t alloc_count   = 0;
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    BattleStats stats;
+#endif
+
+    [[nodiscard]] uint64_t Battles() const { return p0_win + p1_win + draw; }
+
+    MatchupResult& operator+=(const MatchupResult& other) {
+        p0_win += other.p0_win;
+        p1_win += other.p1_win;
+        draw += other.draw;
+        attacker_dead += other.attacker_dead;
+        rounds += other.rounds;
+        alloc_count += other.alloc_count;
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+        stats += other.stats;
+#endif
+        return *this;
+    }
+};
+
+struct BattleOutcome {
+    bool first_win     = false;
+    bool attacker_dead = false;
+    bool draw          = false;
+    int rounds         = 0;
+    int first_hit      = 0;  // 结束时先手方的剩余血量
+    int second_hit     = 0;
+};
+
+// 双方都无法命中时（例如两个符华互相把命中率降到 0）战斗可能持续极长时间，超过回合上限记为平局
+constexpr int kDefaultMaxRounds = 1000;
+
+// 所有引擎和精确求解器共用的回合上限，只应在没有对局运行时修改
+void
+SetMaxRounds(int max_rounds);
+
+int
+MaxRounds();
+
+// RunBattle 默认的出招钩子，什么也不做；性能剖析传入自己的钩子，在每次出招前后读取计数器
+struct NoTurnHook {
+    void Begin() const {}
+    void End([[maybe_unused]] const Character attacker) const {}
+};
+
+// 从第 first_round 回合开始进行一场战斗直到一方倒下或达到 max_rounds；从快照续战时 first_round 大于 1
+template <class First, class Second, class Turn = NoTurnHook>
+BattleOutcome
+RunBattle(First& first, Second& second, const int max_rounds, const int first_round = 1, Turn&& turn = Turn()) {
+    for (int round = first_round; round <= max_rounds; ++round) {
+        turn.Begin();
+        const auto first_status = first.AttackOn(round, second);
+        turn.End(first.id);
+        if (first_status != Player::AttackResult::ALL_ALIVE) return {first_status == Player::AttackResult::DEFENDER_DEAD, first_status == Player::AttackResult::ATTACKER_DEAD, false, round, first.hit, second.hit};
+
+        turn.Begin();
+        const auto second_status = second.AttackOn(round, first);
+        turn.End(second.id);
+        if (second_status != Player::AttackResult::ALL_ALIVE) return {second_status == Player::AttackResult::ATTACKER_DEAD, second_status == Player::AttackResult::ATTACKER_DEAD, false, round, first.hit, second.hit};
+    }
+    return {false, false, true, max_rounds, first.hit, second.hit};
+}
+
+// 把一场战斗的结果计入 result，p0_first 表示 p0 是否为先手
+void
+Accumulate(MatchupResult& result, const BattleOutcome& outcome, bool p0_first);
+
+using RangeKernel = void (*)(MatchupResult& result, uint64_t seed, uint64_t begin, uint64_t end);
+
+// 以 (c0 * kNumOfCharacter + c1) * 2 + p0_first 为下标，把 Kernel<C0, C1, P0First>::Run 排成分发表
+template <class Fn, template <Character, Character, bool> class Kernel, std::size_t... I>
+constexpr std::array<Fn, sizeof...(I)>
+MakeKernelTable(std::index_sequence<I...>) {
+    return {&Kernel<static_cast<Character>(I / 2 / kNumOfCharacter), static_cast<Character>(I / 2 % kNumOfCharacter), I % 2 == 1>::Run...};
+}
+
+// 按 table 中的速度决定先手后，(c0, c1) 在各分发表中的下标
+std::size_t
+KernelIndex(Character c0, Character c1, const CharacterTable& table = GetCharacterTable());
+
+// 在调用线程上串行完成 [begin, end) 号试验的内核，供基准测试直接测量单线程吞吐；内核按调用线程的 g_character_table 构造角色
+RangeKernel
+GetRangeKernel(Character c0, Character c1, Engine engine, const CharacterTable& table = GetCharacterTable());
+
+struct MatchupTask {
+    Character c0;
+    Character c1;
+    uint64_t times;
+    uint64_t begin             = 0;        // 首个试验的序号，分批续跑同一对局时使后续批次接着前面的试验序号
+    const CharacterTable* table = nullptr;  // 该对局使用的数值表，为空时使用 GetCharacterTable()
+
+    [[nodiscard]] const CharacterTable& Table() const { return table != nullptr ? *table : GetCharacterTable(); }
+};
+
+// 在线程池上一次性完成所有对局，返回值与 tasks 一一对应
+std::vector<MatchupResult>
+RunMatchups(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine = Engine::BATCH);
+
+MatchupResult
+RunMatchup(Character c0, Character c1, uint64_t times, uint64_t seed, Engine engine = Engine::BATCH);
+
+// full_matrix 时包含镜像对局和左右互换的 12x12 全部组合，否则为两两组合
+std::vector<MatchupTask>
+MakeMatchupTasks(uint64_t times, bool full_matrix);
@@ -0,0 +1,111 @@
+#include "exact.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "exact_state_space.h"
+#include "random.h"
+#include "thread_pool.h"
+
+// 概率低于该值的局面不再展开；双方都可能一直回血或命中率降为 0，极小概率的局面会一直延续到回合上限
+constexpr double kExactPruneProbability = 1e-15;
+
+// 按半回合推进各局面的概率分布，回合数不进入局面的键，因此只需两份按局面编号存放的概率向量交替使用
+template <class First, class Second>
+void
+SolveExact(ExactResult& result, const bool first_is_p0) {
+    const int max_rounds = MaxRounds();
+
+    RandomScript script;
+    const RandomHooks hooks{&script};
+    g_random_hooks = &hooks;
+
+    ExactStateSpace<First, Second> space(script);
+
+    std::vector<uint32_t> active{space.Intern(First(), Second())};  // 概率非 0 的局面编号
+    std::vector<uint32_t> next_active;
+    std::vector<double> current(space.NumStates(), 1.);
+    std::vector<double> next;
+
+    for (int round = 1; round <= max_rounds && !active.empty(); ++round) {
+        result.last_round = round;
+
+        for (const bool first_attacks : {true, false}) {
+            next_active.clear();
+
+            for (const uint32_t state : active) {
+                const double probability = current[state];
+                current[state]           = 0.;
+
+                if (probability < kExactPruneProbability) {
+                    result.pruned += probability;
+                    continue;
+                }
+
+                const auto [begin, end] = space.Transitions(state, round, first_attacks);
+                next.resize(space.NumStates());
+
+                for (auto transition = begin; transition != end; ++transition) {
+                    const double branch_probability = probability * transition->probability;
+                    if (transition->target >= kExactTerminal) {
+                        const bool first_win = (transition->target & 1u) != 0;
+                        (first_win == first_is_p0 ? result.p0_win : result.p1_win) += branch_probability;
+                        result.attacker_dead += (transition->target & 2u) != 0 ? branch_probability : 0.;
+                        result.rounds += branch_probability * round;
+                    } else {
+                        if (next[transition->target] == 0.) next_active.push_back(transition->target);
+                        next[transition->target] += branch_probability;
+                    }
+                }
+            }
+
+            current.swap(next);
+            active.swap(next_active);
+            result.peak_active = std::max<uint64_t>(result.peak_active, active.size());
+        }
+    }
+
+    g_random_hooks = nullptr;
+
+    // 与 RunBattle 一致，到达回合上限仍未分出胜负记为平局
+    for (const uint32_t state : active) {
+        result.draw += current[state];
+        result.rounds += current[state] * max_rounds;
+    }
+
+    result.states      = space.NumStates();
+    result.transitions = space.NumTransitions();
+    result.bytes       = space.EstimateBytes() + (current.capacity() + next.capacity()) * sizeof(double) + (active.capacity() + next_active.capacity()) * sizeof(uint32_t);
+}
+
+using ExactSolver = void (*)(ExactResult& result);
+
+template <Character C0, Character C1, bool P0First>
+struct ExactKernel {
+    static void Run(ExactResult& result) {
+        if constexpr (P0First) {
+            SolveExact<CharacterType<C0>, CharacterType<C1>>(result, true);
+        } else {
+            SolveExact<CharacterType<C1>, CharacterType<C0>>(result, false);
+        }
+    }
+};
+
+constexpr auto kExactSolvers = MakeKernelTable<ExactSolver, ExactKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+std::vector<ExactResult>
+SolveExactMatchups(const std::vector<MatchupTask>& tasks) {
+    std::vector<ExactResult> results(tasks.size());
+    std::atomic<std::size_t> next_task{0};
+
+    ThreadPool::Instance().Run([&](int) {
+        const CharacterTable* const saved_table = g_character_table;
+        for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+            g_character_table = &tasks[t].Table();
+            kExactSolvers[KernelIndex(tasks[t].c0, tasks[t].c1, tasks[t].Table())](results[t]);
+        }
+        g_character_table = saved_table;
+    });
+
+    return results;
+}
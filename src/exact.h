@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine.h"
+
+// 精确求解的结果：胜负、平局、反伤致死为概率，回合数为期望
+struct ExactResult {
+    double p0_win        = 0.;
+    double p1_win        = 0.;
+    double draw          = 0.;
+    double attacker_dead = 0.;
+    double rounds        = 0.;
+    double pruned        = 0.;  // 因概率过小被舍弃的概率之和，即上面各概率的误差上界
+
+    uint64_t states      = 0;  // 局面表中不同局面的个数
+    uint64_t transitions = 0;  // 缓存的转移条数
+    uint64_t peak_active = 0;  // 同一个半回合内概率非 0 的局面数的峰值
+    uint64_t bytes       = 0;  // 局面表、转移缓存和概率向量占用内存的估计
+    int last_round       = 0;  // 概率质量全部终止的回合，未终止时为回合上限
+};
+
+// 逐个对局精确求解胜率，各对局互不相关，由线程池中的 worker 依次领取；tasks 中的场次不起作用
+std::vector<ExactResult>
+SolveExactMatchups(const std::vector<MatchupTask>& tasks);
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "battle_state.h"
+#include "random.h"
+
+// 一方的全部可变状态即 FighterState，占 kExactFighterWords 个整数，双方拼在一起作为局面表的键
+constexpr std::size_t kExactFighterWords = sizeof(FighterState) / sizeof(int32_t);
+
+using ExactStateKey = std::array<int32_t, kExactFighterWords * 2>;
+
+struct ExactStateHash {
+    std::size_t operator()(const ExactStateKey& key) const {
+        uint64_t hash = 0;
+        for (const int32_t word : key) hash = Mix64(hash ^ static_cast<uint32_t>(word));
+        return static_cast<std::size_t>(hash);
+    }
+};
+
+template <class T>
+void
+PackExactState(const T& player, int32_t* words) {
+    const FighterState state = CaptureFighter(player);
+    std::memcpy(words, &state, sizeof(state));
+}
+
+// 转移目标不小于 kExactTerminal 时表示战斗结束，最低位为先手获胜，次低位为出招方反伤致死
+constexpr uint32_t kExactTerminal = 0xFFFFFFFCu;
+
+struct ExactTransition {
+    uint32_t target;
+    double probability;
+};
+
+// 局面表：以哈希表为每个不同的局面分配编号，并只保存一份角色对象；局面在每个相位下的全部分支只枚举一次，
+// 合并成转移缓存起来，之后再到达同一局面时直接按缓存分配概率
+template <class First, class Second>
+class ExactStateSpace {
+public:
+    // 周期由当前线程的数值表决定，构造时取一次
+    explicit ExactStateSpace(RandomScript& script) : script_(script), round_period_(std::lcm(First().RoundPeriod(), Second().RoundPeriod())), phases_(static_cast<std::size_t>(round_period_) * 2) {}
+
+    uint32_t Intern(const First& first, const Second& second) {
+        ExactStateKey key;
+        PackExactState(first, key.data());
+        PackExactState(second, key.data() + kExactFighterWords);
+
+        const auto [it, inserted] = index_.try_emplace(key, static_cast<uint32_t>(states_.size()));
+        if (inserted) {
+            states_.push_back({first, second});
+            memo_.resize(states_.size() * phases_, kUnexpanded);
+        }
+        return it->second;
+    }
+
+    // 返回的区间在下一次调用前有效
+    std::pair<const ExactTransition*, const ExactTransition*> Transitions(const uint32_t state, const int round, const bool first_attacks) {
+        const std::size_t memo_index = static_cast<std::size_t>(state) * phases_ + static_cast<std::size_t>(round % round_period_) * 2 + (first_attacks ? 1 : 0);
+
+        if (memo_[memo_index] == kUnexpanded) {
+            const Range range   = Expand(state, round, first_attacks);
+            memo_[memo_index] = range;
+        }
+        return {transitions_.data() + memo_[memo_index].first, transitions_.data() + memo_[memo_index].second};
+    }
+
+    [[nodiscard]] std::size_t NumStates() const { return states_.size(); }
+
+    [[nodiscard]] std::size_t NumTransitions() const { return transitions_.size(); }
+
+    // 双方出招的公共周期，Transitions 的 round 只有模它的余数起作用
+    [[nodiscard]] int RoundPeriod() const { return round_period_; }
+
+    // 编号为 state 的局面中的双方，引用在下一次 Intern 或 Transitions 前有效
+    [[nodiscard]] const First& FirstOf(const uint32_t state) const { return states_[state].first; }
+
+    [[nodiscard]] const Second& SecondOf(const uint32_t state) const { return states_[state].second; }
+
+    // 哈希表节点中除键值外还有缓存的哈希值和链表指针，另加桶数组
+    [[nodiscard]] uint64_t EstimateBytes() const {
+        const auto table_bytes = [](const auto& table) { return table.size() * (sizeof(typename std::decay_t<decltype(table)>::value_type) + 2 * sizeof(void*)) + table.bucket_count() * sizeof(void*); };
+        return table_bytes(index_) + states_.capacity() * sizeof(Fighters) + memo_.capacity() * sizeof(Range) + transitions_.capacity() * sizeof(ExactTransition);
+    }
+
+private:
+    struct Fighters {
+        First first;
+        Second second;
+    };
+
+    // 双方的出招只取决于回合数模 round_period_，每个局面按 (回合数模 round_period_, 出招方) 分为 phases_ 个相位，各自缓存一段转移
+    using Range = std::pair<uint32_t, uint32_t>;
+
+    static constexpr Range kUnexpanded = {UINT32_MAX, UINT32_MAX};
+
+    Range Expand(const uint32_t state, const int round, const bool first_attacks) {
+        // Intern 可能让 states_ 扩容，先复制出来
+        const Fighters origin = states_[state];
+
+        branches_.clear();
+        do {
+            script_.Rewind();
+
+            First first   = origin.first;
+            Second second = origin.second;
+
+            const auto status = first_attacks ? first.AttackOn(round, second) : second.AttackOn(round, first);
+            if (status == Player::AttackResult::ALL_ALIVE) {
+                branches_.push_back({Intern(first, second), script_.Probability()});
+            } else {
+                // 与 RunBattle 一致：出招方倒下即为反伤致死，对方获胜
+                const bool attacker_dead = status == Player::AttackResult::ATTACKER_DEAD;
+                const bool first_win     = first_attacks != attacker_dead;
+                branches_.push_back({kExactTerminal | (first_win ? 1u : 0u) | (attacker_dead ? 2u : 0u), script_.Probability()});
+            }
+        } while (script_.Advance());
+
+        // 不同的随机分支经常到达同一局面，合并后之后每次分配概率的次数更少
+        std::sort(branches_.begin(), branches_.end(), [](const ExactTransition& lhs, const ExactTransition& rhs) { return lhs.target < rhs.target; });
+
+        const auto begin = static_cast<uint32_t>(transitions_.size());
+        for (const auto& branch : branches_) {
+            if (transitions_.size() > begin && transitions_.back().target == branch.target) {
+                transitions_.back().probability += branch.probability;
+            } else {
+                transitions_.push_back(branch);
+            }
+        }
+        return {begin, static_cast<uint32_t>(transitions_.size())};
+    }
+
+    RandomScript& script_;
+    int round_period_;
+    std::size_t phases_;
+
+    std::vector<Fighters> states_;
+    std::unordered_map<ExactStateKey, uint32_t, ExactStateHash> index_;
+    std::vector<Range> memo_;
+    std::vector<ExactTransition> transitions_;
+    std::vector<ExactTransition> branches_;
+};
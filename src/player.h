@@ -0,0 +1,679 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+#include "character.h"
+#include "character_table.h"
+#include "config.h"
+#include "random.h"
+#include "stats.h"
+#include "trace.h"
+
+class Player {
+public:
+    enum class AttackResult {
+        ATTACKER_DEAD,
+        DEFENDER_DEAD,
+        ALL_ALIVE,
+    };
+
+    Player() = default;
+
+    // 基础属性取自当前线程的数值表
+    Player(const Character id, const char* name) : name(name), id(id), hit((*g_character_table)[id].hit), def((*g_character_table)[id].def), atk((*g_character_table)[id].atk), spd((*g_character_table)[id].spd), params(&(*g_character_table)[id]) {}
+
+    Player(const Player& other)     = default;
+    Player(Player&& other) noexcept = default;
+    Player& operator=(const Player& other) = default;
+    Player& operator=(Player&& other) noexcept = default;
+
+    virtual ~Player() = default;
+
+    // 参考实现，经由 Player& 逐个虚函数分发，各子类的定义在 player_reference.cpp 中，与 AttackOn 分别维护
+    virtual AttackResult Attack(int round, Player& defender) = 0;
+
+    // 特化引擎通过 AttackOn 以具体类型调用，子类各自提供同名模板以便编译器内联整个回合；以 Player 调用时即参考实现
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        return Attack(round, defender);
+    }
+
+    // 出招只与 round % RoundPeriod() 有关，精确求解器据此合并不同回合的相同局面
+    [[nodiscard]] int RoundPeriod() const { return std::max(1, params->period); }
+
+    [[nodiscard]] bool IsUltRound(const int round) const {
+        const uint64_t magic = kPeriodMagic[static_cast<std::size_t>(params->period)];
+        return static_cast<uint64_t>(static_cast<uint32_t>(round)) * magic <= magic - 1;
+    }
+
+    // 精确求解器据此合并相同局面：子类把 Player 以外的私有状态编码成一个整数，与 AttackOn 一样按具体类型调用
+    [[nodiscard]] int ExtraState() const { return 0; }
+
+    // ExtraState 的逆，由快照恢复局面时使用
+    void RestoreExtraState([[maybe_unused]] const int state) {}
+
+    virtual AttackResult DoAtk(const int round, Player& attacker, const int atk) {
+        const int acc_atk = attacker.IsHit() ? std::max(0, atk) : 0;
+        hit -= acc_atk;
+        TRACE(round, Skill::ATTACK, attacker.id, id, acc_atk, hit);
+        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
+    }
+
+    virtual AttackResult DoUlt(const int round, Player& attacker, const int atk, const Skill skill) {
+        const int acc_atk = attacker.IsHit() ? atk : 0;
+        hit -= acc_atk;
+        TRACE(round, skill, attacker.id, id, acc_atk, hit);
+        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
+    }
+
+    [[nodiscard]] bool IsHit() const {
+        const bool is_hit = RandomChance(hit_threshold);
+        // 命中率为 1 时不可能未命中，这一判断对同一角色几乎总是同一结果，可以避开大部分计数
+        if (hit_rate < 1.f) STAT_ADD(id, MISS, !is_hit);
+        return is_hit;
+    }
+
+    // 命中率只能经由这两个函数修改，判定阈值随之更新
+    void LowerHitRate(const float amount) { SetHitRate(std::max(0.f, hit_rate - amount)); }
+
+    void SetHitRate(const float rate) {
+        hit_rate      = rate;
+        hit_threshold = RandomStream::AtMostThreshold(rate);
+    }
+
+    [[nodiscard]] bool GetAndRefreshCharmState() {
+        if (buff_charm == 0) return false;
+        return buff_charm-- != 0;
+    }
+
+    const char* name = "";
+    Character id     = Character::KIANA;
+
+    int hit = 0;
+    int def = 0;
+    int atk = 0;
+    int spd = 0;
+
+    float hit_rate         = 1.f;
+    uint64_t hit_threshold = RandomStream::kAlways;  // RandomAtMost(hit_rate) 的判定阈值，由 LowerHitRate 与 hit_rate 一起修改
+    bool is_group          = false;
+    int buff_opponent      = 0;
+    int buff_charm         = 0;
+
+    const CharacterParams* params = nullptr;
+};
+
+class Kiana final : public Player {
+public:
+    Kiana() : Player(Character::KIANA, "琪亚娜") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_self_ || buff_opponent) {
+            if (buff_self_) --buff_self_;
+            if (buff_opponent) --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::KIANA, ULT);
+            const auto result = defender.DoUlt(round, *this, atk + defender.def, Skill::KIANA_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+
+            if (RandomChance(params->skill_at_most)) {
+                TRACE(round, Skill::KIANA_STUN, id, id, 0, hit);
+                buff_self_ = 1;
+                STAT(Character::KIANA, STUN);
+            }
+        } else {
+            STAT(Character::KIANA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+
+    [[nodiscard]] int ExtraState() const { return buff_self_; }
+
+    void RestoreExtraState(const int state) { buff_self_ = state; }
+
+private:
+    int buff_self_ = 0;
+};
+
+class Mei final : public Player {
+public:
+    Mei() : Player(Character::MEI, "芽衣") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::MEI, ULT);
+            for (int i = 0; i < 5; ++i) {
+                const auto result = defender.DoUlt(round, *this, 3, Skill::MEI_ULT);
+                if (result != AttackResult::ALL_ALIVE) return result;
+            }
+        } else {
+            STAT(Character::MEI, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+
+            if (!is_charm && RandomChance(params->skill_at_most)) {
+                TRACE(round, Skill::MEI_PARALYZE, id, defender.id, 0, defender.hit);
+                defender.buff_opponent = 1;
+                STAT(Character::MEI, PARALYZE);
+            }
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+};
+
+class Bronya final : public Player {
+public:
+    Bronya() : Player(Character::BRONYA, "布洛妮娅") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::BRONYA, ULT);
+            const auto result = defender.DoUlt(round, *this, GetRandom(1, 100), Skill::BRONYA_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        } else {
+            STAT(Character::BRONYA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+
+            if (!is_charm && RandomChance(params->skill_below)) {
+                for (int i = 0; i < 4; ++i) {
+                    TRACE(round, Skill::BRONYA_REBUILD, id, defender.id, 0, defender.hit);
+                    const auto ex_result = defender.DoAtk(round, *this, 12 - defender.def);
+                    if (ex_result != AttackResult::ALL_ALIVE) return ex_result;
+                }
+            }
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+};
+
+class Himeko final : public Player {
+public:
+    Himeko() : Player(Character::HIMEKO, "姬子") {
+        if (is_group) {
+            TRACE(0, Skill::HIMEKO_TRUE_LOVE, id, id, 0, hit);
+        }
+    }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        const int gan = !is_charm && is_group ? 2 : 1;
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::HIMEKO, ULT);
+            TRACE(round, Skill::HIMEKO_CHEERS, id, id, 0, hit);
+            atk *= 2;
+            LowerHitRate(params->skill_rate);
+        }
+
+        STAT(Character::HIMEKO, ATTACK);
+        return defender.DoAtk(round, *this, (atk - defender.def) * gan);
+    }
+};
+
+class Rita final : public Player {
+public:
+    Rita() : Player(Character::RITA, "丽塔") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (IsUltRound(round)) {
+            STAT(Character::RITA, ULT);
+            if (is_skill_activate_) {
+                TRACE(round, Skill::RITA_CHARM, id, defender.id, 4, std::min(100, defender.hit + 4));
+            } else {
+                TRACE(round, Skill::RITA_CHARM_FIRST, id, defender.id, 4, std::min(100, defender.hit + 4));
+                is_skill_activate_ = true;
+            }
+
+            defender.hit        = std::min(100, defender.hit + 4);
+            defender.buff_charm = 2;
+            STAT(Character::RITA, CHARM);
+        } else {
+            int current_round_atk = atk;
+            if (RandomChance(params->skill_below)) {
+                current_round_atk = std::max(0, current_round_atk - 3);
+                defender.atk      = std::max(0, defender.atk - 4);
+                TRACE(round, Skill::RITA_CLEANUP, id, defender.id, 0, defender.hit);
+            }
+
+            STAT(Character::RITA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, current_round_atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+
+    AttackResult DoAtk(const int round, Player& attacker, const int atk) override { return Player::DoAtk(round, attacker, is_skill_activate_ ? static_cast<int>(std::round(static_cast<float>(atk) * params->damage_taken)) : atk); }
+
+    AttackResult DoUlt(const int round, Player& attacker, const int atk, const Skill skill) override { return Player::DoUlt(round, attacker, is_skill_activate_ ? static_cast<int>(std::round(static_cast<float>(atk) * params->damage_taken)) : atk, skill); }
+
+    [[nodiscard]] int ExtraState() const { return is_skill_activate_ ? 1 : 0; }
+
+    void RestoreExtraState(const int state) { is_skill_activate_ = state != 0; }
+
+private:
+    bool is_skill_activate_ = false;
+};
+
+class Sakura final : public Player {
+public:
+    Sakura() : Player(Character::SAKURA, "八重樱&卡莲") { is_group = true; }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && RandomChance(params->skill_at_most)) {
+            hit = std::min(100, hit + 25);
+            TRACE(round, Skill::SAKURA_RICE_BALL, id, id, 25, hit);
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::SAKURA, ULT);
+            const auto result = defender.DoUlt(round, *this, 25, Skill::SAKURA_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        } else {
+            STAT(Character::SAKURA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+};
+
+class Corvus final : public Player {
+public:
+    Corvus() : Player(Character::CORVUS, "渡鸦") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        float gan = 1.f;
+        if (!is_charm && (IsKiana(defender) || RandomChance(params->skill_at_most))) {
+            TRACE(round, Skill::CORVUS_NOT_YOU, id, defender.id, 0, defender.hit);
+            gan += 0.25f;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::CORVUS, ULT);
+            for (int i = 0; i < 7; ++i) {
+                const auto result = defender.DoUlt(round, *this, static_cast<int>(std::round(static_cast<float>(16 - defender.def) * gan)), Skill::CORVUS_ULT);
+                if (result != AttackResult::ALL_ALIVE) return result;
+            }
+        } else {
+            STAT(Character::CORVUS, ATTACK);
+            const auto result = defender.DoAtk(round, *this, static_cast<int>(std::round(static_cast<float>(atk - defender.def) * gan)));
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+
+private:
+    template <class Defender>
+    static bool IsKiana([[maybe_unused]] Defender& defender) {
+        if constexpr (std::is_same_v<Defender, Player>) {
+            return dynamic_cast<Kiana*>(&defender) != nullptr;
+        } else {
+            return std::is_same_v<Defender, Kiana>;
+        }
+    }
+};
+
+class Theresa final : public Player {
+public:
+    Theresa() : Player(Character::THERESA, "德莉莎") { is_group = true; }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::THERESA, ULT);
+            for (int i = 0; i < 5; ++i) {
+                const auto result = defender.DoUlt(round, *this, 16 - defender.def, Skill::THERESA_ULT);
+                if (result != AttackResult::ALL_ALIVE) return result;
+            }
+        } else {
+            STAT(Character::THERESA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk - defender.def);
+            if (result != AttackResult::ALL_ALIVE) return result;
+
+            if (!is_charm && RandomChance(params->skill_at_most)) {
+                TRACE(round, Skill::THERESA_CUTE, id, defender.id, 0, defender.hit);
+                defender.def = std::max(0, defender.def - 5);
+            }
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+};
+
+class Olenyeva final : public Player {
+public:
+    Olenyeva() : Player(Character::OLENYEVA, "萝莎莉娅&莉莉娅") { is_group = true; }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (boom_ > 0) {
+            --boom_;
+            STAT(Character::OLENYEVA, ULT);
+            defender.DoUlt(round, *this, RandomChance(params->skill_at_most) ? 233 : 50, Skill::OLENYEVA_ULT);
+        }
+
+        STAT(Character::OLENYEVA, ATTACK);
+        return defender.DoAtk(round, *this, atk - defender.def);
+    }
+
+    AttackResult DoAtk(const int round, Player& attacker, const int atk) override {
+        const int acc_atk = attacker.IsHit() ? std::max(0, atk) : 0;
+        hit -= acc_atk;
+        TRACE(round, Skill::ATTACK, attacker.id, id, acc_atk, hit);
+
+        if (hit <= 0) {
+            if (buff_charm == 0 && resurrection_stone_ > 0) {
+                hit   = params->revive_hit;
+                boom_ = 1;
+                TRACE(round, Skill::OLENYEVA_RESURRECT, id, id, hit, hit);
+                --resurrection_stone_;
+                STAT(Character::OLENYEVA, RESURRECT);
+                return AttackResult::ALL_ALIVE;
+            }
+            return AttackResult::DEFENDER_DEAD;
+        }
+        return AttackResult::ALL_ALIVE;
+    }
+
+    AttackResult DoUlt(const int round, Player& attacker, const int atk, const Skill skill) override {
+        const int acc_atk = attacker.IsHit() ? atk : 0;
+        hit -= acc_atk;
+        TRACE(round, skill, attacker.id, id, acc_atk, hit);
+
+        if (hit <= 0) {
+            if (buff_charm == 0 && resurrection_stone_ > 0) {
+                hit   = params->revive_hit;
+                boom_ = 1;
+                TRACE(round, Skill::OLENYEVA_RESURRECT, id, id, hit, hit);
+                --resurrection_stone_;
+                STAT(Character::OLENYEVA, RESURRECT);
+                return AttackResult::ALL_ALIVE;
+            }
+            return AttackResult::DEFENDER_DEAD;
+        }
+        return AttackResult::ALL_ALIVE;
+    }
+
+    [[nodiscard]] int ExtraState() const { return boom_ * 2 + resurrection_stone_; }
+
+    void RestoreExtraState(const int state) {
+        boom_               = state / 2;
+        resurrection_stone_ = state % 2;
+    }
+
+private:
+    int boom_               = 0;
+    int resurrection_stone_ = 1;
+};
+
+class Seele final : public Player {
+public:
+    Seele() : Player(Character::SEELE, "希儿") { is_group = true; }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        status_ ^= 1;
+        if (!is_charm) {
+            if (status_ == 0) {
+                [[maybe_unused]] const int origin_hit = hit;
+
+                hit = std::min(100, hit + GetRandom(1, 15));
+                def += 5;
+                atk -= 10;
+                TRACE(round, Skill::SEELE_WHITE, id, id, hit - origin_hit, hit);
+            } else {
+                def -= 5;
+                atk += 10;
+                TRACE(round, Skill::SEELE_BLACK, id, id, 0, hit);
+            }
+        }
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        STAT(Character::SEELE, ATTACK);
+        return defender.DoAtk(round, *this, atk - defender.def);
+    }
+
+    [[nodiscard]] int ExtraState() const { return status_; }
+
+    void RestoreExtraState(const int state) { status_ = state; }
+
+private:
+    int status_ = 0;  // 0 是白希，1是黑希
+};
+
+class Durandal final : public Player {
+public:
+    Durandal() : Player(Character::DURANDAL, "幽兰黛尔&史丹") { is_group = true; }
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        atk += 3;
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        STAT(Character::DURANDAL, ATTACK);
+        return defender.DoAtk(round, *this, atk - defender.def);
+    }
+
+    AttackResult DoUlt(int round, Player& attacker, const int atk, [[maybe_unused]] const Skill skill) override {
+        if (buff_charm == 0 && RandomChance(params->skill_below)) {
+            attacker.hit -= 30;
+            STAT(Character::DURANDAL, REFLECT);
+            return attacker.hit <= 0 ? AttackResult::ATTACKER_DEAD : AttackResult::ALL_ALIVE;
+        }
+        hit -= atk;
+        return hit <= 0 ? AttackResult::DEFENDER_DEAD : AttackResult::ALL_ALIVE;
+    }
+};
+
+class FuHua final : public Player {
+public:
+    FuHua() : Player(Character::FU_HUA, "符华") {}
+
+    AttackResult Attack(int round, Player& defender) override;
+
+    template <class Defender>
+    AttackResult AttackOn(const int round, Defender& defender) {
+        const bool is_charm = GetAndRefreshCharmState();
+
+        if (buff_opponent) {
+            --buff_opponent;
+            return AttackResult::ALL_ALIVE;
+        }
+
+        if (!is_charm && IsUltRound(round)) {
+            STAT(Character::FU_HUA, ULT);
+            const auto result = defender.DoUlt(round, *this, 18, Skill::FU_HUA_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+
+            defender.LowerHitRate(params->skill_rate);
+        } else {
+            STAT(Character::FU_HUA, ATTACK);
+            const auto result = defender.DoAtk(round, *this, atk);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+
+        return AttackResult::ALL_ALIVE;
+    }
+};
+
+inline std::shared_ptr<Player>
+GetPlayer(const Character& character) {
+    // clang-format off
+    switch (character) {
+    case Character::KIANA:    return std::make_shared<Kiana>();
+    case Character::MEI:      return std::make_shared<Mei>();
+    case Character::BRONYA:   return std::make_shared<Bronya>();
+    case Character::HIMEKO:   return std::make_shared<Himeko>();
+    case Character::RITA:     return std::make_shared<Rita>();
+    case Character::SAKURA:   return std::make_shared<Sakura>();
+    case Character::CORVUS:   return std::make_shared<Corvus>();
+    case Character::THERESA:  return std::make_shared<Theresa>();
+    case Character::OLENYEVA: return std::make_shared<Olenyeva>();
+    case Character::SEELE:    return std::make_shared<Seele>();
+    case Character::DURANDAL: return std::make_shared<Durandal>();
+    case Character::FU_HUA:   return std::make_shared<FuHua>();
+    default: abort();
+    }
+    // clang-format on
+}
+
+// 每个线程持有的角色存储槽，试验之间原地重置为初始属性，避免每场战斗都在堆上创建角色
+class FighterSlot {
+public:
+    FighterSlot() = default;
+
+    FighterSlot(const FighterSlot&)            = delete;
+    FighterSlot& operator=(const FighterSlot&) = delete;
+
+    ~FighterSlot() { Destroy(); }
+
+    Player& Reset(const Character character) {
+        Destroy();
+        // clang-format off
+        switch (character) {
+        case Character::KIANA:    player_ = new (&storage_) Kiana();    break;
+        case Character::MEI:      player_ = new (&storage_) Mei();      break;
+        case Character::BRONYA:   player_ = new (&storage_) Bronya();   break;
+        case Character::HIMEKO:   player_ = new (&storage_) Himeko();   break;
+        case Character::RITA:     player_ = new (&storage_) Rita();     break;
+        case Character::SAKURA:   player_ = new (&storage_) Sakura();   break;
+        case Character::CORVUS:   player_ = new (&storage_) Corvus();   break;
+        case Character::THERESA:  player_ = new (&storage_) Theresa();  break;
+        case Character::OLENYEVA: player_ = new (&storage_) Olenyeva(); break;
+        case Character::SEELE:    player_ = new (&storage_) Seele();    break;
+        case Character::DURANDAL: player_ = new (&storage_) Durandal(); break;
+        case Character::FU_HUA:   player_ = new (&storage_) FuHua();    break;
+        default: abort();
+        }
+        // clang-format on
+        return *player_;
+    }
+
+private:
+    void Destroy() {
+        if (player_ != nullptr) {
+            player_->~Player();
+            player_ = nullptr;
+        }
+    }
+
+    std::aligned_union_t<0, Kiana, Mei, Bronya, Himeko, Rita, Sakura, Corvus, Theresa, Olenyeva, Seele, Durandal, FuHua> storage_;
+    Player* player_ = nullptr;
+};
+
+// 与 Character 枚举顺序一致，供特化引擎在编译期由枚举值取得具体类型
+using CharacterTypes = std::tuple<Kiana, Mei, Bronya, Himeko, Rita, Sakura, Corvus, Theresa, Olenyeva, Seele, Durandal, FuHua>;
+
+template <Character C>
+using CharacterType = std::tuple_element_t<static_cast<std::size_t>(C), CharacterTypes>;
+
@@ -0,0 +1,319 @@
+#include "player.h"
+
+// 各角色 Attack 的参考实现：保留原版逐个虚函数分发的写法，必杀技回合直接取模，技能概率经由 RandomAtMost / RandomBelow 现算阈值，
+// Corvus 以 dynamic_cast 判断对手。AttackOn 模板是另行维护的优化版本，修改技能时两处都要改，--verify 与 honkai_tests 检查两者一致
+
+Player::AttackResult
+Kiana::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_self_ || buff_opponent) {
+        if (buff_self_) --buff_self_;
+        if (buff_opponent) --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::KIANA, ULT);
+        const auto result = defender.DoUlt(round, *this, atk + defender.def, Skill::KIANA_ULT);
+        if (result != AttackResult::ALL_ALIVE) return result;
+
+        if (RandomAtMost(params->skill_rate)) {
+            TRACE(round, Skill::KIANA_STUN, id, id, 0, hit);
+            buff_self_ = 1;
+            STAT(Character::KIANA, STUN);
+        }
+    } else {
+        STAT(Character::KIANA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Mei::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::MEI, ULT);
+        for (int i = 0; i < 5; ++i) {
+            const auto result = defender.DoUlt(round, *this, 3, Skill::MEI_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+    } else {
+        STAT(Character::MEI, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+
+        if (!is_charm && RandomAtMost(params->skill_rate)) {
+            TRACE(round, Skill::MEI_PARALYZE, id, defender.id, 0, defender.hit);
+            defender.buff_opponent = 1;
+            STAT(Character::MEI, PARALYZE);
+        }
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Bronya::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::BRONYA, ULT);
+        const auto result = defender.DoUlt(round, *this, GetRandom(1, 100), Skill::BRONYA_ULT);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    } else {
+        STAT(Character::BRONYA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+
+        if (!is_charm && RandomBelow(params->skill_rate)) {
+            for (int i = 0; i < 4; ++i) {
+                TRACE(round, Skill::BRONYA_REBUILD, id, defender.id, 0, defender.hit);
+                const auto ex_result = defender.DoAtk(round, *this, 12 - defender.def);
+                if (ex_result != AttackResult::ALL_ALIVE) return ex_result;
+            }
+        }
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Himeko::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    const int gan = !is_charm && is_group ? 2 : 1;
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::HIMEKO, ULT);
+        TRACE(round, Skill::HIMEKO_CHEERS, id, id, 0, hit);
+        atk *= 2;
+        SetHitRate(std::max(0.f, hit_rate - params->skill_rate));
+    }
+
+    STAT(Character::HIMEKO, ATTACK);
+    return defender.DoAtk(round, *this, (atk - defender.def) * gan);
+}
+
+Player::AttackResult
+Rita::Attack(const int round, Player& defender) {
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (round % params->period == 0) {
+        STAT(Character::RITA, ULT);
+        if (is_skill_activate_) {
+            TRACE(round, Skill::RITA_CHARM, id, defender.id, 4, std::min(100, defender.hit + 4));
+        } else {
+            TRACE(round, Skill::RITA_CHARM_FIRST, id, defender.id, 4, std::min(100, defender.hit + 4));
+            is_skill_activate_ = true;
+        }
+
+        defender.hit        = std::min(100, defender.hit + 4);
+        defender.buff_charm = 2;
+        STAT(Character::RITA, CHARM);
+    } else {
+        int current_round_atk = atk;
+        if (RandomBelow(params->skill_rate)) {
+            current_round_atk = std::max(0, current_round_atk - 3);
+            defender.atk      = std::max(0, defender.atk - 4);
+            TRACE(round, Skill::RITA_CLEANUP, id, defender.id, 0, defender.hit);
+        }
+
+        STAT(Character::RITA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, current_round_atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Sakura::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && RandomAtMost(params->skill_rate)) {
+        hit = std::min(100, hit + 25);
+        TRACE(round, Skill::SAKURA_RICE_BALL, id, id, 25, hit);
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::SAKURA, ULT);
+        const auto result = defender.DoUlt(round, *this, 25, Skill::SAKURA_ULT);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    } else {
+        STAT(Character::SAKURA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Corvus::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    float gan = 1.f;
+    if (!is_charm && (dynamic_cast<Kiana*>(&defender) != nullptr || RandomAtMost(params->skill_rate))) {
+        TRACE(round, Skill::CORVUS_NOT_YOU, id, defender.id, 0, defender.hit);
+        gan += 0.25f;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::CORVUS, ULT);
+        for (int i = 0; i < 7; ++i) {
+            const auto result = defender.DoUlt(round, *this, static_cast<int>(std::round(static_cast<float>(16 - defender.def) * gan)), Skill::CORVUS_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+    } else {
+        STAT(Character::CORVUS, ATTACK);
+        const auto result = defender.DoAtk(round, *this, static_cast<int>(std::round(static_cast<float>(atk - defender.def) * gan)));
+        if (result != AttackResult::ALL_ALIVE) return result;
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Theresa::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::THERESA, ULT);
+        for (int i = 0; i < 5; ++i) {
+            const auto result = defender.DoUlt(round, *this, 16 - defender.def, Skill::THERESA_ULT);
+            if (result != AttackResult::ALL_ALIVE) return result;
+        }
+    } else {
+        STAT(Character::THERESA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk - defender.def);
+        if (result != AttackResult::ALL_ALIVE) return result;
+
+        if (!is_charm && RandomAtMost(params->skill_rate)) {
+            TRACE(round, Skill::THERESA_CUTE, id, defender.id, 0, defender.hit);
+            defender.def = std::max(0, defender.def - 5);
+        }
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
+
+Player::AttackResult
+Olenyeva::Attack(const int round, Player& defender) {
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (boom_ > 0) {
+        --boom_;
+        STAT(Character::OLENYEVA, ULT);
+        defender.DoUlt(round, *this, RandomAtMost(params->skill_rate) ? 233 : 50, Skill::OLENYEVA_ULT);
+    }
+
+    STAT(Character::OLENYEVA, ATTACK);
+    return defender.DoAtk(round, *this, atk - defender.def);
+}
+
+Player::AttackResult
+Seele::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    status_ ^= 1;
+    if (!is_charm) {
+        if (status_ == 0) {
+            [[maybe_unused]] const int origin_hit = hit;
+
+            hit = std::min(100, hit + GetRandom(1, 15));
+            def += 5;
+            atk -= 10;
+            TRACE(round, Skill::SEELE_WHITE, id, id, hit - origin_hit, hit);
+        } else {
+            def -= 5;
+            atk += 10;
+            TRACE(round, Skill::SEELE_BLACK, id, id, 0, hit);
+        }
+    }
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    STAT(Character::SEELE, ATTACK);
+    return defender.DoAtk(round, *this, atk - defender.def);
+}
+
+Player::AttackResult
+Durandal::Attack(const int round, Player& defender) {
+    atk += 3;
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    STAT(Character::DURANDAL, ATTACK);
+    return defender.DoAtk(round, *this, atk - defender.def);
+}
+
+Player::AttackResult
+FuHua::Attack(const int round, Player& defender) {
+    const bool is_charm = GetAndRefreshCharmState();
+
+    if (buff_opponent) {
+        --buff_opponent;
+        return AttackResult::ALL_ALIVE;
+    }
+
+    if (!is_charm && round % params->period == 0) {
+        STAT(Character::FU_HUA, ULT);
+        const auto result = defender.DoUlt(round, *this, 18, Skill::FU_HUA_ULT);
+        if (result != AttackResult::ALL_ALIVE) return result;
+
+        defender.SetHitRate(std::max(0.f, defender.hit_rate - params->skill_rate));
+    } else {
+        STAT(Character::FU_HUA, ATTACK);
+        const auto result = defender.DoAtk(round, *this, atk);
+        if (result != AttackResult::ALL_ALIVE) return result;
+    }
+
+    return AttackResult::ALL_ALIVE;
+}
@@ -0,0 +1,330 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#    include <linux/perf_event.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#    define HONKAI_HAS_RDPMC 1
+#else
+#    define HONKAI_HAS_RDPMC 0
+#endif
+
+#include "random.h"
+
+// 标定读取开销时重复的次数
+constexpr int kCalibrationRounds = 100000;
+
+const char*
+PerfCounterName(const PerfCounter counter) {
+    // clang-format off
+    switch (counter) {
+    case PerfCounter::CYCLES:        return "周期";
+    case PerfCounter::INSTRUCTIONS:  return "指令";
+    case PerfCounter::BRANCH_MISSES: return "分支失误";
+    case PerfCounter::CACHE_MISSES:  return "缓存失误";
+    case PerfCounter::TASK_CLOCK:    return "CPU 时间";
+    default: return "";
+    }
+    // clang-format on
+}
+
+static uint64_t
+ReadTicks() {
+#if HONKAI_HAS_RDPMC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// 一次 read 的结果：enabled / running 为计数器启用与实际占用 PMU 的纳秒数，两者不等说明与其他事件分时复用
+struct CounterSample {
+    ProfileCounts counts;
+    uint64_t enabled[kNumOfPerfCounter] = {};
+    uint64_t running[kNumOfPerfCounter] = {};
+};
+
+// 调用线程的一组计数器。第一个打开的计数器为组长，其余加入同一组，由内核整组调度，IPC 等比值来自同一时段；
+// 打不开的记为不可用，其余照常工作
+class PerfCounters {
+public:
+    PerfCounters() {
+        std::fill(std::begin(fds_), std::end(fds_), -1);
+#if defined(__linux__)
+        // clang-format off
+        constexpr std::pair<uint32_t, uint64_t> kEvents[kNumOfPerfCounter] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+        };
+        // clang-format on
+
+        int leader = -1;
+        for (int i = 0; i < kNumOfPerfCounter; ++i) {
+            perf_event_attr attr{};
+            attr.size           = sizeof(attr);
+            attr.type           = kEvents[i].first;
+            attr.config         = kEvents[i].second;
+            attr.exclude_kernel = 1;  // perf_event_paranoid 为 2 时普通用户只能统计用户态
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            // 个别事件不能与组长同组时单独打开，读数照样按运行时间外推
+            if (fds_[i] < 0 && leader >= 0) fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[i] < 0) {
+                if (!unavailable_.empty()) unavailable_ += "，";
+                unavailable_ += std::string(PerfCounterName(static_cast<PerfCounter>(i))) + ": " + std::strerror(errno);
+                continue;
+            }
+            if (leader < 0) leader = fds_[i];
+
+#    if HONKAI_HAS_RDPMC
+            // 内核允许时把计数器页映射进来，之后可以用 rdpmc 在用户态读取，不必每次进入内核
+            void* page = mmap(nullptr, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)), PROT_READ, MAP_SHARED, fds_[i], 0);
+            if (page != MAP_FAILED) {
+                pages_[i] = static_cast<perf_event_mmap_page*>(page);
+                if (pages_[i]->cap_user_rdpmc == 0) {
+                    munmap(page, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+                    pages_[i] = nullptr;
+                }
+            }
+#    endif
+        }
+#else
+        unavailable_ = "需要 Linux 的 perf_event_open";
+#endif
+    }
+
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int i = 0; i < kNumOfPerfCounter; ++i) {
+            if (pages_[i] != nullptr) munmap(pages_[i], static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+            if (fds_[i] >= 0) close(fds_[i]);
+        }
+#endif
+    }
+
+    [[nodiscard]] bool Available(const int i) const { return fds_[i] >= 0; }
+
+    [[nodiscard]] bool PerTurn(const int i) const { return pages_[i] != nullptr; }
+
+    [[nodiscard]] const std::string& Unavailable() const { return unavailable_; }
+
+    // 经由 read 系统调用读取全部可用的计数器及其启用、运行时间，不可用的为 0
+    void Read(CounterSample& sample) const {
+        for (int i = 0; i < kNumOfPerfCounter; ++i) {
+            uint64_t values[3] = {};  // 计数值、启用时间、运行时间，顺序由 read_format 决定
+#if defined(__linux__)
+            if (fds_[i] >= 0 && read(fds_[i], values, sizeof(values)) != sizeof(values)) std::fill(std::begin(values), std::end(values), 0);
+#endif
+            sample.counts.value[i] = values[0];
+            sample.enabled[i]      = values[1];
+            sample.running[i]      = values[2];
+        }
+        sample.counts.ticks = ReadTicks();
+    }
+
+    // 只在用户态读取：可以 rdpmc 的计数器与时间戳，其余为 0
+    void ReadUser(ProfileCounts& counts) const {
+        for (int i = 0; i < kNumOfPerfCounter; ++i) counts.value[i] = pages_[i] != nullptr ? ReadMapped(pages_[i]) : 0;
+        counts.ticks = ReadTicks();
+    }
+
+private:
+#if defined(__linux__)
+    using MappedPage = perf_event_mmap_page;
+#else
+    struct MappedPage {};
+#endif
+
+    // 按 perf_event_mmap_page 的约定读取：lock 前后不变时 offset 与 rdpmc 的读数属于同一时刻
+    static uint64_t ReadMapped([[maybe_unused]] const MappedPage* page) {
+#if defined(__linux__) && HONKAI_HAS_RDPMC
+        const volatile MappedPage* mapped = page;
+        uint32_t sequence;
+        uint64_t count;
+        do {
+            sequence = mapped->lock;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            const uint32_t index = mapped->index;
+            count                = static_cast<uint64_t>(mapped->offset);
+            if (mapped->cap_user_rdpmc != 0 && index != 0) {
+                const int shift = 64 - mapped->pmc_width;
+                count += static_cast<uint64_t>(static_cast<int64_t>(static_cast<uint64_t>(__rdpmc(static_cast<int>(index - 1))) << shift) >> shift);
+            }
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while (mapped->lock != sequence);
+        return count;
+#else
+        return 0;
+#endif
+    }
+
+    int fds_[kNumOfPerfCounter];
+    MappedPage* pages_[kNumOfPerfCounter] = {};
+    std::string unavailable_;
+};
+
+// RunBattle 的出招钩子：出招前后各读一次用户态计数器，增量记到出招方名下
+class TurnSampler {
+public:
+    TurnSampler(const PerfCounters& counters, TurnProfile& profile) : counters_(counters), profile_(profile) {}
+
+    void Begin() { counters_.ReadUser(begin_); }
+
+    void End(const Character attacker) {
+        ProfileCounts end;
+        counters_.ReadUser(end);
+
+        const auto a = static_cast<std::size_t>(attacker);
+        for (int i = 0; i < kNumOfPerfCounter; ++i) profile_.counts[a].value[i] += end.value[i] - begin_.value[i];
+        profile_.counts[a].ticks += end.ticks - begin_.ticks;
+        ++profile_.turns[a];
+    }
+
+private:
+    const PerfCounters& counters_;
+    TurnProfile& profile_;
+    ProfileCounts begin_;
+};
+
+using TurnKernel = void (*)(MatchupResult& result, TurnSampler& sampler, uint64_t seed, uint64_t begin, uint64_t end);
+
+// 与特化引擎的 SimulateRange 相同，只是每次出招都经过 sampler
+template <Character C0, Character C1, bool P0First>
+struct ProfiledKernel {
+    static void Run(MatchupResult& result, TurnSampler& sampler, const uint64_t seed, const uint64_t begin, const uint64_t end) {
+        constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+        using T0 = CharacterType<C0>;
+        using T1 = CharacterType<C1>;
+
+        const int max_rounds = MaxRounds();
+
+        const T0 initial_0;
+        const T1 initial_1;
+
+        T0 p_0;
+        T1 p_1;
+
+        for (uint64_t k = begin; k < end; ++k) {
+            SeedTrial(seed, matchup, k);
+
+            p_0 = initial_0;
+            p_1 = initial_1;
+
+            if constexpr (P0First) {
+                Accumulate(result, RunBattle(p_0, p_1, max_rounds, 1, sampler), true);
+            } else {
+                Accumulate(result, RunBattle(p_1, p_0, max_rounds, 1, sampler), false);
+            }
+        }
+    }
+};
+
+constexpr auto kProfiledKernels = MakeKernelTable<TurnKernel, ProfiledKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+// 两次读取之间的增量；计数器只运行了部分时间时按 enabled / running 外推，并在 multiplexed 中标出
+static ProfileCounts
+Difference(const CounterSample& end, const CounterSample& begin, bool (&multiplexed)[kNumOfPerfCounter]) {
+    ProfileCounts diff;
+    for (int i = 0; i < kNumOfPerfCounter; ++i) {
+        const uint64_t value   = end.counts.value[i] - begin.counts.value[i];
+        const uint64_t enabled = end.enabled[i] - begin.enabled[i];
+        const uint64_t running = end.running[i] - begin.running[i];
+        diff.value[i]          = value;
+        if (running < enabled) {
+            multiplexed[i] = true;
+            diff.value[i]  = running > 0 ? static_cast<uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) / static_cast<double>(running)) : 0;
+        }
+    }
+    diff.ticks = end.counts.ticks - begin.counts.ticks;
+    return diff;
+}
+
+ProfileReport
+ProfileMatchups(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine) {
+    ProfileReport report;
+    const PerfCounters counters;
+    for (int i = 0; i < kNumOfPerfCounter; ++i) {
+        report.available[i] = counters.Available(i);
+        report.per_turn[i]  = counters.PerTurn(i);
+    }
+    report.unavailable = counters.Unavailable();
+#if HONKAI_HAS_RDPMC
+    report.ticks_unit = "TSC 周期";
+#else
+    report.ticks_unit = "纳秒";
+#endif
+
+    // 两次读取之间什么也不做时的增量，即每次出招多出的读取开销
+    TurnProfile calibration;
+    TurnSampler calibration_sampler(counters, calibration);
+    for (int r = 0; r < kCalibrationRounds; ++r) {
+        calibration_sampler.Begin();
+        calibration_sampler.End(Character::KIANA);
+    }
+
+    const CharacterTable* const saved_table = g_character_table;
+
+    for (const auto& task : tasks) {
+        g_character_table = &task.Table();
+
+        MatchupProfile profile;
+        const RangeKernel kernel = GetRangeKernel(task.c0, task.c1, engine, task.Table());
+
+        CounterSample begin;
+        CounterSample end;
+        const auto start = std::chrono::steady_clock::now();
+        counters.Read(begin);
+        kernel(profile.result, seed, task.begin, task.begin + task.times);
+        counters.Read(end);
+        profile.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        profile.counts  = Difference(end, begin, report.multiplexed);
+        report.matchups.push_back(profile);
+
+        MatchupResult turn_result;
+        TurnSampler sampler(counters, report.turns);
+        kProfiledKernels[KernelIndex(task.c0, task.c1, task.Table())](turn_result, sampler, seed, task.begin, task.begin + std::min(task.times, kProfileTurnBattles));
+    }
+
+    g_character_table = saved_table;
+
+    // rdpmc 读不到计数器未被调度的那段时间，分时复用的计数器不按出招拆分
+    for (int i = 0; i < kNumOfPerfCounter; ++i) {
+        if (report.multiplexed[i]) report.per_turn[i] = false;
+    }
+
+    // 扣除读取开销，统计噪声可能使个别计数略低于开销，此时记为 0
+    const auto overhead = [&](const uint64_t total, const uint64_t turns) { return static_cast<uint64_t>(static_cast<double>(total) / kCalibrationRounds * static_cast<double>(turns)); };
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        ProfileCounts& counts = report.turns.counts[c];
+        const uint64_t turns  = report.turns.turns[c];
+        for (int i = 0; i < kNumOfPerfCounter; ++i) counts.value[i] -= std::min(counts.value[i], overhead(calibration.counts[0].value[i], turns));
+        counts.ticks -= std::min(counts.ticks, overhead(calibration.counts[0].ticks, turns));
+    }
+
+    return report;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "character.h"
+#include "engine.h"
+
+enum class PerfCounter : int {
+    CYCLES,         // 核心周期
+    INSTRUCTIONS,   // 退休的指令数
+    BRANCH_MISSES,  // 分支预测失误
+    CACHE_MISSES,   // 末级缓存未命中
+    TASK_CLOCK,     // 线程占用 CPU 的纳秒数（软件计数器）
+    NUM_OF_PERF_COUNTER
+};
+
+constexpr int kNumOfPerfCounter = static_cast<int>(PerfCounter::NUM_OF_PERF_COUNTER);
+
+// 未指定 --times 时每个对局的场次；剖析在调用线程上串行进行
+constexpr uint64_t kProfileTimes = 1000000;
+
+// 剖析出招时每个对局至多进行的场次：逐次出招读取计数器的开销远大于一次出招本身，用少量场次即可得到稳定的均值
+constexpr uint64_t kProfileTurnBattles = 200000;
+
+// 一段代码的计数器增量；ticks 为逐次出招时在用户态读取的时间戳（x86 上为 TSC 参考周期，其他平台为纳秒）
+struct ProfileCounts {
+    uint64_t value[kNumOfPerfCounter] = {};
+    uint64_t ticks                    = 0;
+
+    ProfileCounts& operator+=(const ProfileCounts& other) {
+        for (int i = 0; i < kNumOfPerfCounter; ++i) value[i] += other.value[i];
+        ticks += other.ticks;
+        return *this;
+    }
+};
+
+struct MatchupProfile {
+    MatchupResult result;
+    ProfileCounts counts;     // 整个对局，不含逐次出招的读取开销
+    double seconds = 0.;
+};
+
+// 按出招方统计的每次出招的开销，已扣除读取计数器本身的开销
+struct TurnProfile {
+    uint64_t turns[kNumOfCharacter] = {};
+    ProfileCounts counts[kNumOfCharacter];
+};
+
+struct ProfileReport {
+    bool available[kNumOfPerfCounter]   = {};  // perf_event_open 成功打开的计数器
+    bool per_turn[kNumOfPerfCounter]    = {};  // 可以用 rdpmc 在用户态读取、因而能按出招拆分的计数器
+    bool multiplexed[kNumOfPerfCounter] = {};  // 与其他事件分时复用过的计数器，整对局的读数已按运行时间外推
+    std::string unavailable;                   // 打不开的计数器及原因，全部可用时为空
+    const char* ticks_unit = "";
+    std::vector<MatchupProfile> matchups;      // 与 tasks 一一对应
+    TurnProfile turns;                         // 所有对局合计
+};
+
+// 在调用线程上逐个对局串行运行 engine 的内核，用 perf_event_open 读取调用线程的计数器；
+// 再用特化内核对每个对局至多 kProfileTurnBattles 场逐次出招读取计数器，按出招方拆分。
+// 计数器不可用（非 Linux、权限不足、虚拟机没有 PMU）时对应的项为 0 并在 unavailable 中说明，其余照常报告
+ProfileReport
+ProfileMatchups(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine);
+
+const char*
+PerfCounterName(PerfCounter counter);
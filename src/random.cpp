@@ -0,0 +1,24 @@
+#include "random.h"
+
+// 各次抽取互不依赖，循环由编译器向量化
+void
+RandomStream::Refill() {
+    for (int i = 0; i < kBlock; ++i) buffer_[i] = static_cast<uint32_t>(Mix64(key_ + counter_ + kGamma * static_cast<uint64_t>(i + 1)) >> 32);
+    counter_ += kGamma * kBlock;
+    next_ = 0;
+}
+
+int
+HookedRandom(const int min_value, const int max_value) {
+    if (RandomScript* const script = g_random_hooks->script) {
+        return min_value + script->Choose(max_value - min_value + 1, [=](int) { return RandomStream::ProbabilityOfInt(min_value, max_value); });
+    }
+    RandomOverride& override = *g_random_hooks->override;
+    return RandomStream::BoundedInt([&override] { return override.NextBits(g_random_stream); }, min_value, max_value);
+}
+
+bool
+HookedChance(const uint64_t threshold) {
+    if (RandomScript* const script = g_random_hooks->script) return script->Chance(RandomStream::ProbabilityOfChance(threshold));
+    return g_random_hooks->override->NextBits(g_random_stream) < threshold;
+}
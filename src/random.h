@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SplitMix64 的混合函数，对 64 位输入是双射；模板形式同时供批量引擎的向量类型使用
+template <class T>
+constexpr T
+Mix64(T x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// 基于计数器的随机数流：第 i 次抽取只取决于 (key, i)，每场试验由 (种子, 对局, 试验序号) 派生独立的 key，
+// 因此结果与线程数和调度顺序无关。抽取按 kBlock 个一组批量算出，逐个取用，与逐次计算的序列完全相同
+class RandomStream {
+public:
+    static constexpr uint64_t kGamma = 0x9E3779B97F4A7C15ull;
+
+    // 一组的抽取个数：一场战斗通常需要二三十次抽取，过大的组在战斗结束时浪费较多
+    static constexpr int kBlock = 16;
+
+    // 总为真的判定阈值
+    static constexpr uint64_t kAlways = uint64_t{1} << 32;
+
+    RandomStream() = default;
+
+    RandomStream(const uint64_t seed, const uint64_t matchup, const uint64_t trial) { Seed(seed, matchup, trial); }
+
+    static constexpr uint64_t MakeKey(const uint64_t seed, const uint64_t matchup, const uint64_t trial) { return Mix64(Mix64(Mix64(seed) ^ matchup) ^ trial); }
+
+    // 切换到另一场试验，缓冲区留到第一次抽取时再填
+    void Seed(const uint64_t seed, const uint64_t matchup, const uint64_t trial) {
+        key_     = MakeKey(seed, matchup, trial);
+        counter_ = 0;
+        next_    = kBlock;
+    }
+
+    uint32_t NextBits() {
+        if (next_ == kBlock) Refill();
+        return buffer_[next_++];
+    }
+
+    // [0, 1) 上步长为 2^-24 的均匀浮点数
+    float NextFloat() { return static_cast<float>(NextBits() >> 8) * 0x1p-24f; }
+
+    // 以 threshold / 2^32 的概率返回 true
+    bool NextChance(const uint64_t threshold) { return NextBits() < threshold; }
+
+    // [min_value, max_value] 上均匀的整数
+    int NextInt(const int min_value, const int max_value) {
+        return BoundedInt([this] { return NextBits(); }, min_value, max_value);
+    }
+
+    // 用乘法取高位代替取模；积的低 32 位小于 2^32 mod range 时拒绝并重抽（Lemire 的方法），各取值严格等概率。
+    // 拒绝的概率不超过 range / 2^32，几乎总是只抽一次
+    template <class Draw>
+    static int BoundedInt(const Draw& draw, const int min_value, const int max_value) {
+        const auto range = static_cast<uint32_t>(static_cast<int64_t>(max_value) - min_value + 1);
+        uint64_t product = static_cast<uint64_t>(draw()) * range;
+        if (static_cast<uint32_t>(product) < range) {
+            const uint32_t reject = (0u - range) % range;
+            while (static_cast<uint32_t>(product) < reject) product = static_cast<uint64_t>(draw()) * range;
+        }
+        return min_value + static_cast<int>(product >> 32);
+    }
+
+    // NextFloat() <= p 当且仅当 NextBits() < AtMostThreshold(p)，判定时不必把随机位转换成浮点数。
+    // [0, 1) 内的 p 乘以 2^24 没有舍入，截断即为向下取整
+    static constexpr uint64_t AtMostThreshold(const float p) {
+        if (!(p >= 0.f)) return 0;
+        if (p >= 1.f) return kAlways;
+        return (static_cast<uint64_t>(static_cast<uint32_t>(p * 0x1p24f)) + 1) << 8;
+    }
+
+    // NextFloat() < p 当且仅当 NextBits() < BelowThreshold(p)
+    static constexpr uint64_t BelowThreshold(const float p) {
+        if (!(p > 0.f)) return 0;
+        if (p >= 1.f) return kAlways;
+        const float scaled   = p * 0x1p24f;
+        const uint32_t floor = static_cast<uint32_t>(scaled);
+        return static_cast<uint64_t>(static_cast<float>(floor) < scaled ? floor + 1 : floor) << 8;
+    }
+
+    // 以下给出上面各抽样方式的精确分布，供精确求解器使用，与蒙特卡洛引擎的期望完全一致
+
+    static double ProbabilityOfChance(const uint64_t threshold) { return static_cast<double>(threshold) * 0x1p-32; }
+
+    // NextInt(min_value, max_value) 取各值的概率
+    static double ProbabilityOfInt(const int min_value, const int max_value) { return 1. / static_cast<double>(static_cast<int64_t>(max_value) - min_value + 1); }
+
+private:
+    // 一次算出接下来 kBlock 次抽取；放在 random.cpp 中不内联，各抽取点只保留取用缓冲区的几条指令
+    void Refill();
+
+    uint64_t key_     = 0;
+    uint64_t counter_ = 0;
+    int next_         = kBlock;
+    uint32_t buffer_[kBlock] = {};
+};
+
+// 当前线程正在进行的试验所使用的随机数流，由引擎在每场试验开始前设置
+inline thread_local RandomStream g_random_stream;
+
+inline void
+SeedTrial(const uint64_t seed, const uint64_t matchup, const uint64_t trial) {
+    g_random_stream.Seed(seed, matchup, trial);
+}
+
+// 精确求解器用的随机脚本：每个随机决策点不再抽样，而是按脚本选择一个分支并累乘其概率，
+// 反复 Rewind/Advance 即可深度优先地枚举一次出招的全部分支
+class RandomScript {
+public:
+    // 从头重放当前路径
+    void Rewind() {
+        position_    = 0;
+        probability_ = 1.;
+    }
+
+    // 切换到下一条未枚举的路径，全部枚举完毕时返回 false
+    bool Advance() {
+        while (!choices_.empty() && choices_.back().option + 1 == choices_.back().num_options) choices_.pop_back();
+        if (choices_.empty()) return false;
+        ++choices_.back().option;
+        return true;
+    }
+
+    [[nodiscard]] double Probability() const { return probability_; }
+
+    // 以概率 p 返回 true，必然或不可能的事件不产生分支
+    bool Chance(const double p) {
+        if (p >= 1.) return true;
+        if (p <= 0.) return false;
+        return Choose(2, [p](const int option) { return option == 0 ? p : 1. - p; }) == 0;
+    }
+
+    // 在 num_options 个分支中选择一个，weight(i) 为第 i 个分支的概率
+    template <class Weight>
+    int Choose(const int num_options, const Weight& weight) {
+        if (position_ == choices_.size()) choices_.push_back({0, num_options});
+        const int option = choices_[position_++].option;
+        probability_ *= weight(option);
+        return option;
+    }
+
+private:
+    struct Choice {
+        int option;
+        int num_options;
+    };
+
+    std::vector<Choice> choices_;
+    std::size_t position_ = 0;
+    double probability_   = 1.;
+};
+
+// 拟随机点至多替换每场试验的前 kMaxQmcDims 次抽取
+constexpr int kMaxQmcDims = 8;
+
+// 方差缩减对一场试验的随机数所做的替换，由 variance.cpp 在每场试验开始前填写
+struct RandomOverride {
+    uint32_t flip                = 0;  // 对偶试验取反全部随机位，均匀数 u 随之变为约 1 - u
+    int num_points               = 0;  // 前 num_points 次抽取改用 points
+    int used                     = 0;
+    uint32_t points[kMaxQmcDims] = {};
+
+    // 被替换的抽取仍推进 stream 的计数器，之后的抽取与不做替换时对齐
+    uint32_t NextBits(RandomStream& stream) {
+        const uint32_t bits = stream.NextBits();
+        if (used < num_points) return points[used++] ^ flip;
+        return bits ^ flip;
+    }
+};
+
+// 改变当前线程抽取方式的钩子：精确求解时所有随机决策改由 script 决定，方差缩减时随机位按 override 替换。
+// 放在一个指针后面，蒙特卡洛引擎每次抽取只多一次判断
+struct RandomHooks {
+    RandomScript* script     = nullptr;
+    RandomOverride* override = nullptr;
+};
+
+inline thread_local const RandomHooks* g_random_hooks = nullptr;
+
+// 钩子非空时的抽取，不内联，蒙特卡洛引擎中各角色出招函数的体积与内联决策不受影响
+int
+HookedRandom(int min_value, int max_value);
+
+bool
+HookedChance(uint64_t threshold);
+
+inline int
+GetRandom(const int min_value, const int max_value) {
+    if (g_random_hooks != nullptr) return HookedRandom(min_value, max_value);
+    return g_random_stream.NextInt(min_value, max_value);
+}
+
+// 以 threshold / 2^32 的概率返回 true；阈值由 RandomStream::AtMostThreshold / BelowThreshold 预先算好
+inline bool
+RandomChance(const uint64_t threshold) {
+    if (g_random_hooks != nullptr) return HookedChance(threshold);
+    return g_random_stream.NextChance(threshold);
+}
+
+// 等价于按 NextFloat() <= p 判定，并同样经过 g_random_hooks；p 为常量时阈值在编译期算出
+inline bool
+RandomAtMost(const float p) {
+    return RandomChance(RandomStream::AtMostThreshold(p));
+}
+
+// 等价于按 NextFloat() < p 判定
+inline bool
+RandomBelow(const float p) {
+    return RandomChance(RandomStream::BelowThreshold(p));
+}
@@ -0,0 +1,289 @@
+#include "result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#    include <fcntl.h>
+#    include <sys/file.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "random.h"
+
+constexpr char kCacheMagic[8]             = {'H', 'K', 'C', 'A', 'C', 'H', 'E', '\0'};
+constexpr uint32_t kCacheVersion          = 1;
+constexpr uint64_t kCacheCapacity         = 1024;
+constexpr uint64_t kCacheCheckpointTrials = uint64_t{1} << 21;
+
+static_assert(sizeof(CacheEntry) == 112, "cache entries are stored on disk as is");
+
+static uint64_t
+CacheKey(const MatchupTask& task, const uint64_t seed) {
+    const CharacterTable& table = task.Table();
+
+    uint64_t key = Mix64(seed ^ kSimulationRevision);
+    key          = Mix64(key ^ (static_cast<uint64_t>(task.c0) * kNumOfCharacter + static_cast<uint64_t>(task.c1)));
+    key          = Mix64(key ^ CharacterDefinitionHash(task.c0, table));
+    key          = Mix64(key ^ CharacterDefinitionHash(task.c1, table));
+    key          = Mix64(key ^ static_cast<uint64_t>(MaxRounds()));
+    return key != 0 ? key : 1;
+}
+
+static std::size_t
+MappedBytes(const uint64_t capacity) {
+    return sizeof(CacheHeader) + static_cast<std::size_t>(capacity) * sizeof(CacheEntry);
+}
+
+#if !defined(_WIN32)
+// 把已打开的文件映射进内存；新文件先按 capacity 扩展并写好文件头
+static bool
+MapCacheFile(const int fd, const uint64_t capacity, CacheHeader*& header, std::size_t& bytes) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) return false;
+
+    const bool created = st.st_size == 0;
+    if (created) {
+        if (ftruncate(fd, static_cast<off_t>(MappedBytes(capacity))) != 0) return false;
+        bytes = MappedBytes(capacity);
+    } else {
+        bytes = static_cast<std::size_t>(st.st_size);
+        if (bytes < sizeof(CacheHeader)) return false;
+    }
+
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) return false;
+    header = static_cast<CacheHeader*>(address);
+
+    if (created) {
+        memcpy(header->magic, kCacheMagic, sizeof(header->magic));
+        header->version    = kCacheVersion;
+        header->entry_size = sizeof(CacheEntry);
+        header->capacity   = capacity;
+        header->count      = 0;
+    }
+
+    const bool valid = memcmp(header->magic, kCacheMagic, sizeof(kCacheMagic)) == 0 && header->version == kCacheVersion && header->entry_size == sizeof(CacheEntry) && header->capacity != 0 && (header->capacity & (header->capacity - 1)) == 0 && MappedBytes(header->capacity) == bytes;
+    if (!valid) {
+        munmap(address, bytes);
+        header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+ResultCache::~ResultCache() {
+    Close();
+}
+
+bool
+ResultCache::Open(const char* path) {
+    Close();
+
+    const int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "无法打开结果缓存: %s\n", path);
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        fprintf(stderr, "结果缓存正被其他进程使用: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    CacheHeader* header = nullptr;
+    std::size_t bytes   = 0;
+    if (!MapCacheFile(fd, kCacheCapacity, header, bytes)) {
+        fprintf(stderr, "不是有效的结果缓存文件: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    path_    = path;
+    fd_      = fd;
+    bytes_   = bytes;
+    header_  = header;
+    entries_ = reinterpret_cast<CacheEntry*>(header + 1);
+    return true;
+}
+
+void
+ResultCache::Close() {
+    if (header_ != nullptr) {
+        msync(header_, bytes_, MS_SYNC);
+        munmap(header_, bytes_);
+    }
+    if (fd_ >= 0) close(fd_);
+
+    fd_      = -1;
+    bytes_   = 0;
+    header_  = nullptr;
+    entries_ = nullptr;
+}
+
+bool
+ResultCache::Grow() {
+    const std::string temp_path = path_ + ".tmp";
+    const int fd                = open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    CacheHeader* header = nullptr;
+    std::size_t bytes   = 0;
+    if (!MapCacheFile(fd, header_->capacity * 2, header, bytes)) {
+        close(fd);
+        return false;
+    }
+
+    // 新文件写完并落盘后才替换原文件，替换前被杀掉时原文件保持完整
+    auto* entries = reinterpret_cast<CacheEntry*>(header + 1);
+    for (uint64_t e = 0; e < header_->capacity; ++e) {
+        if (entries_[e].key == 0) continue;
+        for (uint64_t slot = entries_[e].key & (header->capacity - 1);; slot = (slot + 1) & (header->capacity - 1)) {
+            if (entries[slot].key != 0) continue;
+            entries[slot] = entries_[e];
+            break;
+        }
+    }
+    header->count = header_->count;
+    msync(header, bytes, MS_SYNC);
+
+    if (rename(temp_path.c_str(), path_.c_str()) != 0) {
+        munmap(header, bytes);
+        close(fd);
+        return false;
+    }
+
+    munmap(header_, bytes_);
+    close(fd_);
+    fd_      = fd;
+    bytes_   = bytes;
+    header_  = header;
+    entries_ = entries;
+    return true;
+}
+#else
+// 缓存依赖 POSIX 的 mmap 与 flock
+ResultCache::~ResultCache() = default;
+
+bool
+ResultCache::Open(const char* path) {
+    fprintf(stderr, "此平台不支持结果缓存: %s\n", path);
+    return false;
+}
+
+void
+ResultCache::Close() {}
+
+bool
+ResultCache::Grow() {
+    return false;
+}
+#endif
+
+CacheEntry*
+ResultCache::Find(const uint64_t key) const {
+    const uint64_t mask = header_->capacity - 1;
+    for (uint64_t slot = key & mask;; slot = (slot + 1) & mask) {
+        if (entries_[slot].key == key || entries_[slot].key == 0) return &entries_[slot];
+    }
+}
+
+MatchupResult
+ResultCache::Lookup(const MatchupTask& task, const uint64_t seed) const {
+    MatchupResult result;
+    if (header_ == nullptr) return result;
+
+    const CacheEntry* entry = Find(CacheKey(task, seed));
+    if (entry->key == 0) return result;
+
+    const CachedCounts& counts = entry->counts[entry->generation & 1];
+    result.p0_win              = counts.p0_win;
+    result.p1_win              = counts.p1_win;
+    result.draw                = counts.draw;
+    result.attacker_dead       = counts.attacker_dead;
+    result.rounds              = counts.rounds;
+    return result;
+}
+
+bool
+ResultCache::Append(const MatchupTask& task, const uint64_t seed, const MatchupResult& result) {
+    if (header_ == nullptr) return false;
+
+    const uint64_t key = CacheKey(task, seed);
+    CacheEntry* entry  = Find(key);
+    if (entry->key == 0) {
+        if (task.begin != 0) return false;
+
+        // 装填率保持在一半以下
+        if ((header_->count + 1) * 2 > header_->capacity) {
+            if (!Grow()) return false;
+            entry = Find(key);
+        }
+
+        // 键最后写入，之前被杀掉时这一项仍是空位
+        *entry      = {};
+        entry->seed = seed;
+        entry->c0   = static_cast<uint8_t>(task.c0);
+        entry->c1   = static_cast<uint8_t>(task.c1);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry->key = key;
+        ++header_->count;
+    }
+
+    const CachedCounts& counts = entry->counts[entry->generation & 1];
+    if (counts.p0_win + counts.p1_win + counts.draw != task.begin) return false;
+
+    entry->counts[(entry->generation + 1) & 1] = {counts.p0_win + result.p0_win, counts.p1_win + result.p1_win, counts.draw + result.draw, counts.attacker_dead + result.attacker_dead, counts.rounds + result.rounds};
+    std::atomic_thread_fence(std::memory_order_release);
+    ++entry->generation;
+    return true;
+}
+
+std::vector<MatchupResult>
+RunMatchupsCached(const std::vector<MatchupTask>& tasks, const uint64_t seed, const Engine engine, ResultCache& cache, CachedRunStats& stats) {
+    std::vector<MatchupResult> results(tasks.size());
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        results[t] = cache.Lookup({tasks[t].c0, tasks[t].c1, tasks[t].times, 0, tasks[t].table}, seed);
+        stats.cached_battles += results[t].Battles();
+        stats.reused_matchups += results[t].Battles() >= tasks[t].times ? 1 : 0;
+    }
+
+    // 同一对局在 tasks 中出现多次时只由第一次写入缓存，其余的续跑接不上已缓存的试验
+    std::vector<bool> writer(tasks.size(), true);
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        for (std::size_t u = 0; u < t && writer[t]; ++u) writer[t] = CacheKey(tasks[u], seed) != CacheKey(tasks[t], seed);
+    }
+
+    bool caching = true;
+    for (;;) {
+        std::vector<MatchupTask> blocks;
+        std::vector<std::size_t> pending;
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            const uint64_t done = results[t].Battles();
+            if (done >= tasks[t].times) continue;
+            blocks.push_back({tasks[t].c0, tasks[t].c1, std::min(tasks[t].times - done, kCacheCheckpointTrials), done, tasks[t].table});
+            pending.push_back(t);
+        }
+        if (blocks.empty()) break;
+
+        const std::vector<MatchupResult> block_results = RunMatchups(blocks, seed, engine);
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            results[pending[b]] += block_results[b];
+            stats.simulated_battles += block_results[b].Battles();
+            if (!caching || !writer[pending[b]]) continue;
+            if (!cache.Append(blocks[b], seed, block_results[b])) {
+                fprintf(stderr, "写入缓存失败，本次运行的其余结果不再写入缓存\n");
+                caching = false;
+            }
+        }
+    }
+
+    return results;
+}
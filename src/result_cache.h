@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+
+// 随机数流或试验的派生方式改变、同样的试验序号不再产生同样的战斗时递增，使所有已缓存的结果失效
+constexpr uint64_t kSimulationRevision = 2;
+
+// 一个对局在 [0, Battles()) 号试验上的累计计数
+struct CachedCounts {
+    uint64_t p0_win        = 0;
+    uint64_t p1_win        = 0;
+    uint64_t draw          = 0;
+    uint64_t attacker_dead = 0;
+    uint64_t rounds        = 0;
+};
+
+// 缓存文件中的一项。counts 有两份，generation 的最低位指向有效的一份：先写另一份再递增 generation，
+// 进程在任何时刻被杀掉都不会留下写了一半的计数
+struct CacheEntry {
+    uint64_t key;  // 0 表示空位
+    uint64_t seed;
+    uint8_t c0;
+    uint8_t c1;
+    uint8_t reserved[6];
+    uint64_t generation;
+    CachedCounts counts[2];
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t capacity;  // 开放寻址散列表的槽数，总为 2 的幂
+    uint64_t count;
+};
+
+// 以 (种子, 对局, 双方的角色定义, 回合上限) 为键的对局结果，映射到内存中的开放寻址散列表；先后手由双方速度决定，
+// 已包含在角色定义中。只缓存从 0 号试验开始的连续一段，后续的运行在其后追加，以逐次提高精度或续跑中断的扫描。
+// 打开期间对文件加独占锁，同一时刻只允许一个进程写入
+class ResultCache {
+public:
+    ResultCache() = default;
+
+    ResultCache(const ResultCache&)            = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    ~ResultCache();
+
+    // 打开或创建缓存文件；文件格式不符或被其他进程占用时在 stderr 说明原因并返回 false
+    bool Open(const char* path);
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return header_ != nullptr; }
+
+    [[nodiscard]] std::size_t Size() const { return header_ != nullptr ? static_cast<std::size_t>(header_->count) : 0; }
+
+    // 该对局已缓存的结果，覆盖 [0, Battles()) 号试验；没有时返回空结果
+    [[nodiscard]] MatchupResult Lookup(const MatchupTask& task, uint64_t seed) const;
+
+    // 把 [task.begin, task.begin + result.Battles()) 号试验的结果累加进缓存；task.begin 必须恰好接在已缓存的试验之后，否则不写入并返回 false；
+    // 需要扩容而扩容失败时同样返回 false
+    [[nodiscard]] bool Append(const MatchupTask& task, uint64_t seed, const MatchupResult& result);
+
+private:
+    [[nodiscard]] CacheEntry* Find(uint64_t key) const;
+
+    // 把全部项重新散列到容量加倍的新文件，写好后再替换原文件
+    [[nodiscard]] bool Grow();
+
+    std::string path_;
+    int fd_              = -1;
+    std::size_t bytes_   = 0;
+    CacheHeader* header_ = nullptr;
+    CacheEntry* entries_ = nullptr;
+};
+
+struct CachedRunStats {
+    uint64_t cached_battles    = 0;  // 直接取自缓存的场次
+    uint64_t simulated_battles = 0;  // 本次新模拟的场次
+    int reused_matchups        = 0;  // 完全不需要模拟的对局数
+};
+
+// 先取缓存中已有的结果，只模拟不足 times 的部分并追加进缓存。各对局每次至多推进 kCacheCheckpointTrials 场后写入一次，
+// 进程中途被杀掉时至多损失一批；缓存的场次多于 times 时直接使用全部缓存的结果。
+// 缓存为空时结果与 RunMatchups 完全相同。写入缓存失败时在 stderr 说明，本次运行不再写入缓存，结果照常返回
+std::vector<MatchupResult>
+RunMatchupsCached(const std::vector<MatchupTask>& tasks, uint64_t seed, Engine engine, ResultCache& cache, CachedRunStats& stats);
@@ -0,0 +1,406 @@
+#include "server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+#include "character_table.h"
+
+#if !defined(_WIN32)
+constexpr int kNumMatchups = kNumOfCharacter * kNumOfCharacter;
+
+// 一批至少推进的场次
+constexpr uint64_t kServerMinBlock = 1 << 16;
+
+// 一批至多推进的场次：交互查询最多等待一批就能插队，进度也按批推送
+constexpr uint64_t kServerMaxBlock = 1 << 21;
+
+// 一行命令的最大字节数，超过时回复错误并断开连接，客户端不发换行也不会让缓冲区无限增长
+constexpr std::size_t kServerMaxLine = 4096;
+
+// 信号处理函数与各连接线程都会写入，必须是无锁的原子变量
+static std::atomic<int> g_server_stop{0};
+static_assert(std::atomic<int>::is_always_lock_free, "g_server_stop is written from a signal handler");
+
+static void
+OnStopSignal(int) {
+    g_server_stop = 1;
+}
+
+struct ServerJob {
+    int matchup;
+    double width;
+};
+
+class QueryServer {
+public:
+    explicit QueryServer(const ServerOptions& options) : options_(options), rule_(options.rule), cache_(options.cache) {
+        if (!rule_.Enabled()) rule_.width = kServerDefaultWidth;
+    }
+
+    int Run();
+
+private:
+    // 后台调度线程：每次取一个任务推进一批，交互队列总是优先
+    void Schedule();
+
+    // 一个客户端连接，在各自的线程上逐行处理命令
+    void Serve(int fd);
+
+    bool Send(int fd, const std::string& line);
+
+    // 以下函数都须持有 mutex_
+
+    [[nodiscard]] bool Done(const MatchupResult& result, double width) const;
+
+    [[nodiscard]] std::string FormatResult(int matchup, double width) const;
+
+    // 同一对局在同一队列中只保留一项，宽度取较小者
+    void Enqueue(std::deque<ServerJob>& queue, int matchup, double width);
+
+    [[nodiscard]] static MatchupTask Task(const int matchup) { return {static_cast<Character>(matchup / kNumOfCharacter), static_cast<Character>(matchup % kNumOfCharacter), 0}; }
+
+    const ServerOptions& options_;
+    StoppingRule rule_;
+    ResultCache* cache_;  // 写入失败后置空，不再写入
+
+    std::mutex mutex_;
+    std::condition_variable work_;     // 有新任务或停止
+    std::condition_variable updated_;  // 某个对局推进了一批、连接数变化或停止
+    bool stop_ = false;
+
+    MatchupResult results_[kNumMatchups];
+    uint64_t versions_[kNumMatchups] = {};  // 各对局推进的批数
+    std::deque<ServerJob> interactive_;
+    std::deque<ServerJob> bulk_;
+    uint64_t simulated_ = 0;  // 本次启动以来新模拟的场次
+    std::vector<int> clients_;
+};
+
+bool
+QueryServer::Done(const MatchupResult& result, const double width) const {
+    if (result.Battles() >= options_.max_battles) return true;
+    if (result.Battles() == 0) return false;
+
+    StoppingRule rule         = rule_;
+    rule.width                = width;
+    const auto [lower, upper] = ConfidenceInterval(result.p0_win, result.Battles(), rule);
+    return upper - lower <= width;
+}
+
+std::string
+QueryServer::FormatResult(const int matchup, const double width) const {
+    const MatchupTask task      = Task(matchup);
+    const MatchupResult& result = results_[matchup];
+    const uint64_t battles      = result.Battles();
+
+    const auto [lower, upper] = battles > 0 ? ConfidenceInterval(result.p0_win, battles, rule_) : std::pair<double, double>{0., 1.};
+    const double rate         = battles > 0 ? static_cast<double>(result.p0_win) / static_cast<double>(battles) : 0.;
+
+    char line[256];
+    snprintf(line, sizeof(line), "result %s %s %llu %llu %llu %llu %.6f %.6f %.6f %s\n", CharacterKey(task.c0), CharacterKey(task.c1), static_cast<unsigned long long>(battles), static_cast<unsigned long long>(result.p0_win), static_cast<unsigned long long>(result.p1_win), static_cast<unsigned long long>(result.draw), rate, lower, upper, Done(result, width) ? "done" : "partial");
+    return line;
+}
+
+void
+QueryServer::Enqueue(std::deque<ServerJob>& queue, const int matchup, const double width) {
+    for (auto& job : queue) {
+        if (job.matchup == matchup) {
+            job.width = std::min(job.width, width);
+            return;
+        }
+    }
+    queue.push_back({matchup, width});
+    work_.notify_one();
+}
+
+void
+QueryServer::Schedule() {
+    for (;;) {
+        ServerJob job;
+        bool interactive;
+        MatchupTask block;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_.wait(lock, [this] { return stop_ || !interactive_.empty() || !bulk_.empty(); });
+            if (stop_) return;
+
+            interactive                  = !interactive_.empty();
+            std::deque<ServerJob>& queue = interactive ? interactive_ : bulk_;
+            job                          = queue.front();
+            queue.pop_front();
+
+            const MatchupResult& result = results_[job.matchup];
+            if (Done(result, job.width)) continue;
+
+            // 按当前区间宽度估计达到目标所需的场次（宽度与场次的平方根成反比），每批至多扩大到 8 倍
+            const uint64_t done = result.Battles();
+            uint64_t target     = done + kServerMinBlock;
+            if (done > 0) {
+                const auto [lower, upper] = ConfidenceInterval(result.p0_win, done, rule_);
+                const double ratio        = (upper - lower) / job.width;
+                target                    = std::clamp(static_cast<uint64_t>(static_cast<double>(done) * ratio * ratio), done + kServerMinBlock, done * 8);
+            }
+            target = std::min({target, done + kServerMaxBlock, options_.max_battles});
+
+            block       = Task(job.matchup);
+            block.times = target - done;
+            block.begin = done;
+        }
+
+        const MatchupResult block_result = RunMatchups({block}, options_.seed, options_.engine)[0];
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_[job.matchup] += block_result;
+            ++versions_[job.matchup];
+            simulated_ += block_result.Battles();
+            if (cache_ != nullptr && !cache_->Append(block, options_.seed, block_result)) {
+                fprintf(stderr, "写入缓存失败，之后的结果不再写入缓存\n");
+                cache_ = nullptr;
+            }
+
+            // 排到同一队列的末尾，同优先级的对局轮流推进
+            if (!Done(results_[job.matchup], job.width)) (interactive ? interactive_ : bulk_).push_back(job);
+        }
+        updated_.notify_all();
+    }
+}
+
+bool
+QueryServer::Send(const int fd, const std::string& line) {
+    std::size_t sent = 0;
+    while (sent < line.size()) {
+        const ssize_t n = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// 解析可选的宽度参数，缺省时为 fallback
+static bool
+ParseWidth(const std::vector<std::string>& words, const std::size_t index, const double fallback, double& width) {
+    width = fallback;
+    if (words.size() <= index) return true;
+    char* end = nullptr;
+    width     = std::strtod(words[index].c_str(), &end);
+    return *end == '\0' && width > 0. && width < 1.;
+}
+
+void
+QueryServer::Serve(const int fd) {
+    std::string buffer;
+    char chunk[4096];
+    bool open = true;
+
+    while (open) {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+
+        for (std::size_t newline = buffer.find('\n'); open && newline != std::string::npos; newline = buffer.find('\n')) {
+            if (newline > kServerMaxLine) break;
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            std::vector<std::string> words;
+            for (std::size_t pos = 0; pos < line.size();) {
+                const std::size_t begin = line.find_first_not_of(' ', pos);
+                if (begin == std::string::npos) break;
+                const std::size_t end = std::min(line.find(' ', begin), line.size());
+                words.push_back(line.substr(begin, end - begin));
+                pos = end;
+            }
+            if (words.empty()) continue;
+
+            const std::string& command = words[0];
+            double width               = rule_.width;
+
+            if (command == "get") {
+                Character c0, c1;
+                if (words.size() < 3 || !ParseCharacterArg(words[1], c0) || !ParseCharacterArg(words[2], c1) || !ParseWidth(words, 3, rule_.width, width)) {
+                    open = Send(fd, "error 用法: get <角色> <角色> [宽度]\n");
+                    continue;
+                }
+                const int matchup = static_cast<int>(c0) * kNumOfCharacter + static_cast<int>(c1);
+
+                // 先返回当前结果，不足时插队并在每批结束后推送进度
+                std::unique_lock<std::mutex> lock(mutex_);
+                std::string reply = FormatResult(matchup, width);
+                bool done         = Done(results_[matchup], width);
+                if (!done) Enqueue(interactive_, matchup, width);
+
+                while (true) {
+                    const uint64_t version = versions_[matchup];
+                    lock.unlock();
+                    open = Send(fd, reply);
+                    lock.lock();
+                    if (!open || done) break;
+
+                    updated_.wait(lock, [&] { return stop_ || versions_[matchup] != version; });
+                    if (stop_) break;
+                    reply = FormatResult(matchup, width);
+                    done  = Done(results_[matchup], width);
+                }
+            } else if (command == "matrix" || command == "refine") {
+                if (!ParseWidth(words, 1, rule_.width, width)) {
+                    open = Send(fd, "error 宽度必须在 0 和 1 之间\n");
+                    continue;
+                }
+
+                std::string reply;
+                int queued = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (int matchup = 0; matchup < kNumMatchups; ++matchup) {
+                        if (command == "matrix") reply += FormatResult(matchup, width);
+                        if (Done(results_[matchup], width)) continue;
+                        Enqueue(bulk_, matchup, width);
+                        ++queued;
+                    }
+                }
+                reply += command == "matrix" ? "end\n" : "queued " + std::to_string(queued) + "\n";
+                open = Send(fd, reply);
+            } else if (command == "status") {
+                char reply[128];
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    snprintf(reply, sizeof(reply), "status interactive %zu bulk %zu simulated %llu clients %zu\n", interactive_.size(), bulk_.size(), static_cast<unsigned long long>(simulated_), clients_.size());
+                }
+                open = Send(fd, reply);
+            } else if (command == "shutdown") {
+                Send(fd, "bye\n");
+                g_server_stop = 1;
+                open          = false;
+            } else if (command == "quit") {
+                open = false;
+            } else {
+                open = Send(fd, "error 未知的命令: " + command + "\n");
+            }
+        }
+
+        // 未处理的部分（无论是否已收到换行）超过上限时不再等待后续数据
+        if (open && std::min(buffer.find('\n'), buffer.size()) > kServerMaxLine) {
+            Send(fd, "error 命令过长，每行至多 " + std::to_string(kServerMaxLine) + " 字节\n");
+            open = false;
+        }
+    }
+
+    // 先在锁内移出 clients_ 再关闭：关闭后 fd 号可能被新连接复用，Run 不能再对它调用 shutdown
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.erase(std::find(clients_.begin(), clients_.end(), fd));
+    }
+    close(fd);
+    updated_.notify_all();
+}
+
+int
+QueryServer::Run() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(options_.socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "套接字路径过长: %s\n", options_.socket_path);
+        return 1;
+    }
+    std::strcpy(address.sun_path, options_.socket_path);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        fprintf(stderr, "无法创建套接字: %s\n", std::strerror(errno));
+        return 1;
+    }
+
+    // 路径上残留的套接字文件在没有服务监听时才删除
+    if (connect(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+        fprintf(stderr, "已有查询服务在监听: %s\n", options_.socket_path);
+        close(listener);
+        return 1;
+    }
+    unlink(options_.socket_path);
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "无法监听 %s: %s\n", options_.socket_path, std::strerror(errno));
+        close(listener);
+        return 1;
+    }
+
+    for (int matchup = 0; matchup < kNumMatchups; ++matchup) {
+        if (cache_ != nullptr) results_[matchup] = cache_->Lookup(Task(matchup), options_.seed);
+    }
+
+    g_server_stop = 0;
+    std::signal(SIGINT, OnStopSignal);
+    std::signal(SIGTERM, OnStopSignal);
+
+    printf("查询服务: %s  默认目标宽度 %g  每个对局至多 %llu 场\n", options_.socket_path, rule_.width, static_cast<unsigned long long>(options_.max_battles));
+    fflush(stdout);
+
+    std::thread scheduler(&QueryServer::Schedule, this);
+
+    // 定时醒来检查停止标志，信号处理函数里只能设置标志
+    while (g_server_stop == 0) {
+        pollfd poll_fd{listener, POLLIN, 0};
+        if (poll(&poll_fd, 1, 200) <= 0) continue;
+
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            clients_.push_back(client);
+        }
+        std::thread(&QueryServer::Serve, this, client).detach();
+    }
+
+    // 关闭仍在等待的连接，等各连接线程退出后再停止调度线程
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+        for (const int client : clients_) shutdown(client, SHUT_RDWR);
+        work_.notify_all();
+        updated_.notify_all();
+        updated_.wait(lock, [this] { return clients_.empty(); });
+    }
+    scheduler.join();
+
+    close(listener);
+    unlink(options_.socket_path);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    printf("查询服务已停止，本次新模拟 %llu 场\n", static_cast<unsigned long long>(simulated_));
+    return 0;
+}
+
+int
+RunServer(const ServerOptions& options) {
+    QueryServer server(options);
+    return server.Run();
+}
+#else
+int
+RunServer(const ServerOptions& options) {
+    fprintf(stderr, "查询服务需要 Unix 域套接字: %s\n", options.socket_path);
+    return 1;
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#include "adaptive.h"
+#include "engine.h"
+#include "result_cache.h"
+
+// 未指定 --ci-width 时查询的默认目标区间宽度
+constexpr double kServerDefaultWidth = 0.005;
+
+struct ServerOptions {
+    const char* socket_path = nullptr;
+    uint64_t seed           = 0;
+    Engine engine           = Engine::BATCH;
+    StoppingRule rule;                  // 默认的目标精度，width 为 0 时取 kServerDefaultWidth
+    uint64_t max_battles = 0;           // 每个对局的场次上限
+    ResultCache* cache   = nullptr;     // 非空时启动时载入已缓存的结果，新模拟的批次追加进缓存
+};
+
+// 在 Unix 域套接字上常驻，提供胜率查询，直到收到 shutdown 命令或 SIGINT / SIGTERM。每行一条命令：
+//   get <角色> <角色> [宽度]  立即返回当前结果；未达到目标宽度时插队模拟，每批结束后推送一行进度，达到后以 done 结束
+//   matrix [宽度]            立即返回全部 144 个对局的当前结果并以 end 结束，不足的对局排入后台补算
+//   refine [宽度]            把不足的对局全部排入后台补算
+//   status                   队列长度与已模拟的场次
+//   shutdown / quit          停止服务 / 断开连接
+// 结果行为 result <c0> <c1> <场次> <p0 胜> <p1 胜> <平局> <p0 胜率> <下限> <上限> partial|done，
+// 对局结果与同一种子下 --times 为当前场次的普通模拟完全相同
+int
+RunServer(const ServerOptions& options);
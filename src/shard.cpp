@@ -0,0 +1,255 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+#include "random.h"
+#include "result_cache.h"
+#include "thread_pool.h"
+
+// 失败的分片在本机协调进程中至多重跑的次数
+constexpr int kShardRetries = 2;
+
+constexpr char kShardMagic[8]    = {'H', 'K', 'S', 'H', 'A', 'R', 'D', '\0'};
+constexpr uint32_t kShardVersion = 1;
+
+struct ShardHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t seed;
+    int32_t index;
+    int32_t count;
+    uint32_t num_tasks;
+    uint32_t full_matrix;
+    double seconds;
+};
+
+// 每个对局一条；definition 为双方角色定义、回合上限和 kSimulationRevision 的散列，合并时据此拒绝数值或代码不一致的分片
+struct ShardRecord {
+    uint8_t c0;
+    uint8_t c1;
+    uint8_t reserved[6];
+    uint64_t times;
+    uint64_t definition;
+    uint64_t begin;
+    CachedCounts counts;
+};
+
+static_assert(sizeof(ShardRecord) == 72, "shard records are stored on disk as is");
+
+static uint64_t
+Definition(const MatchupTask& task) {
+    const CharacterTable& table = task.Table();
+    return Mix64(Mix64(CharacterDefinitionHash(task.c0, table) ^ kSimulationRevision) ^ Mix64(CharacterDefinitionHash(task.c1, table) ^ static_cast<uint64_t>(MaxRounds())));
+}
+
+std::vector<MatchupTask>
+ShardTasks(const std::vector<MatchupTask>& tasks, const int index, const int count) {
+    std::vector<MatchupTask> shard;
+    for (const MatchupTask& task : tasks) {
+        const auto shard_begin = [&task, count](const int i) { return task.begin + task.times / count * i + std::min<uint64_t>(i, task.times % count); };
+        shard.push_back({task.c0, task.c1, shard_begin(index + 1) - shard_begin(index), shard_begin(index), task.table});
+    }
+    return shard;
+}
+
+std::string
+ShardPath(const std::string& dir, const int index, const int count) {
+    return dir + "/honkai-shard-" + std::to_string(index) + "-of-" + std::to_string(count) + ".bin";
+}
+
+// 先写到临时文件再改名，被中断的分片不会留下看似完整的文件
+bool
+WriteShardFile(const char* path, const ShardRun& run, const int index, const std::vector<MatchupResult>& results, const double seconds) {
+    const std::vector<MatchupTask> shard = ShardTasks(run.tasks, index, run.count);
+
+    ShardHeader header{};
+    memcpy(header.magic, kShardMagic, sizeof(header.magic));
+    header.version     = kShardVersion;
+    header.record_size = sizeof(ShardRecord);
+    header.seed        = run.seed;
+    header.index       = index;
+    header.count       = run.count;
+    header.num_tasks   = static_cast<uint32_t>(run.tasks.size());
+    header.full_matrix = run.full_matrix ? 1 : 0;
+    header.seconds     = seconds;
+
+    const std::string temp_path = std::string(path) + ".tmp";
+    FILE* out                   = fopen(temp_path.c_str(), "wb");
+    if (out == nullptr) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (std::size_t t = 0; t < shard.size() && ok; ++t) {
+        const MatchupResult& result = results[t];
+
+        ShardRecord record{};
+        record.c0         = static_cast<uint8_t>(shard[t].c0);
+        record.c1         = static_cast<uint8_t>(shard[t].c1);
+        record.times      = run.tasks[t].times;
+        record.definition = Definition(shard[t]);
+        record.begin      = shard[t].begin;
+        record.counts     = {result.p0_win, result.p1_win, result.draw, result.attacker_dead, result.rounds};
+        ok                = fwrite(&record, sizeof(record), 1, out) == 1;
+    }
+    ok = fclose(out) == 0 && ok;
+    return ok && rename(temp_path.c_str(), path) == 0;
+}
+
+// 读入一个分片文件，只检查文件本身的格式
+static bool
+ReadShardFile(const char* path, ShardHeader& header, std::vector<ShardRecord>& records) {
+    FILE* in = fopen(path, "rb");
+    if (in == nullptr) return false;
+
+    bool ok = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, kShardMagic, sizeof(kShardMagic)) == 0 && header.version == kShardVersion && header.record_size == sizeof(ShardRecord) && header.count > 0 && header.index >= 0 && header.index < header.count;
+    if (ok) {
+        records.resize(header.num_tasks);
+        ok = fread(records.data(), sizeof(ShardRecord), records.size(), in) == records.size() && fgetc(in) == EOF;
+    }
+    fclose(in);
+    return ok;
+}
+
+bool
+MergeShardFiles(const std::vector<std::string>& paths, ShardRun& run, std::vector<MatchupResult>& results, double& seconds) {
+    if (paths.empty()) return false;
+
+    seconds = 0.;
+    std::vector<bool> seen;
+    std::vector<ShardRecord> first;
+    for (std::size_t f = 0; f < paths.size(); ++f) {
+        const char* path = paths[f].c_str();
+
+        ShardHeader header;
+        std::vector<ShardRecord> records;
+        if (!ReadShardFile(path, header, records)) {
+            fprintf(stderr, "不是有效的分片文件: %s\n", path);
+            return false;
+        }
+
+        // 以第一个文件确定这次运行的设置与对局列表
+        if (f == 0) {
+            run.seed        = header.seed;
+            run.count       = header.count;
+            run.full_matrix = header.full_matrix != 0;
+            run.tasks.clear();
+            for (const ShardRecord& record : records) run.tasks.push_back({static_cast<Character>(record.c0), static_cast<Character>(record.c1), record.times});
+            seen.assign(static_cast<std::size_t>(run.count), false);
+            results.assign(run.tasks.size(), MatchupResult{});
+            first = records;
+        }
+
+        if (header.seed != run.seed || header.count != run.count || (header.full_matrix != 0) != run.full_matrix || records.size() != run.tasks.size()) {
+            fprintf(stderr, "分片不属于同一次运行: %s\n", path);
+            return false;
+        }
+        if (seen[static_cast<std::size_t>(header.index)]) {
+            fprintf(stderr, "分片 %d 重复: %s\n", header.index, path);
+            return false;
+        }
+        seen[static_cast<std::size_t>(header.index)] = true;
+        seconds                                      = std::max(seconds, header.seconds);
+
+        const std::vector<MatchupTask> shard = ShardTasks(run.tasks, header.index, run.count);
+        for (std::size_t t = 0; t < records.size(); ++t) {
+            const ShardRecord& record  = records[t];
+            const CachedCounts& counts = record.counts;
+            if (record.c0 != first[t].c0 || record.c1 != first[t].c1 || record.times != first[t].times || record.begin != shard[t].begin || counts.p0_win + counts.p1_win + counts.draw != shard[t].times) {
+                fprintf(stderr, "分片的对局或试验区间不一致: %s\n", path);
+                return false;
+            }
+            if (record.definition != Definition(shard[t])) {
+                fprintf(stderr, "分片的角色定义与当前数值表不一致: %s\n", path);
+                return false;
+            }
+
+            MatchupResult& result = results[t];
+            result.p0_win += counts.p0_win;
+            result.p1_win += counts.p1_win;
+            result.draw += counts.draw;
+            result.attacker_dead += counts.attacker_dead;
+            result.rounds += counts.rounds;
+        }
+    }
+
+    for (int index = 0; index < run.count; ++index) {
+        if (seen[static_cast<std::size_t>(index)]) continue;
+        fprintf(stderr, "缺少分片 %d/%d\n", index, run.count);
+        return false;
+    }
+    return true;
+}
+
+#if !defined(_WIN32)
+// 已有的分片文件属于这次运行时无需重跑
+static bool
+IsCompleteShard(const std::string& path, const ShardRun& run, const int index) {
+    ShardHeader header;
+    std::vector<ShardRecord> records;
+    if (!ReadShardFile(path.c_str(), header, records)) return false;
+    if (header.seed != run.seed || header.count != run.count || header.index != index || (header.full_matrix != 0) != run.full_matrix || records.size() != run.tasks.size()) return false;
+
+    const std::vector<MatchupTask> shard = ShardTasks(run.tasks, index, run.count);
+    for (std::size_t t = 0; t < records.size(); ++t) {
+        if (records[t].c0 != static_cast<uint8_t>(shard[t].c0) || records[t].c1 != static_cast<uint8_t>(shard[t].c1) || records[t].times != run.tasks[t].times || records[t].begin != shard[t].begin || records[t].definition != Definition(shard[t])) return false;
+    }
+    return true;
+}
+
+// 子进程不做任何输出，以 _exit 退出，避免重复刷出父进程缓冲区中的内容；调用时线程池还不能启动过工作线程
+bool
+RunShardsLocally(const ShardRun& run, const Engine engine, const std::string& dir, const int threads, std::vector<MatchupResult>& results) {
+    std::vector<std::string> paths;
+    for (int index = 0; index < run.count; ++index) paths.push_back(ShardPath(dir, index, run.count));
+
+    for (int attempt = 0; attempt <= kShardRetries; ++attempt) {
+        std::vector<int> pending;
+        for (int index = 0; index < run.count; ++index) {
+            if (!IsCompleteShard(paths[static_cast<std::size_t>(index)], run, index)) pending.push_back(index);
+        }
+        if (pending.empty()) break;
+        if (attempt > 0) fprintf(stderr, "重跑 %zu 个失败的分片\n", pending.size());
+
+        fflush(stdout);
+        fflush(stderr);
+        std::vector<pid_t> children;
+        for (const int index : pending) {
+            const pid_t pid = fork();
+            if (pid == 0) {
+                ThreadPool::Instance().SetNumThreads(threads);
+                const auto begin                               = std::chrono::steady_clock::now();
+                const std::vector<MatchupResult> shard_results = RunMatchups(ShardTasks(run.tasks, index, run.count), run.seed, engine);
+                const double seconds                           = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                _exit(WriteShardFile(paths[static_cast<std::size_t>(index)].c_str(), run, index, shard_results, seconds) ? 0 : 1);
+            }
+            if (pid < 0) fprintf(stderr, "无法创建分片 %d 的进程\n", index);
+            children.push_back(pid);
+        }
+
+        for (std::size_t c = 0; c < children.size(); ++c) {
+            int status = 0;
+            if (children[c] > 0 && waitpid(children[c], &status, 0) == children[c] && WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+            fprintf(stderr, "分片 %d/%d 失败\n", pending[c], run.count);
+        }
+    }
+
+    ShardRun merged;
+    double seconds = 0.;
+    return MergeShardFiles(paths, merged, results, seconds);
+}
+#else
+// 本机协调依赖 fork；仍可用 --shard 分别运行各分片后再 --merge
+bool
+RunShardsLocally(const ShardRun&, Engine, const std::string&, int, std::vector<MatchupResult>&) {
+    fprintf(stderr, "此平台不支持 --processes\n");
+    return false;
+}
+#endif
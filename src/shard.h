@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+
+// 分片 index / count 负责每个对局的一段连续试验，各段依次相接且长度至多相差 1；
+// 合并所有分片的计数与单进程跑完 [0, times) 的结果完全相同
+std::vector<MatchupTask>
+ShardTasks(const std::vector<MatchupTask>& tasks, int index, int count);
+
+// 一次分片运行的全部设置，合并时据此检查各分片属于同一次运行
+struct ShardRun {
+    uint64_t seed    = 0;
+    int count        = 1;
+    bool full_matrix = false;
+    std::vector<MatchupTask> tasks;  // 完整的对局列表，每个对局的 times 为全部分片的总场次
+};
+
+// 写出分片 index 的部分结果，results 与 ShardTasks(run.tasks, index, run.count) 一一对应，seconds 为该分片的用时
+bool
+WriteShardFile(const char* path, const ShardRun& run, int index, const std::vector<MatchupResult>& results, double seconds);
+
+// 读入一组分片文件并逐项相加；文件必须恰好覆盖同一次运行的全部分片，且角色定义与当前进程一致，否则在 stderr 说明原因并返回 false。
+// 成功时 run 中的 tasks 使用当前进程的默认数值表，seconds 为各分片用时的最大值
+bool
+MergeShardFiles(const std::vector<std::string>& paths, ShardRun& run, std::vector<MatchupResult>& results, double& seconds);
+
+// 在本机 fork 出 run.count 个进程各跑一个分片，每个进程 threads 个线程，部分结果写到 dir 下。
+// 已存在且有效的分片文件直接复用，失败的分片至多重跑 kShardRetries 次；全部成功后合并为 results
+bool
+RunShardsLocally(const ShardRun& run, Engine engine, const std::string& dir, int threads, std::vector<MatchupResult>& results);
+
+// 分片 index 在 dir 下的文件名
+std::string
+ShardPath(const std::string& dir, int index, int count);
@@ -0,0 +1,29 @@
+#include "stats.h"
+
+BattleStats&
+BattleStats::operator+=(const BattleStats& other) {
+    for (int c = 0; c < kNumOfCharacter; ++c) {
+        for (int e = 0; e < kNumOfStatEvent; ++e) events[c][e] += other.events[c][e];
+    }
+    for (int r = 0; r < kRoundHistogramSize; ++r) rounds[r] += other.rounds[r];
+    for (int side = 0; side < 2; ++side) {
+        for (int h = 0; h < kHitHistogramSize; ++h) winner_hit[side][h] += other.winner_hit[side][h];
+    }
+    return *this;
+}
+
+int
+HistogramQuantile(const uint64_t* histogram, const int size, const double q) {
+    uint64_t total = 0;
+    for (int i = 0; i < size; ++i) total += histogram[i];
+    if (total == 0) return 0;
+
+    // 第一个累计频数达到 q * total 的桶
+    const auto target = static_cast<double>(total) * q;
+    uint64_t count    = 0;
+    for (int i = 0; i < size; ++i) {
+        count += histogram[i];
+        if (static_cast<double>(count) >= target && count > 0) return i;
+    }
+    return size - 1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "character.h"
+#include "config.h"
+
+// 战斗事件，按发起事件的角色计数
+enum class StatEvent : int {
+    ULT,        // 释放必杀技
+    ATTACK,     // 普攻
+    MISS,       // 攻击未命中，每段伤害单独判定
+    STUN,       // 琪亚娜【音浪~太强~】自身眩晕
+    PARALYZE,   // 芽衣【崩坏世界的歌姬】麻痹对方
+    CHARM,      // 丽塔【完美心意】魅惑对方
+    RESURRECT,  // 萝莎莉娅&莉莉娅【96度生命之水】复活
+    REFLECT,    // 幽兰黛尔反弹必杀技
+    NUM_OF_STAT_EVENT
+};
+
+constexpr int kNumOfStatEvent = static_cast<int>(StatEvent::NUM_OF_STAT_EVENT);
+
+// 结束回合的直方图按回合数逐个分桶，最后一个桶收纳所有更长的战斗（包括到达回合上限的平局）
+constexpr int kRoundHistogramSize = 128;
+
+// 胜方剩余血量 0 ~ 100
+constexpr int kHitHistogramSize = 101;
+
+struct BattleStats {
+    uint64_t events[kNumOfCharacter][kNumOfStatEvent] = {};
+    uint64_t rounds[kRoundHistogramSize]              = {};
+    uint64_t winner_hit[2][kHitHistogramSize]         = {};  // 按 p0 / p1 胜出分别统计
+
+    // 记录一场战斗的结束回合与胜方（0 / 1，平局为 -1）的剩余血量
+    void RecordBattle(const int battle_rounds, const int winner, const int hit) {
+        ++rounds[std::min(battle_rounds, kRoundHistogramSize - 1)];
+        if (winner >= 0) ++winner_hit[winner][std::clamp(hit, 0, kHitHistogramSize - 1)];
+    }
+
+    BattleStats& operator+=(const BattleStats& other);
+};
+
+// 直方图的 q 分位数所在的桶
+int
+HistogramQuantile(const uint64_t* histogram, int size, double q);
+
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+// 每个线程各自累加，调度器在每个工作项前清零、结束后合并进该对局的结果，热路径上没有同步
+inline thread_local BattleStats g_battle_stats;
+
+#    define STAT_ADD(character, event, count) (g_battle_stats.events[static_cast<int>(character)][static_cast<int>(StatEvent::event)] += static_cast<uint64_t>(count))
+#else
+#    define STAT_ADD(character, event, count) ((void)0)
+#endif
+
+#define STAT(character, event) STAT_ADD(character, event, 1)
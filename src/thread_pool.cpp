@@ -0,0 +1,94 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
+ThreadPool&
+ThreadPool::Instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() {
+#ifdef _OPENMP
+    num_threads_ = omp_get_max_threads();
+    backend_     = Backend::OPENMP;
+#else
+    num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+    StopWorkers();
+}
+
+void
+ThreadPool::Run(const std::function<void(int)>& fn) {
+#ifdef _OPENMP
+    if (backend_ == Backend::OPENMP) {
+        #pragma omp parallel num_threads(num_threads_)
+        fn(omp_get_thread_num());
+        return;
+    }
+#endif
+    if (static_cast<int>(workers_.size()) != num_threads_ - 1) {
+        StopWorkers();
+        StartWorkers(num_threads_ - 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_    = &fn;
+        pending_ = static_cast<int>(workers_.size());
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+}
+
+void
+ThreadPool::StartWorkers(const int num_workers) {
+    stop_ = false;
+    // 新线程只响应此后发布的任务，起始代数必须在创建时确定，不能等线程启动后再读取
+    for (int worker = 1; worker <= num_workers; ++worker) {
+        workers_.emplace_back([this, worker, generation = generation_] { WorkerMain(worker, generation); });
+    }
+}
+
+void
+ThreadPool::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+    workers_.clear();
+}
+
+void
+ThreadPool::WorkerMain(const int worker, uint64_t seen_generation) {
+    for (;;) {
+        const std::function<void(int)>* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) return;
+            seen_generation = generation_;
+            task            = task_;
+        }
+
+        (*task)(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) done_cv_.notify_one();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class Backend {
+    THREAD,  // 常驻 std::thread 线程池
+    OPENMP,  // OpenMP 线程组，仅在以 -fopenmp 编译时可用
+};
+
+// 常驻工作线程池：Run 让 NumThreads() 个 worker 各执行一次 fn(worker)，调用线程本身作为 0 号 worker
+class ThreadPool {
+public:
+    static ThreadPool& Instance();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    [[nodiscard]] int NumThreads() const { return num_threads_; }
+
+    void SetNumThreads(const int num_threads) { num_threads_ = num_threads < 1 ? 1 : num_threads; }
+
+    [[nodiscard]] Backend GetBackend() const { return backend_; }
+
+    void SetBackend(const Backend backend) { backend_ = backend; }
+
+    void Run(const std::function<void(int)>& fn);
+
+private:
+    ThreadPool();
+
+    void StartWorkers(int num_workers);
+
+    void StopWorkers();
+
+    void WorkerMain(int worker, uint64_t seen_generation);
+
+    int num_threads_ = 1;
+    Backend backend_ = Backend::THREAD;
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* task_ = nullptr;
+    uint64_t generation_                  = 0;
+    int pending_                          = 0;
+    bool stop_                            = false;
+};
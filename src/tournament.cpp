@@ -0,0 +1,388 @@
+#include "tournament.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+void
+PairwiseRecord::Add(const Character c0, const Character c1, const MatchupResult& result) {
+    const int i       = static_cast<int>(c0);
+    const int j       = static_cast<int>(c1);
+    const double draw = static_cast<double>(result.draw) / 2.;
+    wins[i][j] += static_cast<double>(result.p0_win) + draw;
+    wins[j][i] += static_cast<double>(result.p1_win) + draw;
+}
+
+Ratings
+BradleyTerryRatings(const PairwiseRecord& record) {
+    constexpr int kMaxIterations = 10000;
+    constexpr double kTolerance  = 1e-10;
+
+    // 强度 s_i 的 MM 更新：s_i = W_i / sum_j N_ij / (s_i + s_j)，虚拟对手的强度固定为 1
+    std::array<double, kNumOfCharacter> strength;
+    strength.fill(1.);
+    for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+        std::array<double, kNumOfCharacter> next;
+        for (int i = 0; i < kNumOfCharacter; ++i) {
+            double wins        = 0.5;
+            double denominator = 1. / (strength[i] + 1.);
+            for (int j = 0; j < kNumOfCharacter; ++j) {
+                if (j == i || record.Games(i, j) == 0.) continue;
+                wins += record.wins[i][j];
+                denominator += record.Games(i, j) / (strength[i] + strength[j]);
+            }
+            next[i] = wins / denominator;
+        }
+
+        double change = 0.;
+        for (int i = 0; i < kNumOfCharacter; ++i) change = std::max(change, std::abs(std::log(next[i] / strength[i])));
+        strength = next;
+        if (change < kTolerance) break;
+    }
+
+    // 以几何平均为 1500 分
+    double mean_log = 0.;
+    for (const double s : strength) mean_log += std::log10(s) / kNumOfCharacter;
+
+    Ratings ratings;
+    for (int i = 0; i < kNumOfCharacter; ++i) ratings[i] = 1500. + 400. * (std::log10(strength[i]) - mean_log);
+    return ratings;
+}
+
+Ratings
+EloRatings(const std::vector<MatchRecord>& matches, const double k) {
+    Ratings ratings;
+    ratings.fill(1500.);
+    for (const MatchRecord& match : matches) {
+        double& a             = ratings[static_cast<int>(match.a)];
+        double& b             = ratings[static_cast<int>(match.b)];
+        const double expected = 1. / (1. + std::pow(10., (b - a) / 400.));
+        a += k * (match.score - expected);
+        b -= k * (match.score - expected);
+    }
+    return ratings;
+}
+
+namespace {
+
+// 赛事进行中的累计状态
+struct Tournament {
+    const TournamentOptions& options;
+    uint64_t seed;
+    Engine engine;
+
+    TournamentResult result;
+    PairwiseRecord record;
+    double points[kNumOfCharacter]                        = {};
+    uint64_t next_trial[kNumOfCharacter][kNumOfCharacter] = {};
+    bool played[kNumOfCharacter][kNumOfCharacter]         = {};
+
+    // 一轮的全部比赛交给同一个调度器，返回每场比赛 a 的得分；award_points 时按得分给双方计比赛积分
+    std::vector<double> PlayRound(const int round, const std::vector<std::pair<Character, Character>>& pairings, const bool award_points = true) {
+        std::vector<MatchupTask> tasks;
+        for (const auto& [a, b] : pairings) {
+            const int i = static_cast<int>(a);
+            const int j = static_cast<int>(b);
+            tasks.push_back({a, b, options.battles, next_trial[i][j]});
+            next_trial[i][j] += options.battles;
+        }
+
+        const std::vector<MatchupResult> results = RunMatchups(tasks, seed, engine);
+
+        std::vector<double> scores;
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            const MatchupResult& matchup = results[t];
+            const Character a            = tasks[t].c0;
+            const Character b            = tasks[t].c1;
+            const double score           = matchup.p0_win > matchup.p1_win ? 1. : matchup.p0_win < matchup.p1_win ? 0. : 0.5;
+
+            result.matches.push_back({round, a, b, matchup.p0_win, matchup.p1_win, matchup.draw, score});
+            result.battles += matchup.Battles();
+            record.Add(a, b, matchup);
+            if (award_points) {
+                points[static_cast<int>(a)] += score;
+                points[static_cast<int>(b)] += 1. - score;
+            }
+            played[static_cast<int>(a)][static_cast<int>(b)] = true;
+            played[static_cast<int>(b)][static_cast<int>(a)] = true;
+            scores.push_back(score);
+        }
+        return scores;
+    }
+
+    [[nodiscard]] double BattleScore(const int i) const {
+        double wins  = 0.;
+        double games = 0.;
+        for (int j = 0; j < kNumOfCharacter; ++j) {
+            wins += record.wins[i][j];
+            games += record.Games(i, j);
+        }
+        return games > 0. ? wins / games : 0.;
+    }
+};
+
+void
+PlayRoundRobin(Tournament& tournament) {
+    std::vector<std::pair<Character, Character>> pairings;
+    for (const MatchupTask& task : MakeMatchupTasks(0, false)) pairings.emplace_back(task.c0, task.c1);
+    tournament.PlayRound(1, pairings);
+}
+
+// 按积分（相同时按战斗得分率）排序后，依次为最靠前的未配对者找排在其后、尚未交过手的第一人；找不到时与其后第一人重赛
+void
+PlaySwiss(Tournament& tournament) {
+    static_assert(kNumOfCharacter % 2 == 0, "瑞士轮不安排轮空");
+
+    for (int round = 1; round <= tournament.options.swiss_rounds; ++round) {
+        std::vector<int> order(kNumOfCharacter);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const int lhs, const int rhs) {
+            if (tournament.points[lhs] != tournament.points[rhs]) return tournament.points[lhs] > tournament.points[rhs];
+            return tournament.BattleScore(lhs) > tournament.BattleScore(rhs);
+        });
+
+        std::vector<std::pair<Character, Character>> pairings;
+        std::vector<bool> paired(kNumOfCharacter, false);
+        for (std::size_t p = 0; p < order.size(); ++p) {
+            const int i = order[p];
+            if (paired[i]) continue;
+
+            int opponent = -1;
+            for (std::size_t q = p + 1; q < order.size(); ++q) {
+                const int j = order[q];
+                if (paired[j]) continue;
+                if (opponent < 0) opponent = j;
+                if (!tournament.played[i][j]) {
+                    opponent = j;
+                    break;
+                }
+            }
+            paired[i]        = true;
+            paired[opponent] = true;
+            pairings.emplace_back(static_cast<Character>(i), static_cast<Character>(opponent));
+        }
+        tournament.PlayRound(round, pairings);
+    }
+}
+
+// 标准的种子排位：1 号与最后一号、2 号与倒数第二号分处两个半区，保证强者尽量晚相遇
+std::vector<int>
+BracketOrder(const int size) {
+    std::vector<int> order = {0};
+    while (static_cast<int>(order.size()) < size) {
+        const int next_size = static_cast<int>(order.size()) * 2;
+        std::vector<int> next;
+        for (const int seed : order) {
+            next.push_back(seed);
+            next.push_back(next_size - 1 - seed);
+        }
+        order.swap(next);
+    }
+    return order;
+}
+
+// 平局时种子靠前者晋级；points 为赢下的轮数，轮空计作赢下一轮
+void
+PlaySingleElimination(Tournament& tournament) {
+    std::vector<Character> seeding = tournament.options.seeding;
+    if (seeding.empty()) {
+        for (int c = 0; c < kNumOfCharacter; ++c) seeding.push_back(static_cast<Character>(c));
+    }
+
+    int size = 1;
+    while (size < static_cast<int>(seeding.size())) size *= 2;
+
+    // 每个位置上的种子序号，-1 为轮空
+    std::vector<int> slots;
+    for (const int seed : BracketOrder(size)) slots.push_back(seed < static_cast<int>(seeding.size()) ? seed : -1);
+
+    for (int round = 1; slots.size() > 1; ++round) {
+        std::vector<std::pair<Character, Character>> pairings;
+        std::vector<std::size_t> matched;
+        std::vector<int> next(slots.size() / 2, -1);
+        for (std::size_t s = 0; s < slots.size(); s += 2) {
+            const int upper = slots[s];
+            const int lower = slots[s + 1];
+            if (upper < 0 || lower < 0) {
+                next[s / 2] = std::max(upper, lower);
+                if (next[s / 2] >= 0) tournament.points[static_cast<int>(seeding[next[s / 2]])] += 1.;
+                continue;
+            }
+            pairings.emplace_back(seeding[upper], seeding[lower]);
+            matched.push_back(s);
+        }
+
+        const std::vector<double> scores = tournament.PlayRound(round, pairings, false);
+        for (std::size_t m = 0; m < matched.size(); ++m) {
+            const int upper       = slots[matched[m]];
+            const int lower       = slots[matched[m] + 1];
+            const bool upper_wins = scores[m] > 0.5 || (scores[m] == 0.5 && upper < lower);
+            const int winner      = upper_wins ? upper : lower;
+            tournament.points[static_cast<int>(seeding[winner])] += 1.;
+            next[matched[m] / 2] = winner;
+        }
+        slots.swap(next);
+    }
+}
+
+}  // namespace
+
+TournamentResult
+RunTournament(const TournamentOptions& options, const uint64_t seed, const Engine engine) {
+    Tournament tournament{options, seed, engine};
+
+    // clang-format off
+    switch (options.format) {
+    case TournamentFormat::ROUND_ROBIN:        PlayRoundRobin(tournament);        break;
+    case TournamentFormat::SWISS:              PlaySwiss(tournament);             break;
+    case TournamentFormat::SINGLE_ELIMINATION: PlaySingleElimination(tournament); break;
+    }
+    // clang-format on
+
+    const Ratings bradley_terry = BradleyTerryRatings(tournament.record);
+    const Ratings elo           = EloRatings(tournament.result.matches, options.elo_k);
+
+    std::vector<Standing>& standings = tournament.result.standings;
+    for (int c = 0; c < kNumOfCharacter; ++c) standings.push_back({static_cast<Character>(c), tournament.points[c], tournament.BattleScore(c), bradley_terry[c], elo[c]});
+    std::stable_sort(standings.begin(), standings.end(), [](const Standing& lhs, const Standing& rhs) {
+        if (lhs.points != rhs.points) return lhs.points > rhs.points;
+        return lhs.battle_score > rhs.battle_score;
+    });
+
+    return std::move(tournament.result);
+}
+
+namespace {
+
+// 对局的胜负：1 / -1 为 c0 / c1 更强，0 为平手，kUnsettled 为尚未确定
+constexpr int kUnsettled = 2;
+
+int
+PairOutcome(const MatchupResult& result, const RaceOptions& options, const StoppingRule& rule) {
+    const uint64_t battles = result.Battles();
+
+    // 平局计半场，区间按取整后的胜场计算
+    const uint64_t wins = result.p0_win + result.draw / 2;
+    if (battles > 0) {
+        const auto [lower, upper] = ConfidenceInterval(wins, battles, rule);
+        if (lower > 0.5) return 1;
+        if (upper < 0.5) return -1;
+        if (lower >= 0.5 - options.tie_margin && upper <= 0.5 + options.tie_margin) return 0;
+    }
+    if (battles < options.max_battles) return kUnsettled;
+
+    // 用完场次上限后按点估计判定，不再投入试验；上限为 0 时没有任何场次，记为平手
+    if (battles == 0) return 0;
+    const double score = static_cast<double>(wins) / static_cast<double>(battles);
+    if (std::abs(score - 0.5) <= options.tie_margin) return 0;
+    return score > 0.5 ? 1 : -1;
+}
+
+}  // namespace
+
+RaceResult
+RaceTopK(const RaceOptions& options, const uint64_t seed, const Engine engine) {
+    constexpr uint64_t kMinBlock = 1 << 12;
+
+    const std::vector<MatchupTask> pairs = MakeMatchupTasks(0, false);
+    const int top_k                      = std::clamp(options.top_k, 1, kNumOfCharacter);
+
+    // 每个对局至多查看 looks 次区间：首批 kMinBlock 场，之后逐批加倍，最后一次在 max_battles 场。
+    // 所有对局的所有查看合起来按 Bonferroni 校正，任何一个对局的胜负判错的概率合计不超过 1 - confidence
+    int looks = 1;
+    for (uint64_t battles = kMinBlock; battles < options.max_battles; battles *= 2) ++looks;
+    StoppingRule rule = options.rule;
+    rule.confidence   = 1. - (1. - options.rule.confidence) / (static_cast<double>(pairs.size()) * looks);
+
+    RaceResult race;
+    race.results.resize(pairs.size());
+    race.look_confidence = rule.confidence;
+
+    std::vector<int> outcomes(pairs.size());
+    for (std::size_t p = 0; p < pairs.size(); ++p) outcomes[p] = PairOutcome(race.results[p], options, rule);
+    int status[kNumOfCharacter] = {};
+    double lower[kNumOfCharacter];
+    double upper[kNumOfCharacter];
+
+    for (;;) {
+        // 由已确定的胜负得出每个角色 Copeland 得分的上下界
+        std::fill(std::begin(lower), std::end(lower), 0.);
+        std::fill(std::begin(upper), std::end(upper), 0.);
+        for (std::size_t p = 0; p < pairs.size(); ++p) {
+            const int i = static_cast<int>(pairs[p].c0);
+            const int j = static_cast<int>(pairs[p].c1);
+            if (outcomes[p] == kUnsettled) {
+                upper[i] += 1.;
+                upper[j] += 1.;
+                continue;
+            }
+            const double score = outcomes[p] == 1 ? 1. : outcomes[p] == 0 ? 0.5 : 0.;
+            lower[i] += score;
+            upper[i] += score;
+            lower[j] += 1. - score;
+            upper[j] += 1. - score;
+        }
+
+        // 至多 top_k - 1 个对手可能追平或超过时确定在前 top_k 名，至少 top_k 个对手必然超过时确定不在
+        for (int i = 0; i < kNumOfCharacter; ++i) {
+            int may_reach = 0;
+            int surpass   = 0;
+            for (int j = 0; j < kNumOfCharacter; ++j) {
+                if (j == i) continue;
+                may_reach += upper[j] >= lower[i] ? 1 : 0;
+                surpass += lower[j] > upper[i] ? 1 : 0;
+            }
+            status[i] = may_reach < top_k ? 1 : surpass >= top_k ? -1 : 0;
+        }
+
+        // 完整排名时所有未确定的对局都要继续；否则双方归属都已确定的对局无论胜负都不影响前 top_k 名
+        std::vector<MatchupTask> blocks;
+        std::vector<std::size_t> active;
+        for (std::size_t p = 0; p < pairs.size(); ++p) {
+            if (outcomes[p] != kUnsettled) continue;
+            const int i = static_cast<int>(pairs[p].c0);
+            const int j = static_cast<int>(pairs[p].c1);
+            if (top_k < kNumOfCharacter && status[i] != 0 && status[j] != 0) continue;
+
+            const uint64_t done = race.results[p].Battles();
+            const uint64_t size = std::min(std::max(kMinBlock, done), options.max_battles - done);
+            blocks.push_back({pairs[p].c0, pairs[p].c1, size, done});
+            active.push_back(p);
+        }
+        if (blocks.empty()) break;
+
+        const std::vector<MatchupResult> block_results = RunMatchups(blocks, seed, engine);
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            race.results[active[b]] += block_results[b];
+            race.battles += block_results[b].Battles();
+            outcomes[active[b]] = PairOutcome(race.results[active[b]], options, rule);
+        }
+        ++race.passes;
+    }
+
+    PairwiseRecord record;
+    for (std::size_t p = 0; p < pairs.size(); ++p) {
+        record.Add(pairs[p].c0, pairs[p].c1, race.results[p]);
+        race.settled_pairs += outcomes[p] != kUnsettled ? 1 : 0;
+    }
+    const Ratings bradley_terry = BradleyTerryRatings(record);
+
+    // 每个对局权重相同的平均胜率，未进行过的对局不计
+    for (int i = 0; i < kNumOfCharacter; ++i) {
+        double score  = 0.;
+        int opponents = 0;
+        for (int j = 0; j < kNumOfCharacter; ++j) {
+            if (j == i || record.Games(i, j) == 0.) continue;
+            score += record.wins[i][j] / record.Games(i, j);
+            ++opponents;
+        }
+        race.standings.push_back({static_cast<Character>(i), lower[i], upper[i], opponents > 0 ? score / opponents : 0., bradley_terry[i], status[i]});
+    }
+    std::stable_sort(race.standings.begin(), race.standings.end(), [](const RaceStanding& lhs, const RaceStanding& rhs) {
+        if (lhs.copeland_lower + lhs.copeland_upper != rhs.copeland_lower + rhs.copeland_upper) return lhs.copeland_lower + lhs.copeland_upper > rhs.copeland_lower + rhs.copeland_upper;
+        return lhs.bradley_terry > rhs.bradley_terry;
+    });
+
+    return race;
+}
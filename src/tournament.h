@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "adaptive.h"
+#include "character.h"
+#include "engine.h"
+
+enum class TournamentFormat {
+    ROUND_ROBIN,         // 单循环
+    SWISS,               // 瑞士轮，每轮按积分相近配对且不重复交手
+    SINGLE_ELIMINATION,  // 单败淘汰，人数不足 2 的幂时高种子轮空
+};
+
+struct TournamentOptions {
+    TournamentFormat format = TournamentFormat::ROUND_ROBIN;
+    uint64_t battles        = 1001;  // 每场比赛的战斗场次，胜场多者赢下比赛，相同为平局
+    int swiss_rounds        = 4;
+    double elo_k            = 32.;
+    std::vector<Character> seeding;  // 淘汰赛的种子顺序，为空时按角色编号
+};
+
+// 一场比赛，score 为 a 的得分：胜 1，平 0.5，负 0
+struct MatchRecord {
+    int round;
+    Character a;
+    Character b;
+    uint64_t a_win;
+    uint64_t b_win;
+    uint64_t draw;
+    double score;
+};
+
+// 所有战斗按角色两两累计，wins[i][j] 为 i 胜 j 的场次，平局双方各计半场
+struct PairwiseRecord {
+    double wins[kNumOfCharacter][kNumOfCharacter] = {};
+
+    void Add(Character c0, Character c1, const MatchupResult& result);
+
+    [[nodiscard]] double Games(const int i, const int j) const { return wins[i][j] + wins[j][i]; }
+};
+
+// 评分都换算到 Elo 的刻度：相差 400 分时胜率 10:1，平均为 1500
+using Ratings = std::array<double, kNumOfCharacter>;
+
+// 以 MM 算法求 Bradley–Terry 模型的极大似然解；每个角色额外与一个平均水平的虚拟对手打平一场，
+// 保证全胜、全负或从未交手的角色评分有限
+Ratings
+BradleyTerryRatings(const PairwiseRecord& record);
+
+// 按比赛顺序逐场更新的 Elo 评分
+Ratings
+EloRatings(const std::vector<MatchRecord>& matches, double k);
+
+struct Standing {
+    Character character;
+    double points;        // 比赛积分；淘汰赛为赢下的轮数
+    double battle_score;  // 所有战斗的得分率
+    double bradley_terry;
+    double elo;
+};
+
+struct TournamentResult {
+    std::vector<MatchRecord> matches;
+    std::vector<Standing> standings;  // 按名次排列
+    uint64_t battles = 0;
+};
+
+// 每一轮的全部比赛交给同一个调度器；同一对角色再次交手时接着之前的试验序号，不会重复使用同一批随机数
+TournamentResult
+RunTournament(const TournamentOptions& options, uint64_t seed, Engine engine = Engine::BATCH);
+
+// 竞速找出前 top_k 名：名次按 Copeland 得分（对其余角色胜率高于 50% 的个数，平手计半个）排列。
+// 每个对局分批加倍推进，胜率的置信区间排除 50% 或落入 [0.5 - tie_margin, 0.5 + tie_margin] 时该对局的胜负即已确定；
+// 只继续推进仍可能改变前 top_k 名归属的对局，双方都已确定在前 top_k 名之内或之外的对局不再投入试验。
+// 每批之后都会查看区间，confidence 按对局数与每个对局至多查看的次数做 Bonferroni 校正，是全部对局的胜负同时成立的置信水平
+struct RaceOptions {
+    int top_k            = 3;         // kNumOfCharacter 表示完整排名
+    uint64_t max_battles = 10000000;  // 每个对局的场次上限，达到后按点估计判定
+    double tie_margin    = 0.005;
+    StoppingRule rule;                // 只使用 confidence 和 interval
+};
+
+struct RaceStanding {
+    Character character;
+    double copeland_lower;  // 已确定的得分
+    double copeland_upper;  // 未确定的对局全部获胜时的得分
+    double battle_score;    // 对其余角色的平均胜率
+    double bradley_terry;
+    int status;  // 1 确定在前 top_k 名，-1 确定不在，0 未能区分（Copeland 得分恰好相同）
+};
+
+struct RaceResult {
+    std::vector<RaceStanding> standings;  // 按 Copeland 得分排列
+    std::vector<MatchupResult> results;   // 与 MakeMatchupTasks(0, false) 的顺序一致
+    int settled_pairs      = 0;
+    uint64_t battles       = 0;
+    int passes             = 0;
+    double look_confidence = 0.;  // 校正后每次查看区间所用的置信水平
+};
+
+RaceResult
+RaceTopK(const RaceOptions& options, uint64_t seed, Engine engine = Engine::BATCH);
@@ -0,0 +1,158 @@
+#include "trace.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "player.h"
+
+static std::mutex g_trace_mutex;
+static FILE* g_trace_file = nullptr;
+static std::atomic<bool> g_trace_open{false};  // 供 TraceRefill 不加锁地判断是否需要分配缓冲区
+
+bool
+OpenTrace(const char* path, const uint64_t seed) {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    if (g_trace_file != nullptr) fclose(g_trace_file);
+
+    g_trace_file = fopen(path, "wb");
+    if (g_trace_file == nullptr) return false;
+
+    TraceHeader header{};
+    memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+    header.version     = kTraceVersion;
+    header.record_size = sizeof(TraceRecord);
+    header.seed        = seed;
+    g_trace_open       = true;
+    return fwrite(&header, sizeof(header), 1, g_trace_file) == 1;
+}
+
+void
+CloseTrace() {
+    FlushTrace();
+
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    if (g_trace_file != nullptr) fclose(g_trace_file);
+    g_trace_file = nullptr;
+    g_trace_open = false;
+}
+
+#if defined(ENABLE_TRACE) && (ENABLE_TRACE == 1)
+// 每个线程 1 MiB 缓冲区
+constexpr std::size_t kTraceBufferRecords = 1 << 16;
+
+static thread_local std::vector<TraceRecord> t_trace_buffer;
+
+static void
+WriteTraceBuffer() {
+    if (g_trace.cursor == nullptr) return;
+
+    const auto count = static_cast<std::size_t>(g_trace.cursor - t_trace_buffer.data());
+    if (count != 0) {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        if (g_trace_file != nullptr) fwrite(t_trace_buffer.data(), sizeof(TraceRecord), count, g_trace_file);
+    }
+    g_trace.cursor = t_trace_buffer.data();
+}
+
+void
+TraceRefill() {
+    WriteTraceBuffer();
+
+    if (!g_trace_open.load(std::memory_order_relaxed)) {
+        g_trace.cursor = nullptr;
+        g_trace.end    = nullptr;
+        return;
+    }
+
+    if (t_trace_buffer.empty()) t_trace_buffer.resize(kTraceBufferRecords);
+    g_trace.cursor = t_trace_buffer.data();
+    g_trace.end    = t_trace_buffer.data() + t_trace_buffer.size();
+}
+
+void
+FlushTrace() {
+    WriteTraceBuffer();
+}
+#else
+void
+FlushTrace() {}
+#endif
+
+void
+PrintTraceRecord(FILE* out, const TraceRecord& record) {
+    const char* actor  = GetPlayer(static_cast<Character>(record.actors >> 4))->name;
+    const char* target = GetPlayer(static_cast<Character>(record.actors & 0xF))->name;
+    const int round    = record.round;
+
+    const char* ult_name = nullptr;
+    // clang-format off
+    switch (record.skill) {
+    case Skill::KIANA_ULT:    ult_name = "吃我一矛！";     break;
+    case Skill::MEI_ULT:      ult_name = "雷电家的龙女仆"; break;
+    case Skill::BRONYA_ULT:   ult_name = "摩托拜客哒！";   break;
+    case Skill::SAKURA_ULT:   ult_name = "卡莲的饭团";     break;
+    case Skill::CORVUS_ULT:   ult_name = "别墅小岛";       break;
+    case Skill::THERESA_ULT:  ult_name = "在线踢人";       break;
+    case Skill::OLENYEVA_ULT: ult_name = "变成星星吧！";   break;
+    case Skill::FU_HUA_ULT:   ult_name = "形之笔墨";       break;
+    default: break;
+    }
+    // clang-format on
+    if (ult_name != nullptr) {
+        fprintf(out, "回合%d %s 使用了技能：【%s】对 %s 造成%d点伤害，%s 剩余血量 %d\n", round, actor, ult_name, target, record.value, target, record.hit);
+        return;
+    }
+
+    switch (record.skill) {
+    case Skill::ATTACK:
+        fprintf(out, "回合%d %s 对 %s 普攻，造成%d点伤害，%s 剩余血量 %d\n", round, actor, target, record.value, target, record.hit);
+        break;
+    case Skill::KIANA_STUN:
+        fprintf(out, "回合%d %s 因为【音浪~太强~】技能效果进入了眩晕状态\n", round, actor);
+        break;
+    case Skill::MEI_PARALYZE:
+        fprintf(out, "回合%d %s 使用了技能：【崩坏世界的歌姬】麻痹对方一回合\n", round, actor);
+        break;
+    case Skill::BRONYA_REBUILD:
+        fprintf(out, "回合%d %s 使用了技能：【天使重构】\n", round, actor);
+        break;
+    case Skill::HIMEKO_TRUE_LOVE:
+        fprintf(out, "回合%d %s 使用了技能：【真爱不死】伤害提升100%%\n", round, actor);
+        break;
+    case Skill::HIMEKO_CHEERS:
+        fprintf(out, "回合%d %s 使用了技能：【干杯，朋友】攻击力提升了100%%，命中率下降35%%\n", round, actor);
+        break;
+    case Skill::RITA_CHARM:
+        fprintf(out, "回合%d %s 使用了技能：【完美心意】使 %s 回复了4点血量，并陷入两个回合的魅惑阶段\n", round, actor, target);
+        break;
+    case Skill::RITA_CHARM_FIRST:
+        fprintf(out, "回合%d %s 使用了技能：【完美心意】使 %s 回复了4点血量，并陷入两个回合的魅惑阶段，伤害永久减低60%%\n", round, actor, target);
+        break;
+    case Skill::RITA_CLEANUP:
+        fprintf(out, "回合%d %s 使用了技能：【女仆的温柔清理】使 %s 攻击力永久下降4点\n", round, actor, target);
+        break;
+    case Skill::SAKURA_RICE_BALL:
+        fprintf(out, "回合%d %s 使用了技能：【八重樱的饭团】吃下了饭团，回复25点血量\n", round, actor);
+        break;
+    case Skill::CORVUS_NOT_YOU:
+        fprintf(out, "回合%d %s 使用了技能：【不是针对你】伤害提升了25%%\n", round, actor);
+        break;
+    case Skill::THERESA_CUTE:
+        fprintf(out, "回合%d %s 使用了技能：【血犹大第一可爱】降低了对方5点的防御\n", round, actor);
+        break;
+    case Skill::OLENYEVA_RESURRECT:
+        fprintf(out, "回合%d %s 使用了技能：【96度生命之水】并恢复至%d点血量\n", round, actor, record.value);
+        break;
+    case Skill::SEELE_WHITE:
+        fprintf(out, "回合%d 希尔转变为白形态，防御力上升了，攻击力下降了，回复了%d点血量\n", round, record.value);
+        break;
+    case Skill::SEELE_BLACK:
+        fprintf(out, "回合%d 希尔转变为黑形态，攻击力上升了，防御力下降了\n", round);
+        break;
+    default:
+        fprintf(out, "回合%d 未知事件 %d\n", round, static_cast<int>(record.skill));
+        break;
+    }
+}
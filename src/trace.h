@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "character.h"
+#include "config.h"
+
+// 战斗日志中的每一种事件，解码时按此还原为原来的中文日志行
+enum class Skill : uint8_t {
+    ATTACK,  // 普攻
+
+    // 造成伤害的必杀技
+    KIANA_ULT,     // 吃我一矛！
+    MEI_ULT,       // 雷电家的龙女仆
+    BRONYA_ULT,    // 摩托拜客哒！
+    SAKURA_ULT,    // 卡莲的饭团
+    CORVUS_ULT,    // 别墅小岛
+    THERESA_ULT,   // 在线踢人
+    OLENYEVA_ULT,  // 变成星星吧！
+    FU_HUA_ULT,    // 形之笔墨
+
+    // 不直接造成伤害的技能效果
+    KIANA_STUN,          // 音浪~太强~
+    MEI_PARALYZE,        // 崩坏世界的歌姬
+    BRONYA_REBUILD,      // 天使重构
+    HIMEKO_TRUE_LOVE,    // 真爱不死
+    HIMEKO_CHEERS,       // 干杯，朋友
+    RITA_CHARM,          // 完美心意
+    RITA_CHARM_FIRST,    // 完美心意，首次释放时附带永久减伤
+    RITA_CLEANUP,        // 女仆的温柔清理
+    SAKURA_RICE_BALL,    // 八重樱的饭团
+    CORVUS_NOT_YOU,      // 不是针对你
+    THERESA_CUTE,        // 血犹大第一可爱
+    OLENYEVA_RESURRECT,  // 96度生命之水
+    SEELE_WHITE,         // 希儿转为白形态，value 为回复量
+    SEELE_BLACK,         // 希儿转为黑形态
+    NUM_OF_SKILL
+};
+
+// 固定 16 字节的事件记录
+struct TraceRecord {
+    uint64_t trial;  // (对局 << 48) | 试验序号，对局编号与随机数流相同：c0 * kNumOfCharacter + c1
+    uint16_t round;
+    Skill skill;
+    uint8_t actors;  // 高 4 位为出招方，低 4 位为目标
+    int16_t value;   // 伤害或回复量
+    int16_t hit;     // 目标的剩余血量
+};
+
+static_assert(sizeof(TraceRecord) == 16, "trace records are written to disk as is");
+
+// trace 文件以该文件头开始，其后是各线程按缓冲区整块写入的记录；同一场试验的记录总在同一线程上按顺序产生
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t seed;
+};
+
+constexpr char kTraceMagic[8]     = {'H', 'K', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t kTraceVersion  = 1;
+constexpr int kTraceTrialBits     = 48;
+constexpr uint64_t kTraceTrialMask = (uint64_t{1} << kTraceTrialBits) - 1;
+constexpr int kTraceMaxRound       = UINT16_MAX;  // TraceRecord::round 能记录的最大回合，开启 trace 时回合上限不能超过它
+
+// 打开 trace 文件并写入文件头，之后所有线程产生的记录都写入该文件
+bool
+OpenTrace(const char* path, uint64_t seed);
+
+// 把调用线程缓冲区中的记录写入文件，调度器在每个 worker 完成任务后调用
+void
+FlushTrace();
+
+void
+CloseTrace();
+
+// 把一条记录还原为原来 LOG 输出的日志行
+void
+PrintTraceRecord(FILE* out, const TraceRecord& record);
+
+#if defined(ENABLE_TRACE) && (ENABLE_TRACE == 1)
+// 每个线程写入自己的缓冲区，热路径上不加锁；写满时由 TraceRefill 持锁以 fwrite 整块追加到文件
+struct TraceContext {
+    uint64_t trial       = 0;
+    TraceRecord* cursor = nullptr;
+    TraceRecord* end    = nullptr;
+};
+
+inline thread_local TraceContext g_trace;
+
+// 缓冲区写满或尚未分配时调用：写出已有记录并重置游标；未打开 trace 文件时游标保持为空，记录被丢弃
+void
+TraceRefill();
+
+inline void
+Trace(const int round, const Skill skill, const Character actor, const Character target, const int value, const int hit) {
+    if (g_trace.cursor == g_trace.end) {
+        TraceRefill();
+        if (g_trace.cursor == g_trace.end) return;
+    }
+    *g_trace.cursor++ = {g_trace.trial, static_cast<uint16_t>(round), skill, static_cast<uint8_t>(static_cast<int>(actor) << 4 | static_cast<int>(target)), static_cast<int16_t>(value), static_cast<int16_t>(hit)};
+}
+
+#    define TRACE(round, skill, actor, target, value, hit) Trace(round, skill, actor, target, value, hit)
+#    define TRACE_TRIAL(matchup, index)                    (g_trace.trial = static_cast<uint64_t>(matchup) << kTraceTrialBits | (index))
+#else
+#    define TRACE(round, skill, actor, target, value, hit) ((void)0)
+#    define TRACE_TRIAL(matchup, index)                    ((void)0)
+#endif
@@ -0,0 +1,361 @@
+#include "variance.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "thread_pool.h"
+
+// 每个工作项包含的单元数
+constexpr uint64_t kUnitsPerItem = 1 << 14;
+
+// 派生拟随机点数字移位的流编号，与各对局的 matchup 编号不重叠
+constexpr uint64_t kQmcShiftStream = 0x5157A3C9E1D2B4F6ull;
+
+// Joe & Kuo 的方向数：本原多项式的次数 s、系数 a 与初始值 m；第 1 维为 van der Corput 序列
+struct SobolPolynomial {
+    int s;
+    int a;
+    uint32_t m[5];
+};
+
+constexpr SobolPolynomial kSobolPolynomials[kMaxQmcDims] = {
+    {0, 0, {}},
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+};
+
+struct SobolDirections {
+    uint32_t v[kMaxQmcDims][32];
+
+    SobolDirections() : v() {
+        for (int dim = 0; dim < kMaxQmcDims; ++dim) {
+            const SobolPolynomial& poly = kSobolPolynomials[dim];
+            for (int k = 0; k < 32; ++k) {
+                if (dim == 0) {
+                    v[dim][k] = uint32_t{1} << (31 - k);
+                } else if (k < poly.s) {
+                    v[dim][k] = poly.m[k] << (31 - k);
+                } else {
+                    v[dim][k] = v[dim][k - poly.s] ^ (v[dim][k - poly.s] >> poly.s);
+                    for (int i = 1; i < poly.s; ++i) {
+                        if (((poly.a >> (poly.s - 1 - i)) & 1) != 0) v[dim][k] ^= v[dim][k - i];
+                    }
+                }
+            }
+        }
+    }
+};
+
+static const SobolDirections kSobolDirections;
+
+uint32_t
+SobolPoint(const int dim, uint32_t index) {
+    uint32_t point = 0;
+    for (int k = 0; index != 0; ++k, index >>= 1) {
+        if ((index & 1) != 0) point ^= kSobolDirections.v[dim][k];
+    }
+    return point;
+}
+
+// 一场战斗，返回 p0 是否获胜；随机位的替换由调用方通过 g_random_hooks 设置
+using VarianceKernel = bool (*)(uint64_t seed, uint64_t trial);
+
+template <Character C0, Character C1, bool P0First>
+struct WinKernel {
+    static bool Run(const uint64_t seed, const uint64_t trial) {
+        constexpr uint64_t matchup = static_cast<uint64_t>(C0) * kNumOfCharacter + static_cast<uint64_t>(C1);
+
+        SeedTrial(seed, matchup, trial);
+        CharacterType<C0> p_0;
+        CharacterType<C1> p_1;
+
+        if constexpr (P0First) {
+            const BattleOutcome outcome = RunBattle(p_0, p_1, MaxRounds());
+            return !outcome.draw && outcome.first_win;
+        } else {
+            const BattleOutcome outcome = RunBattle(p_1, p_0, MaxRounds());
+            return !outcome.draw && !outcome.first_win;
+        }
+    }
+};
+
+constexpr auto kWinKernels = MakeKernelTable<VarianceKernel, WinKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+// 单元取值以 1 / 每单元每张数值表的场次 为单位累加成整数，结果与线程数和调度顺序无关
+struct alignas(kCacheLineSize) VarianceAccumulator {
+    uint64_t units                           = 0;
+    int64_t sum                              = 0;
+    uint64_t sum_squares                     = 0;
+    uint64_t wins[2]                         = {};  // 两张数值表下 p0 的胜场
+    int64_t replicate_sum[kQmcReplicates]    = {};
+    uint64_t replicate_units[kQmcReplicates] = {};
+
+    VarianceAccumulator& operator+=(const VarianceAccumulator& other) {
+        units += other.units;
+        sum += other.sum;
+        sum_squares += other.sum_squares;
+        for (int i = 0; i < 2; ++i) wins[i] += other.wins[i];
+        for (int r = 0; r < kQmcReplicates; ++r) {
+            replicate_sum[r] += other.replicate_sum[r];
+            replicate_units[r] += other.replicate_units[r];
+        }
+        return *this;
+    }
+};
+
+struct VarianceItem {
+    std::size_t task;
+    uint64_t begin;
+    uint64_t end;
+};
+
+static VarianceEstimate
+Estimate(const VarianceAccumulator& acc, const VarianceOptions& options) {
+    const int per_unit = options.antithetic ? 2 : 1;
+    const double scale = per_unit;
+    const auto units   = static_cast<double>(acc.units);
+
+    VarianceEstimate estimate;
+    estimate.battles = acc.units * static_cast<uint64_t>(per_unit);
+    if (acc.units == 0) return estimate;
+
+    const auto battles = static_cast<double>(estimate.battles);
+    estimate.estimate  = static_cast<double>(acc.sum) / (units * scale);
+    for (int i = 0; i < 2; ++i) estimate.win_rates[i] = static_cast<double>(acc.wins[i]) / battles;
+
+    if (options.qmc_dims > 0) {
+        // 各组移位独立，组均值的样本方差给出总均值的方差
+        double mean_sum    = 0.;
+        double mean_sum_sq = 0.;
+        int replicates     = 0;
+        for (int r = 0; r < kQmcReplicates; ++r) {
+            if (acc.replicate_units[r] == 0) continue;
+            const double mean = static_cast<double>(acc.replicate_sum[r]) / (static_cast<double>(acc.replicate_units[r]) * scale);
+            mean_sum += mean;
+            mean_sum_sq += mean * mean;
+            ++replicates;
+        }
+        if (replicates > 1) {
+            const double variance = std::max(0., (mean_sum_sq - mean_sum * mean_sum / replicates) / (replicates - 1));
+            estimate.std_error    = std::sqrt(variance / replicates);
+        }
+    } else if (acc.units > 1) {
+        const double sum      = static_cast<double>(acc.sum) / scale;
+        const double variance = std::max(0., (static_cast<double>(acc.sum_squares) / (scale * scale) - sum * sum / units) / (units - 1.));
+        estimate.std_error    = std::sqrt(variance / units);
+    }
+
+    double plain_variance = estimate.win_rates[0] * (1. - estimate.win_rates[0]);
+    if (options.variant != nullptr) plain_variance += estimate.win_rates[1] * (1. - estimate.win_rates[1]);
+    estimate.plain_std_error = std::sqrt(plain_variance / battles);
+    return estimate;
+}
+
+std::vector<VarianceEstimate>
+RunVarianceReduced(const std::vector<MatchupTask>& tasks, const uint64_t seed, const VarianceOptions& options) {
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int num_workers = pool.NumThreads();
+    const int per_unit    = options.antithetic ? 2 : 1;
+    const int num_tables  = options.variant != nullptr ? 2 : 1;
+    const int qmc_dims    = std::clamp(options.qmc_dims, 0, kMaxQmcDims);
+
+    // 各对局在两张数值表下的内核，以及每组拟随机点的数字移位
+    std::vector<VarianceKernel> kernels;
+    std::vector<uint32_t> shifts;
+    std::vector<VarianceItem> items;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupTask& task = tasks[t];
+        kernels.push_back(kWinKernels[KernelIndex(task.c0, task.c1, task.Table())]);
+        kernels.push_back(options.variant != nullptr ? kWinKernels[KernelIndex(task.c0, task.c1, *options.variant)] : nullptr);
+
+        const uint64_t matchup = static_cast<uint64_t>(task.c0) * kNumOfCharacter + static_cast<uint64_t>(task.c1);
+        for (int r = 0; r < kQmcReplicates; ++r) {
+            for (int j = 0; j < kMaxQmcDims; ++j) shifts.push_back(static_cast<uint32_t>(Mix64(Mix64(Mix64(seed ^ kQmcShiftStream) ^ matchup) ^ static_cast<uint64_t>(r * kMaxQmcDims + j)) >> 32));
+        }
+
+        const uint64_t units = task.times / static_cast<uint64_t>(per_unit);
+        for (uint64_t begin = 0; begin < units; begin += kUnitsPerItem) items.push_back({t, begin, std::min(begin + kUnitsPerItem, units)});
+    }
+
+    std::atomic<std::size_t> next_item{0};
+    std::vector<VarianceAccumulator> worker_results(static_cast<std::size_t>(num_workers) * tasks.size());
+
+    pool.Run([&](const int worker) {
+        VarianceAccumulator* const results      = &worker_results[static_cast<std::size_t>(worker) * tasks.size()];
+        const CharacterTable* const saved_table = g_character_table;
+
+        // 不做替换时不设置钩子，与普通蒙特卡洛走同一条抽取路径
+        RandomOverride override;
+        override.num_points = qmc_dims;
+        const RandomHooks hooks{nullptr, &override};
+        if (options.antithetic || qmc_dims > 0) g_random_hooks = &hooks;
+
+        for (std::size_t i = next_item.fetch_add(1); i < items.size(); i = next_item.fetch_add(1)) {
+            const VarianceItem& item    = items[i];
+            const MatchupTask& task     = tasks[item.task];
+            VarianceAccumulator& result = results[item.task];
+
+            for (uint64_t unit = item.begin; unit < item.end; ++unit) {
+                // 交错分组，每组依次使用 Sobol 序列的第 0, 1, 2, ... 个点
+                const int replicate = static_cast<int>(unit % kQmcReplicates);
+                const auto index    = static_cast<uint32_t>(unit / kQmcReplicates);
+                for (int j = 0; j < qmc_dims; ++j) override.points[j] = SobolPoint(j, index) ^ shifts[(item.task * kQmcReplicates + static_cast<std::size_t>(replicate)) * kMaxQmcDims + static_cast<std::size_t>(j)];
+
+                int64_t value = 0;
+                for (int copy = 0; copy < per_unit; ++copy) {
+                    override.flip = copy == 0 ? 0 : ~uint32_t{0};
+                    for (int table = 0; table < num_tables; ++table) {
+                        override.used     = 0;
+                        g_character_table = table == 0 ? &task.Table() : options.variant;
+                        const bool win    = kernels[item.task * 2 + static_cast<std::size_t>(table)](seed, unit);
+                        result.wins[table] += win ? 1 : 0;
+                        value += win ? (table == 0 ? 1 : -1) : 0;
+                    }
+                }
+
+                ++result.units;
+                result.sum += value;
+                result.sum_squares += static_cast<uint64_t>(value * value);
+                result.replicate_sum[replicate] += value;
+                ++result.replicate_units[replicate];
+            }
+        }
+
+        g_character_table = saved_table;
+        g_random_hooks    = nullptr;
+    });
+
+    std::vector<VarianceEstimate> estimates;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        VarianceAccumulator acc;
+        for (int worker = 0; worker < num_workers; ++worker) acc += worker_results[static_cast<std::size_t>(worker) * tasks.size() + t];
+        estimates.push_back(Estimate(acc, options));
+    }
+    return estimates;
+}
+
+// 在线程池上完成各对局的 [begin, begin + times) 号试验，两张表交替进行
+static std::vector<PairedCounts>
+RunPairedBlock(const std::vector<MatchupTask>& blocks, const uint64_t seed, const CharacterTable& patched) {
+    ThreadPool& pool      = ThreadPool::Instance();
+    const int num_workers = pool.NumThreads();
+
+    std::vector<VarianceKernel> kernels;
+    std::vector<VarianceItem> items;
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        const MatchupTask& block = blocks[b];
+        kernels.push_back(kWinKernels[KernelIndex(block.c0, block.c1, block.Table())]);
+        kernels.push_back(kWinKernels[KernelIndex(block.c0, block.c1, patched)]);
+
+        const uint64_t end = block.begin + block.times;
+        for (uint64_t begin = block.begin; begin < end; begin += kUnitsPerItem) items.push_back({b, begin, std::min(begin + kUnitsPerItem, end)});
+    }
+
+    std::atomic<std::size_t> next_item{0};
+    std::vector<PairedCounts> worker_results(static_cast<std::size_t>(num_workers) * blocks.size());
+
+    pool.Run([&](const int worker) {
+        PairedCounts* const results             = &worker_results[static_cast<std::size_t>(worker) * blocks.size()];
+        const CharacterTable* const saved_table = g_character_table;
+
+        for (std::size_t i = next_item.fetch_add(1); i < items.size(); i = next_item.fetch_add(1)) {
+            const VarianceItem& item    = items[i];
+            const CharacterTable& table = blocks[item.task].Table();
+            PairedCounts& result        = results[item.task];
+
+            for (uint64_t trial = item.begin; trial < item.end; ++trial) {
+                g_character_table    = &table;
+                const bool base_win  = kernels[item.task * 2](seed, trial);
+                g_character_table    = &patched;
+                const bool patch_win = kernels[item.task * 2 + 1](seed, trial);
+
+                ++result.pairs;
+                result.wins[0] += base_win ? 1 : 0;
+                result.wins[1] += patch_win ? 1 : 0;
+                result.discordant[0] += base_win && !patch_win ? 1 : 0;
+                result.discordant[1] += !base_win && patch_win ? 1 : 0;
+            }
+        }
+
+        g_character_table = saved_table;
+    });
+
+    std::vector<PairedCounts> results(blocks.size());
+    for (int worker = 0; worker < num_workers; ++worker) {
+        for (std::size_t b = 0; b < blocks.size(); ++b) results[b] += worker_results[static_cast<std::size_t>(worker) * blocks.size() + b];
+    }
+    return results;
+}
+
+// 逐对差值 d 取 -1 / 0 / 1，delta 为其均值，标准误由 d 的样本方差给出；
+// 方差至少取 1 / n，n 场中没有一场胜负不同时区间约为 ±z / n，而不是退化为一个点
+static void
+EstimatePaired(PairedEstimate& estimate, const double z) {
+    const PairedCounts& counts = estimate.counts;
+    if (counts.pairs == 0) return;
+
+    const auto n = static_cast<double>(counts.pairs);
+    for (int i = 0; i < 2; ++i) estimate.win_rates[i] = static_cast<double>(counts.wins[i]) / n;
+    estimate.delta = estimate.win_rates[1] - estimate.win_rates[0];
+
+    const double discordant = static_cast<double>(counts.discordant[0] + counts.discordant[1]) / n;
+    const double variance   = std::max(1. / n, counts.pairs > 1 ? (discordant - estimate.delta * estimate.delta) * n / (n - 1.) : 0.);
+    estimate.std_error       = std::sqrt(variance / n);
+    estimate.plain_std_error = std::sqrt((estimate.win_rates[0] * (1. - estimate.win_rates[0]) + estimate.win_rates[1] * (1. - estimate.win_rates[1])) / n);
+    estimate.lower           = estimate.delta - z * estimate.std_error;
+    estimate.upper           = estimate.delta + z * estimate.std_error;
+}
+
+std::vector<PairedEstimate>
+RunPairedComparison(const std::vector<MatchupTask>& tasks, const uint64_t seed, const CharacterTable& patched, const StoppingRule& rule) {
+    constexpr uint64_t kMinBlock = 1 << 16;
+
+    const double z     = NormalQuantile(1. - (1. - rule.confidence) / 2.);
+    const double width = rule.Enabled() ? rule.width : kPairedDefaultWidth;
+
+    // 只有至少一方的定义改变的对局需要模拟
+    std::vector<PairedEstimate> estimates(tasks.size());
+    std::vector<std::size_t> pending;
+    for (std::size_t t = 0; t < tasks.size(); ++t) {
+        const MatchupTask& task = tasks[t];
+        estimates[t].affected   = CharacterDefinitionHash(task.c0, task.Table()) != CharacterDefinitionHash(task.c0, patched) || CharacterDefinitionHash(task.c1, task.Table()) != CharacterDefinitionHash(task.c1, patched);
+        if (estimates[t].affected && task.times > 0) pending.push_back(t);
+    }
+
+    while (!pending.empty()) {
+        // 按当前的逐对方差估计区间收窄到目标宽度所需的场次，每批至多把场次扩大到 8 倍
+        std::vector<MatchupTask> blocks;
+        for (const std::size_t t : pending) {
+            const PairedEstimate& estimate = estimates[t];
+            const uint64_t done            = estimate.counts.pairs;
+            uint64_t target                = kMinBlock;
+            if (done > 0) {
+                const double half     = width / 2.;
+                const double variance = estimate.std_error * estimate.std_error * static_cast<double>(done);
+                const auto needed     = static_cast<uint64_t>(std::ceil(z * z * variance / (half * half)));
+                target                = std::clamp(needed, done + kMinBlock, done * 8);
+            }
+            target = std::min(target, tasks[t].times);
+            blocks.push_back({tasks[t].c0, tasks[t].c1, target - done, tasks[t].begin + done, tasks[t].table});
+        }
+
+        const std::vector<PairedCounts> block_counts = RunPairedBlock(blocks, seed, patched);
+
+        std::vector<std::size_t> still_pending;
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            PairedEstimate& estimate = estimates[pending[b]];
+            estimate.counts += block_counts[b];
+            EstimatePaired(estimate, z);
+            if (estimate.upper - estimate.lower > width && estimate.counts.pairs < tasks[pending[b]].times) still_pending.push_back(pending[b]);
+        }
+        pending.swap(still_pending);
+    }
+
+    return estimates;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "adaptive.h"
+#include "character_table.h"
+#include "engine.h"
+#include "random.h"
+
+// 拟随机点分成 kQmcReplicates 组，每组使用各自的随机数字移位，组间的差异给出估计的标准误
+constexpr int kQmcReplicates = 32;
+
+// 方差缩减的抽样方式，可以组合使用；全部关闭时与普通蒙特卡洛的第 0 ~ times - 1 号试验完全相同
+struct VarianceOptions {
+    bool antithetic = false;  // 第 k 个单元进行两场战斗：k 号试验及其所有随机位取反的对偶试验
+    int qmc_dims    = 0;      // 每场战斗的前 qmc_dims 次抽取改用随机化的 Sobol 点，至多 kMaxQmcDims
+    const CharacterTable* variant = nullptr;  // 非空时估计当前数值表与 variant 下 p0 胜率之差，两者使用共同随机数
+};
+
+// 估计值与普通蒙特卡洛在相同场次下的标准误之比：方差缩减倍数即同样精度下所需场次之比
+struct VarianceEstimate {
+    uint64_t battles       = 0;   // 每张数值表各进行的战斗场次
+    double estimate        = 0.;  // p0 胜率；比较数值表时为胜率之差
+    double std_error       = 0.;
+    double plain_std_error = 0.;  // 相同场次的独立抽样的标准误
+    double win_rates[2]    = {};  // 比较数值表时两张表各自的 p0 胜率
+
+    // 两者都为 0（胜负已定的对局）时记为 1
+    [[nodiscard]] double ReductionFactor() const {
+        if (std_error == 0.) return plain_std_error == 0. ? 1. : INFINITY;
+        return plain_std_error * plain_std_error / (std_error * std_error);
+    }
+
+    // 达到同样标准误所需的普通蒙特卡洛场次
+    [[nodiscard]] double EffectiveSampleSize() const { return static_cast<double>(battles) * ReductionFactor(); }
+};
+
+// 在线程池上按 options 估计各对局，每个对局进行 task.times 场（对偶时为 times / 2 个单元）；
+// 需要逐场的胜负，因此使用特化内核而不是批量引擎
+std::vector<VarianceEstimate>
+RunVarianceReduced(const std::vector<MatchupTask>& tasks, uint64_t seed, const VarianceOptions& options);
+
+// A/B 比较未指定 --ci-width 时胜率之差的目标区间宽度，即把 ±0.1% 的变化与 0 区分开
+constexpr double kPairedDefaultWidth = 0.002;
+
+// 同一试验序号在基准与改动后的数值表下各进行一场的累计计数
+struct PairedCounts {
+    uint64_t pairs         = 0;
+    uint64_t wins[2]       = {};  // 基准 / 改动后 p0 的胜场
+    uint64_t discordant[2] = {};  // 只在基准下 p0 胜 / 只在改动后 p0 胜的试验数
+
+    PairedCounts& operator+=(const PairedCounts& other) {
+        pairs += other.pairs;
+        for (int i = 0; i < 2; ++i) {
+            wins[i] += other.wins[i];
+            discordant[i] += other.discordant[i];
+        }
+        return *this;
+    }
+};
+
+struct PairedEstimate {
+    bool affected = false;  // 双方在两张表下的定义都相同时为 false，两边的战斗逐场相同，不做模拟
+    PairedCounts counts;
+    double win_rates[2]    = {};
+    double delta           = 0.;  // 改动后减基准的 p0 胜率
+    double lower           = 0.;  // delta 的置信区间
+    double upper           = 0.;
+    double std_error       = 0.;
+    double plain_std_error = 0.;  // 两边各自独立抽样同样场次时 delta 的标准误
+
+    // 独立抽样达到同样标准误所需的场次倍数
+    [[nodiscard]] double ReductionFactor() const {
+        if (std_error == 0.) return plain_std_error == 0. ? 1. : INFINITY;
+        return plain_std_error * plain_std_error / (std_error * std_error);
+    }
+
+    [[nodiscard]] bool Significant() const { return affected && (lower > 0. || upper < 0.); }
+};
+
+// 以各对局自己的数值表为基准、patched 为改动后的数值表做成对比较：两边的第 k 场使用同一条随机数流，
+// 胜率之差的方差只来自两边胜负不同的试验。各对局分批推进，直到 delta 的置信区间宽度不超过 rule.width
+// 或用完 task.times 场；基准一侧的胜场与同一种子下普通模拟的前若干场完全相同
+std::vector<PairedEstimate>
+RunPairedComparison(const std::vector<MatchupTask>& tasks, uint64_t seed, const CharacterTable& patched, const StoppingRule& rule);
+
+// 第 dim 维的第 index 个 Sobol 点，以 2^-32 为单位
+uint32_t
+SobolPoint(int dim, uint32_t index);
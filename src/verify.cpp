@@ -0,0 +1,126 @@
+#include "verify.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "battle_state.h"
+#include "random.h"
+
+// 每个角色组合取前 kScriptedTrials 号试验，分别停在第 trial % kScriptedRounds 回合结束时作为比较出招的局面
+constexpr uint64_t kScriptedTrials = 16;
+constexpr int kScriptedRounds      = 8;
+
+struct ScriptedBranch {
+    Player::AttackResult result;
+    double probability;
+    FighterState fighters[2];
+};
+
+static bool
+operator==(const ScriptedBranch& lhs, const ScriptedBranch& rhs) {
+    return lhs.result == rhs.result && lhs.probability == rhs.probability && std::memcmp(lhs.fighters, rhs.fighters, sizeof(lhs.fighters)) == 0;
+}
+
+using ScriptedFn = void (*)(const BattleState& state, std::vector<ScriptedBranch>& reference, std::vector<ScriptedBranch>& specialized);
+
+// 由 P0Attacks 决定出招方，在第 state.round + 1 回合出招一次
+template <Character C0, Character C1, bool P0Attacks>
+struct ScriptedKernel {
+    static void Run(const BattleState& state, std::vector<ScriptedBranch>& reference, std::vector<ScriptedBranch>& specialized) {
+        using T0 = CharacterType<C0>;
+        using T1 = CharacterType<C1>;
+
+        const int round = state.round + 1;
+
+        RandomScript script;
+        const RandomHooks hooks{&script};
+        g_random_hooks = &hooks;
+
+        const auto enumerate = [&](std::vector<ScriptedBranch>& branches, const auto& attack) {
+            branches.clear();
+            do {
+                script.Rewind();
+
+                T0 p_0;
+                T1 p_1;
+                RestoreFighter(state.fighters[0], p_0);
+                RestoreFighter(state.fighters[1], p_1);
+
+                const Player::AttackResult result = attack(p_0, p_1);
+                branches.push_back({result, script.Probability(), {CaptureFighter(p_0), CaptureFighter(p_1)}});
+            } while (script.Advance());
+        };
+
+        // 参考实现经由 Player& 调用 Attack，对方的 DoAtk / DoUlt 也按虚函数分发，与 VIRTUAL 引擎相同
+        enumerate(reference, [round](Player& p_0, Player& p_1) { return P0Attacks ? p_0.Attack(round, p_1) : p_1.Attack(round, p_0); });
+        enumerate(specialized, [round](T0& p_0, T1& p_1) { return P0Attacks ? p_0.AttackOn(round, p_1) : p_1.AttackOn(round, p_0); });
+
+        g_random_hooks = nullptr;
+    }
+};
+
+constexpr auto kScriptedKernels = MakeKernelTable<ScriptedFn, ScriptedKernel>(std::make_index_sequence<kNumOfCharacter * kNumOfCharacter * 2>{});
+
+static void
+VerifyScriptedAttacks(const uint64_t seed, VerifyReport& report) {
+    std::vector<ScriptedBranch> reference;
+    std::vector<ScriptedBranch> specialized;
+
+    for (int c0 = 0; c0 < kNumOfCharacter; ++c0) {
+        for (int c1 = 0; c1 < kNumOfCharacter; ++c1) {
+            for (uint64_t trial = 0; trial < kScriptedTrials; ++trial) {
+                // 第 0 回合即初始局面
+                BattleState state;
+                if (!SnapshotBattle(static_cast<Character>(c0), static_cast<Character>(c1), seed, trial, static_cast<int>(trial % kScriptedRounds), state)) continue;
+
+                for (const bool p0_attacks : {true, false}) {
+                    kScriptedKernels[(static_cast<std::size_t>(c0) * kNumOfCharacter + static_cast<std::size_t>(c1)) * 2 + (p0_attacks ? 1 : 0)](state, reference, specialized);
+
+                    ++report.scripted_positions;
+                    report.scripted_branches += reference.size();
+                    if (reference.size() == specialized.size() && std::equal(reference.begin(), reference.end(), specialized.begin())) continue;
+
+                    const auto first_difference = std::mismatch(reference.begin(), reference.end(), specialized.begin(), specialized.end()).first - reference.begin();
+                    const char* attacker        = GetPlayer(static_cast<Character>(p0_attacks ? c0 : c1))->name;
+                    const char* defender        = GetPlayer(static_cast<Character>(p0_attacks ? c1 : c0))->name;
+
+                    char message[256];
+                    snprintf(message, sizeof(message), "%s 攻击 %s：第 %llu 号试验第 %d 回合的出招，参考实现 %zu 个分支，特化内核 %zu 个分支，第 %td 个分支起不同", attacker, defender, static_cast<unsigned long long>(trial), state.round + 1, reference.size(), specialized.size(), first_difference);
+                    report.scripted_failures.emplace_back(message);
+                }
+            }
+        }
+    }
+}
+
+static bool
+SameCounts(const MatchupResult& lhs, const MatchupResult& rhs) {
+    if (lhs.p0_win != rhs.p0_win || lhs.p1_win != rhs.p1_win || lhs.draw != rhs.draw || lhs.attacker_dead != rhs.attacker_dead || lhs.rounds != rhs.rounds) return false;
+#if defined(ENABLE_STATS) && (ENABLE_STATS == 1)
+    if (std::memcmp(&lhs.stats, &rhs.stats, sizeof(BattleStats)) != 0) return false;
+#endif
+    return true;
+}
+
+VerifyReport
+VerifyEngines(const std::vector<MatchupTask>& tasks, const uint64_t seed) {
+    VerifyReport report;
+    VerifyScriptedAttacks(seed, report);
+
+    const std::vector<MatchupResult> reference = RunMatchups(tasks, seed, Engine::VIRTUAL);
+
+    for (const Engine engine : {Engine::SPECIALIZED, Engine::BATCH}) {
+        EngineVerification verification;
+        verification.engine = engine;
+
+        const std::vector<MatchupResult> same_seed = RunMatchups(tasks, seed, engine);
+        for (std::size_t t = 0; t < tasks.size(); ++t) {
+            if (!SameCounts(reference[t], same_seed[t])) ++verification.mismatched;
+        }
+
+        report.engines.push_back(verification);
+    }
+
+    return report;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+
+// 未指定 --times 时每个对局每个引擎的场次
+constexpr uint64_t kVerifyTimes = 200000;
+
+// 一个优化引擎与虚函数参考实现的比较
+struct EngineVerification {
+    Engine engine       = Engine::SPECIALIZED;
+    uint64_t mismatched = 0;  // 同一种子下计数（含 --stats 的全部计数与直方图）与参考实现不完全相同的对局数
+
+    [[nodiscard]] bool Passed() const { return mismatched == 0; }
+};
+
+struct VerifyReport {
+    uint64_t scripted_positions = 0;  // 逐分支比较过出招的局面数
+    uint64_t scripted_branches  = 0;
+    std::vector<std::string> scripted_failures;
+    std::vector<EngineVerification> engines;
+
+    [[nodiscard]] bool Passed() const {
+        for (const auto& engine : engines) {
+            if (!engine.Passed()) return false;
+        }
+        return scripted_failures.empty();
+    }
+};
+
+// 检查各优化引擎没有改变游戏行为，分两部分：
+// 1. 脚本化随机数：对所有角色组合的若干局面，以精确求解器的随机脚本枚举一次出招的全部随机分支，
+//    逐分支比较虚函数路径与特化内核的结果、概率和双方状态；
+// 2. 同一种子：特化与批量引擎的全部计数必须与虚函数参考实现逐位相同。
+// 两者只说明各路径彼此一致；各角色技能本身是否正确由 tests/ 中按手算结果比对的黄金测试检查
+VerifyReport
+VerifyEngines(const std::vector<MatchupTask>& tasks, uint64_t seed);
@@ -0,0 +1,299 @@
+// 各角色出招的黄金测试：从手写的局面出发出招一次，按随机脚本的固定顺序枚举全部随机分支，
+// 参考实现（Attack）与特化实现（AttackOn）出招后的结果、分支概率与双方状态都须与手算的结果逐项相同。
+// 随机脚本中概率判定先枚举成立、再枚举不成立，整数抽取从小到大；命中率为 1 时命中判定不产生分支
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "battle_state.h"
+#include "character_table.h"
+#include "player.h"
+#include "random.h"
+
+using Result = Player::AttackResult;
+
+// 概率与命中率按 float 阈值换算，与手算的十进制值相差不到 1e-7
+constexpr double kTolerance = 1e-6;
+
+// 一次出招的一个随机分支；状态依次为 {命中率, 血量, 防御, 攻击, 被控回合, 魅惑回合, 私有状态}
+struct GoldenBranch {
+    Result result;
+    double probability;
+    FighterState attacker;
+    FighterState defender;
+};
+
+static int g_cases    = 0;
+static int g_failures = 0;
+
+static bool
+SameState(const FighterState& lhs, const FighterState& rhs) {
+    return std::abs(lhs.hit_rate - rhs.hit_rate) < kTolerance && lhs.hit == rhs.hit && lhs.def == rhs.def && lhs.atk == rhs.atk && lhs.buff_opponent == rhs.buff_opponent && lhs.buff_charm == rhs.buff_charm && lhs.extra == rhs.extra;
+}
+
+static void
+PrintState(const char* label, const FighterState& state) {
+    fprintf(stderr, "        %s {%g, %d, %d, %d, %d, %d, %d}\n", label, static_cast<double>(state.hit_rate), state.hit, state.def, state.atk, state.buff_opponent, state.buff_charm, state.extra);
+}
+
+// attacker 以 A 的身份在第 round 回合对 D 出招一次
+template <class A, class D>
+static void
+CheckAttack(const char* name, const FighterState& attacker, const FighterState& defender, const int round, const std::vector<GoldenBranch>& expected) {
+    ++g_cases;
+
+    RandomScript script;
+    const RandomHooks hooks{&script};
+    g_random_hooks = &hooks;
+
+    bool failed        = false;
+    const auto enumerate = [&](const char* path, const auto& attack) {
+        std::size_t branch = 0;
+        do {
+            script.Rewind();
+
+            A a;
+            D d;
+            RestoreFighter(attacker, a);
+            RestoreFighter(defender, d);
+            const Result result = attack(a, d);
+
+            if (branch < expected.size()) {
+                const GoldenBranch& golden = expected[branch];
+                if (result != golden.result || std::abs(script.Probability() - golden.probability) > kTolerance || !SameState(CaptureFighter(a), golden.attacker) || !SameState(CaptureFighter(d), golden.defender)) {
+                    fprintf(stderr, "%s：%s的第 %zu 个分支不符，结果 %d（应为 %d），概率 %.8f（应为 %.8f）\n", name, path, branch, static_cast<int>(result), static_cast<int>(golden.result), script.Probability(), golden.probability);
+                    PrintState("出招方", CaptureFighter(a));
+                    PrintState("应为  ", golden.attacker);
+                    PrintState("对方  ", CaptureFighter(d));
+                    PrintState("应为  ", golden.defender);
+                    failed = true;
+                }
+            }
+            ++branch;
+        } while (script.Advance());
+
+        if (branch != expected.size()) {
+            fprintf(stderr, "%s：%s有 %zu 个分支，应为 %zu 个\n", name, path, branch, expected.size());
+            failed = true;
+        }
+    };
+
+    enumerate("参考实现", [round](Player& a, Player& d) { return a.Attack(round, d); });
+    enumerate("特化实现", [round](A& a, D& d) { return a.AttackOn(round, d); });
+
+    g_random_hooks = nullptr;
+    if (failed) ++g_failures;
+}
+
+// 默认数值表下各角色的初始状态
+constexpr FighterState kKiana    = {1.f, 100, 11, 24, 0, 0, 0};
+constexpr FighterState kMei      = {1.f, 100, 12, 22, 0, 0, 0};
+constexpr FighterState kBronya   = {1.f, 100, 10, 21, 0, 0, 0};
+constexpr FighterState kHimeko   = {1.f, 100, 9, 23, 0, 0, 0};
+constexpr FighterState kRita     = {1.f, 100, 11, 26, 0, 0, 0};
+constexpr FighterState kCorvus   = {1.f, 100, 14, 23, 0, 0, 0};
+constexpr FighterState kTheresa  = {1.f, 100, 12, 19, 0, 0, 0};
+constexpr FighterState kOlenyeva = {1.f, 100, 10, 18, 0, 0, 1};  // 私有状态为 boom * 2 + 复活次数
+constexpr FighterState kSeele    = {1.f, 100, 13, 23, 0, 0, 0};  // 私有状态 0 为白希
+constexpr FighterState kDurandal = {1.f, 100, 10, 19, 0, 0, 0};
+constexpr FighterState kFuHua    = {1.f, 100, 15, 17, 0, 0, 0};
+
+static void
+TestKiana() {
+    // 必杀技造成 atk + 对方防御 = 24 + 12 点伤害，之后以 0.35 的概率眩晕自己一回合
+    CheckAttack<Kiana, Mei>("琪亚娜必杀技", kKiana, kMei, 2,
+                            {
+                                {Result::ALL_ALIVE, 0.35, {1.f, 100, 11, 24, 0, 0, 1}, {1.f, 64, 12, 22, 0, 0, 0}},
+                                {Result::ALL_ALIVE, 0.65, kKiana, {1.f, 64, 12, 22, 0, 0, 0}},
+                            });
+    CheckAttack<Kiana, Mei>("琪亚娜普攻", kKiana, kMei, 1, {{Result::ALL_ALIVE, 1., kKiana, {1.f, 88, 12, 22, 0, 0, 0}}});
+    CheckAttack<Kiana, Mei>("琪亚娜击倒", kKiana, {1.f, 10, 12, 22, 0, 0, 0}, 1, {{Result::DEFENDER_DEAD, 1., kKiana, {1.f, -2, 12, 22, 0, 0, 0}}});
+    CheckAttack<Kiana, Mei>("琪亚娜眩晕中", {1.f, 100, 11, 24, 0, 0, 1}, kMei, 2, {{Result::ALL_ALIVE, 1., kKiana, kMei}});
+    // 被魅惑时必杀技回合也只普攻
+    CheckAttack<Kiana, Mei>("琪亚娜被魅惑", {1.f, 100, 11, 24, 0, 2, 0}, kMei, 2, {{Result::ALL_ALIVE, 1., {1.f, 100, 11, 24, 0, 1, 0}, {1.f, 88, 12, 22, 0, 0, 0}}});
+}
+
+static void
+TestMei() {
+    CheckAttack<Mei, Kiana>("芽衣普攻与麻痹", kMei, kKiana, 1,
+                            {
+                                {Result::ALL_ALIVE, 0.3, kMei, {1.f, 89, 11, 24, 1, 0, 0}},
+                                {Result::ALL_ALIVE, 0.7, kMei, {1.f, 89, 11, 24, 0, 0, 0}},
+                            });
+    CheckAttack<Mei, Kiana>("芽衣必杀技", kMei, kKiana, 2, {{Result::ALL_ALIVE, 1., kMei, {1.f, 85, 11, 24, 0, 0, 0}}});
+    CheckAttack<Mei, Kiana>("芽衣被麻痹", {1.f, 100, 12, 22, 1, 0, 0}, kKiana, 1, {{Result::ALL_ALIVE, 1., kMei, kKiana}});
+}
+
+static void
+TestBronya() {
+    // 普攻 10 点，之后以 0.25 的概率再追加 4 次 12 - 11 点
+    CheckAttack<Bronya, Kiana>("布洛妮娅普攻与天使重构", kBronya, kKiana, 1,
+                               {
+                                   {Result::ALL_ALIVE, 0.25, kBronya, {1.f, 86, 11, 24, 0, 0, 0}},
+                                   {Result::ALL_ALIVE, 0.75, kBronya, {1.f, 90, 11, 24, 0, 0, 0}},
+                               });
+
+    // 必杀技的伤害在 1 ~ 100 中均匀抽取，对方剩余 50 点血量，伤害不低于 50 时倒下
+    std::vector<GoldenBranch> ult;
+    for (int damage = 1; damage <= 100; ++damage) ult.push_back({damage >= 50 ? Result::DEFENDER_DEAD : Result::ALL_ALIVE, 0.01, kBronya, {1.f, 50 - damage, 11, 24, 0, 0, 0}});
+    CheckAttack<Bronya, Kiana>("布洛妮娅必杀技", kBronya, {1.f, 50, 11, 24, 0, 0, 0}, 3, ult);
+}
+
+static void
+TestHimeko() {
+    // 必杀技攻击翻倍、命中率降低 0.35，随后的普攻要做命中判定
+    CheckAttack<Himeko, Kiana>("姬子必杀技", kHimeko, kKiana, 2,
+                               {
+                                   {Result::ALL_ALIVE, 0.65, {0.65f, 100, 9, 46, 0, 0, 0}, {1.f, 65, 11, 24, 0, 0, 0}},
+                                   {Result::ALL_ALIVE, 0.35, {0.65f, 100, 9, 46, 0, 0, 0}, kKiana},
+                               });
+    CheckAttack<Himeko, Kiana>("姬子普攻", kHimeko, kKiana, 1, {{Result::ALL_ALIVE, 1., kHimeko, {1.f, 88, 11, 24, 0, 0, 0}}});
+}
+
+static void
+TestRita() {
+    CheckAttack<Rita, Kiana>("丽塔首次必杀技", kRita, {1.f, 50, 11, 24, 0, 0, 0}, 4, {{Result::ALL_ALIVE, 1., {1.f, 100, 11, 26, 0, 0, 1}, {1.f, 54, 11, 24, 0, 2, 0}}});
+    // 清理时自身本回合攻击 - 3，对方攻击永久 - 4
+    CheckAttack<Rita, Kiana>("丽塔普攻与清理", kRita, kKiana, 1,
+                             {
+                                 {Result::ALL_ALIVE, 0.35, kRita, {1.f, 88, 11, 20, 0, 0, 0}},
+                                 {Result::ALL_ALIVE, 0.65, kRita, {1.f, 85, 11, 24, 0, 0, 0}},
+                             });
+    // 释放过必杀技后受到的伤害乘以 0.4 并四舍五入：13 -> 5
+    CheckAttack<Kiana, Rita>("丽塔减伤", kKiana, {1.f, 100, 11, 26, 0, 0, 1}, 1, {{Result::ALL_ALIVE, 1., kKiana, {1.f, 95, 11, 26, 0, 0, 1}}});
+}
+
+static void
+TestSakura() {
+    CheckAttack<Sakura, Kiana>("八重樱饭团", {1.f, 60, 9, 20, 0, 0, 0}, kKiana, 1,
+                               {
+                                   {Result::ALL_ALIVE, 0.3, {1.f, 85, 9, 20, 0, 0, 0}, {1.f, 91, 11, 24, 0, 0, 0}},
+                                   {Result::ALL_ALIVE, 0.7, {1.f, 60, 9, 20, 0, 0, 0}, {1.f, 91, 11, 24, 0, 0, 0}},
+                               });
+    CheckAttack<Sakura, Kiana>("八重樱必杀技", {1.f, 60, 9, 20, 0, 0, 0}, kKiana, 2,
+                               {
+                                   {Result::ALL_ALIVE, 0.3, {1.f, 85, 9, 20, 0, 0, 0}, {1.f, 75, 11, 24, 0, 0, 0}},
+                                   {Result::ALL_ALIVE, 0.7, {1.f, 60, 9, 20, 0, 0, 0}, {1.f, 75, 11, 24, 0, 0, 0}},
+                               });
+}
+
+static void
+TestCorvus() {
+    // 对琪亚娜必定增伤 25%，不做判定：round(12 * 1.25) = 15
+    CheckAttack<Corvus, Kiana>("渡鸦对琪亚娜", kCorvus, kKiana, 1, {{Result::ALL_ALIVE, 1., kCorvus, {1.f, 85, 11, 24, 0, 0, 0}}});
+    // round(11 * 1.25) = 14
+    CheckAttack<Corvus, Mei>("渡鸦普攻", kCorvus, kMei, 1,
+                             {
+                                 {Result::ALL_ALIVE, 0.25, kCorvus, {1.f, 86, 12, 22, 0, 0, 0}},
+                                 {Result::ALL_ALIVE, 0.75, kCorvus, {1.f, 89, 12, 22, 0, 0, 0}},
+                             });
+    // 7 次 round(4 * 1.25) = 5 或 7 次 4
+    CheckAttack<Corvus, Mei>("渡鸦必杀技", kCorvus, kMei, 3,
+                             {
+                                 {Result::ALL_ALIVE, 0.25, kCorvus, {1.f, 65, 12, 22, 0, 0, 0}},
+                                 {Result::ALL_ALIVE, 0.75, kCorvus, {1.f, 72, 12, 22, 0, 0, 0}},
+                             });
+}
+
+static void
+TestTheresa() {
+    CheckAttack<Theresa, Kiana>("德莉莎普攻与破防", kTheresa, kKiana, 1,
+                                {
+                                    {Result::ALL_ALIVE, 0.3, kTheresa, {1.f, 92, 6, 24, 0, 0, 0}},
+                                    {Result::ALL_ALIVE, 0.7, kTheresa, {1.f, 92, 11, 24, 0, 0, 0}},
+                                });
+    CheckAttack<Theresa, Kiana>("德莉莎必杀技", kTheresa, kKiana, 3, {{Result::ALL_ALIVE, 1., kTheresa, {1.f, 75, 11, 24, 0, 0, 0}}});
+}
+
+static void
+TestOlenyeva() {
+    CheckAttack<Olenyeva, Kiana>("萝莎莉娅普攻", kOlenyeva, kKiana, 1, {{Result::ALL_ALIVE, 1., kOlenyeva, {1.f, 93, 11, 24, 0, 0, 0}}});
+    // 复活后的下一次出招先放必杀技：以 0.5 的概率造成 233 点，否则 50 点；必杀技的结果被忽略，之后照常普攻
+    CheckAttack<Olenyeva, Kiana>("萝莎莉娅必杀技", {1.f, 20, 10, 18, 0, 0, 2}, kKiana, 1,
+                                 {
+                                     {Result::DEFENDER_DEAD, 0.5, {1.f, 20, 10, 18, 0, 0, 0}, {1.f, -140, 11, 24, 0, 0, 0}},
+                                     {Result::ALL_ALIVE, 0.5, {1.f, 20, 10, 18, 0, 0, 0}, {1.f, 43, 11, 24, 0, 0, 0}},
+                                 });
+    // 血量降到 0 以下时以 20 点血量复活一次
+    CheckAttack<Kiana, Olenyeva>("萝莎莉娅复活", kKiana, {1.f, 10, 10, 18, 0, 0, 1}, 1, {{Result::ALL_ALIVE, 1., kKiana, {1.f, 20, 10, 18, 0, 0, 2}}});
+}
+
+static void
+TestSeele() {
+    // 白希转黑希：防御 - 5，攻击 + 10
+    CheckAttack<Seele, Kiana>("希儿转黑", kSeele, kKiana, 1, {{Result::ALL_ALIVE, 1., {1.f, 100, 8, 33, 0, 0, 1}, {1.f, 78, 11, 24, 0, 0, 0}}});
+
+    // 黑希转白希：回复 1 ~ 15 中均匀抽取的血量，至多 100
+    std::vector<GoldenBranch> white;
+    for (int heal = 1; heal <= 15; ++heal) white.push_back({Result::ALL_ALIVE, 1. / 15., {1.f, std::min(100, 90 + heal), 13, 23, 0, 0, 0}, {1.f, 88, 11, 24, 0, 0, 0}});
+    CheckAttack<Seele, Kiana>("希儿转白", {1.f, 90, 8, 33, 0, 0, 1}, kKiana, 1, white);
+}
+
+static void
+TestDurandal() {
+    // 每次出招攻击 + 3
+    CheckAttack<Durandal, Kiana>("幽兰黛尔普攻", kDurandal, kKiana, 1, {{Result::ALL_ALIVE, 1., {1.f, 100, 10, 22, 0, 0, 0}, {1.f, 89, 11, 24, 0, 0, 0}}});
+    // 受到必杀技时以 0.16 的概率反弹 30 点且自身不受伤；之后才是琪亚娜的眩晕判定
+    CheckAttack<Kiana, Durandal>("幽兰黛尔反弹", kKiana, kDurandal, 2,
+                                 {
+                                     {Result::ALL_ALIVE, 0.16 * 0.35, {1.f, 70, 11, 24, 0, 0, 1}, kDurandal},
+                                     {Result::ALL_ALIVE, 0.16 * 0.65, {1.f, 70, 11, 24, 0, 0, 0}, kDurandal},
+                                     {Result::ALL_ALIVE, 0.84 * 0.35, {1.f, 100, 11, 24, 0, 0, 1}, {1.f, 66, 10, 19, 0, 0, 0}},
+                                     {Result::ALL_ALIVE, 0.84 * 0.65, kKiana, {1.f, 66, 10, 19, 0, 0, 0}},
+                                 });
+}
+
+static void
+TestFuHua() {
+    // 必杀技 18 点并使对方命中率降低 0.25
+    CheckAttack<FuHua, Kiana>("符华必杀技", kFuHua, kKiana, 3, {{Result::ALL_ALIVE, 1., kFuHua, {0.75f, 82, 11, 24, 0, 0, 0}}});
+    // 普攻无视防御
+    CheckAttack<FuHua, Kiana>("符华普攻", kFuHua, kKiana, 1, {{Result::ALL_ALIVE, 1., kFuHua, {1.f, 83, 11, 24, 0, 0, 0}}});
+}
+
+// 丽塔的减伤倍率与萝莎莉娅&莉莉娅复活后的血量取自数值表，可以经由 --patch 修改
+static void
+TestPatchedParams() {
+    CharacterTable table = GetCharacterTable();
+    for (const char* patch : {"RITA.damage_taken=0.5", "OLENYEVA.revive_hit=35"}) {
+        if (!ApplyParamPatch(patch, table)) ++g_failures;
+    }
+    SetCharacterTable(table);
+
+    // round(13 * 0.5) = 7
+    CheckAttack<Kiana, Rita>("丽塔减伤（改动后）", kKiana, {1.f, 100, 11, 26, 0, 0, 1}, 1, {{Result::ALL_ALIVE, 1., kKiana, {1.f, 93, 11, 26, 0, 0, 1}}});
+    CheckAttack<Kiana, Olenyeva>("萝莎莉娅复活（改动后）", kKiana, {1.f, 10, 10, 18, 0, 0, 1}, 1, {{Result::ALL_ALIVE, 1., kKiana, {1.f, 35, 10, 18, 0, 0, 2}}});
+
+    SetCharacterTable(kDefaultCharacterTable);
+
+    // 超出范围或不使用该项的角色不接受改动
+    for (const char* patch : {"RITA.damage_taken=1.5", "OLENYEVA.revive_hit=0", "KIANA.revive_hit=20"}) {
+        ++g_cases;
+        if (ApplyParamPatch(patch, table)) {
+            fprintf(stderr, "%s 应当被拒绝\n", patch);
+            ++g_failures;
+        }
+    }
+}
+
+int
+main() {
+    TestKiana();
+    TestMei();
+    TestBronya();
+    TestHimeko();
+    TestRita();
+    TestSakura();
+    TestCorvus();
+    TestTheresa();
+    TestOlenyeva();
+    TestSeele();
+    TestDurandal();
+    TestFuHua();
+    TestPatchedParams();
+
+    printf("黄金测试: %d 项，失败 %d 项\n", g_cases, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
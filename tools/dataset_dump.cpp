@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+#include "dataset.h"
+#include "player.h"
+
+namespace {
+
+int
+PrintUsage(const char* program) {
+    fprintf(stderr, "用法: %s <数据集文件> [--matchup <c0> <c1> [--rows <行数>]]\n", program);
+    fprintf(stderr, "不指定对局时输出列定义与各对局的汇总；指定时以 CSV 输出该对局的前若干行，角色按编号 0 ~ %d 指定\n", kNumOfCharacter - 1);
+    return 1;
+}
+
+const char*
+ColumnTypeName(const ColumnType type) {
+    // clang-format off
+    switch (type) {
+    case ColumnType::U8:  return "u8";
+    case ColumnType::I8:  return "i8";
+    case ColumnType::U16: return "u16";
+    case ColumnType::I16: return "i16";
+    default: return "?";
+    }
+    // clang-format on
+}
+
+// 按列的类型读出第 row 行，统一转为 int
+int
+ReadValue(const BattleDataset& dataset, const DatasetColumn& column, const uint64_t row) {
+    // clang-format off
+    switch (column.type) {
+    case ColumnType::U8:  return dataset.Column<uint8_t>(column.name)[row];
+    case ColumnType::I8:  return dataset.Column<int8_t>(column.name)[row];
+    case ColumnType::U16: return dataset.Column<uint16_t>(column.name)[row];
+    case ColumnType::I16: return dataset.Column<int16_t>(column.name)[row];
+    default: return 0;
+    }
+    // clang-format on
+}
+
+}  // namespace
+
+int
+main(int argc, char* argv[]) {
+    if (argc < 2) return PrintUsage(argv[0]);
+
+    int c0        = -1;
+    int c1        = -1;
+    uint64_t rows = 20;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--matchup" && i + 2 < argc) {
+            c0 = std::atoi(argv[++i]);
+            c1 = std::atoi(argv[++i]);
+            if (c0 < 0 || c0 >= kNumOfCharacter || c1 < 0 || c1 >= kNumOfCharacter) return PrintUsage(argv[0]);
+        } else if (arg == "--rows" && i + 1 < argc) {
+            rows = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            return PrintUsage(argv[0]);
+        }
+    }
+
+    BattleDataset dataset;
+    if (!dataset.Open(argv[1])) return 1;
+
+    const DatasetHeader& header = dataset.Header();
+
+    // 指定对局时以 CSV 输出该对局的行，第一列为试验序号
+    if (c0 >= 0) {
+        for (uint32_t s = 0; s < header.num_segments; ++s) {
+            const DatasetSegment& segment = dataset.Segments()[s];
+            if (segment.c0 != c0 || segment.c1 != c1) continue;
+
+            printf("trial");
+            for (uint32_t c = 0; c < header.num_columns; ++c) printf(",%s", dataset.Columns()[c].name);
+            printf("\n");
+
+            for (uint64_t r = 0; r < std::min(rows, segment.rows); ++r) {
+                printf("%llu", static_cast<unsigned long long>(segment.begin + r));
+                for (uint32_t c = 0; c < header.num_columns; ++c) printf(",%d", ReadValue(dataset, dataset.Columns()[c], segment.first_row + r));
+                printf("\n");
+            }
+            return 0;
+        }
+        fprintf(stderr, "数据集中没有所选对局\n");
+        return 1;
+    }
+
+    printf("随机种子: %llu  回合上限 %d  共 %llu 行\n", static_cast<unsigned long long>(header.seed), header.max_rounds, static_cast<unsigned long long>(header.rows));
+    for (uint32_t c = 0; c < header.num_columns; ++c) {
+        const DatasetColumn& column = dataset.Columns()[c];
+        printf("  列 %-12s %-4s 偏移 %llu\n", column.name, ColumnTypeName(column.type), static_cast<unsigned long long>(column.offset));
+    }
+
+    // 汇总只用到固定的几列，事件计数列不存在时不输出
+    const int8_t* winner   = dataset.Column<int8_t>("winner");
+    const uint16_t* rounds = dataset.Column<uint16_t>("rounds");
+    const uint16_t* ult_0  = dataset.Column<uint16_t>("ult_0");
+    const uint16_t* ult_1  = dataset.Column<uint16_t>("ult_1");
+    if (winner == nullptr || rounds == nullptr) {
+        fprintf(stderr, "数据集缺少 winner / rounds 列\n");
+        return 1;
+    }
+
+    printf("对局                          行数    p0 胜率     平局   平均回合");
+    if (ult_0 != nullptr && ult_1 != nullptr) printf("  p0 必杀  p1 必杀");
+    printf("\n");
+    for (uint32_t s = 0; s < header.num_segments; ++s) {
+        const DatasetSegment& segment = dataset.Segments()[s];
+        if (segment.rows == 0) continue;
+
+        uint64_t p0_win       = 0;
+        uint64_t draw         = 0;
+        uint64_t total_rounds = 0;
+        uint64_t total_ult[2] = {};
+        for (uint64_t r = segment.first_row; r < segment.first_row + segment.rows; ++r) {
+            p0_win += winner[r] == 0 ? 1 : 0;
+            draw += winner[r] < 0 ? 1 : 0;
+            total_rounds += rounds[r];
+            if (ult_0 != nullptr && ult_1 != nullptr) {
+                total_ult[0] += ult_0[r];
+                total_ult[1] += ult_1[r];
+            }
+        }
+
+        const auto n = static_cast<double>(segment.rows);
+        printf("%-10s vs %-10s %12llu %9.3f%% %7.3f%% %10.2f", GetPlayer(static_cast<Character>(segment.c0))->name, GetPlayer(static_cast<Character>(segment.c1))->name, static_cast<unsigned long long>(segment.rows), static_cast<double>(p0_win) / n * 100.,
+               static_cast<double>(draw) / n * 100., static_cast<double>(total_rounds) / n);
+        if (ult_0 != nullptr && ult_1 != nullptr) printf(" %8.2f %8.2f", static_cast<double>(total_ult[0]) / n, static_cast<double>(total_ult[1]) / n);
+        printf("\n");
+    }
+    return 0;
+}
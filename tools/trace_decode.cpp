@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "player.h"
+#include "trace.h"
+
+namespace {
+
+struct MatchupSummary {
+    uint64_t records = 0;
+    uint64_t trials  = 0;  // 出现过的最大试验序号 + 1
+};
+
+int
+PrintUsage(const char* program) {
+    fprintf(stderr, "用法: %s <trace 文件> [--matchup <c0> <c1>] [--trial <试验序号>]\n", program);
+    fprintf(stderr, "不指定对局时输出各对局的记录数；角色按编号 0 ~ %d 指定\n", kNumOfCharacter - 1);
+    return 1;
+}
+
+}  // namespace
+
+int
+main(int argc, char* argv[]) {
+    if (argc < 2) return PrintUsage(argv[0]);
+
+    int64_t matchup = -1;
+    int64_t trial   = -1;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--matchup" && i + 2 < argc) {
+            const int c0 = std::atoi(argv[++i]);
+            const int c1 = std::atoi(argv[++i]);
+            if (c0 < 0 || c0 >= kNumOfCharacter || c1 < 0 || c1 >= kNumOfCharacter) return PrintUsage(argv[0]);
+            matchup = c0 * kNumOfCharacter + c1;
+        } else if (arg == "--trial" && i + 1 < argc) {
+            trial = static_cast<int64_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            return PrintUsage(argv[0]);
+        }
+    }
+    if (trial >= 0 && matchup < 0) {
+        fprintf(stderr, "--trial 需要同时指定 --matchup\n");
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (in == nullptr) {
+        fprintf(stderr, "无法打开 trace 文件: %s\n", argv[1]);
+        return 1;
+    }
+
+    TraceHeader header{};
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0) {
+        fprintf(stderr, "不是 trace 文件: %s\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+    if (header.version != kTraceVersion || header.record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "不支持的 trace 版本 %u（记录大小 %u）\n", header.version, header.record_size);
+        fclose(in);
+        return 1;
+    }
+
+    printf("随机种子: %llu\n", static_cast<unsigned long long>(header.seed));
+
+    // 各线程的缓冲区整块交错写入，同一场试验的记录在文件中保持先后顺序，但可能被其他线程的块隔开
+    std::vector<TraceRecord> chunk(1 << 16);
+    std::vector<TraceRecord> selected;
+    MatchupSummary summary[kNumOfCharacter * kNumOfCharacter];
+
+    std::size_t count = 0;
+    while ((count = fread(chunk.data(), sizeof(TraceRecord), chunk.size(), in)) > 0) {
+        for (std::size_t r = 0; r < count; ++r) {
+            const TraceRecord& record = chunk[r];
+            const auto record_matchup = static_cast<int64_t>(record.trial >> kTraceTrialBits);
+            const auto record_trial   = static_cast<int64_t>(record.trial & kTraceTrialMask);
+            if (record_matchup >= kNumOfCharacter * kNumOfCharacter) continue;
+
+            if (matchup < 0) {
+                MatchupSummary& s = summary[record_matchup];
+                ++s.records;
+                s.trials = std::max(s.trials, static_cast<uint64_t>(record_trial) + 1);
+            } else if (record_matchup == matchup && (trial < 0 || record_trial == trial)) {
+                selected.push_back(record);
+            }
+        }
+    }
+    fclose(in);
+
+    if (matchup < 0) {
+        printf("对局                      记录数    试验次数\n");
+        for (int m = 0; m < kNumOfCharacter * kNumOfCharacter; ++m) {
+            if (summary[m].records == 0) continue;
+            printf("%-10s vs %-10s %12llu %10llu\n", GetPlayer(static_cast<Character>(m / kNumOfCharacter))->name, GetPlayer(static_cast<Character>(m % kNumOfCharacter))->name, static_cast<unsigned long long>(summary[m].records),
+                   static_cast<unsigned long long>(summary[m].trials));
+        }
+        return 0;
+    }
+
+    if (selected.empty()) {
+        fprintf(stderr, "trace 中没有所选试验的记录\n");
+        return 1;
+    }
+
+    // 稳定排序保持同一试验内的先后顺序
+    std::stable_sort(selected.begin(), selected.end(), [](const TraceRecord& a, const TraceRecord& b) { return a.trial < b.trial; });
+
+    uint64_t current = ~uint64_t{0};
+    for (const auto& record : selected) {
+        if (record.trial != current) {
+            current = record.trial;
+            printf("==== 试验 %llu ====\n", static_cast<unsigned long long>(record.trial & kTraceTrialMask));
+        }
+        PrintTraceRecord(stdout, record);
+    }
+    return 0;
+}